@@ -0,0 +1,367 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Copyright (c) Ryan Alasandro
+//
+// Static Library: Core Engine
+//
+// File: Physics/CAABBTree.cpp
+//
+//-------------------------------------------------------------------------------------------------
+
+#include "CAABBTree.h"
+#include <minmax.h>
+
+namespace Physics
+{
+	CAABBTree::CAABBTree() :
+		m_root(NULL_NODE),
+		m_freeList(NULL_NODE)
+	{
+	}
+
+	CAABBTree::~CAABBTree() { }
+
+	// Method for inserting a proxy. The stored AABB is padded by the margin so small moves don't touch the tree.
+	u32 CAABBTree::CreateProxy(const AABB& aabb, void* pUserData)
+	{
+		const u32 proxy = AllocateNode();
+
+		Node& node = m_nodeList[proxy];
+		node.aabb.mn = aabb.mn - m_data.margin;
+		node.aabb.mx = aabb.mx + m_data.margin;
+		node.pUserData = pUserData;
+		node.height = 0;
+
+		InsertLeaf(proxy);
+		return proxy;
+	}
+
+	void CAABBTree::DestroyProxy(u32 proxy)
+	{
+		RemoveLeaf(proxy);
+		FreeNode(proxy);
+	}
+
+	// Method for updating a proxy's bounds. The proxy is only reinserted once its tight AABB leaves the fat one,
+	//  and the new fat AABB is stretched in the direction of travel. Returns true if the tree changed.
+	bool CAABBTree::MoveProxy(u32 proxy, const AABB& aabb, const Math::Vector3& displacement)
+	{
+		if(m_nodeList[proxy].aabb.Contains(aabb)) { return false; }
+
+		RemoveLeaf(proxy);
+
+		AABB fat;
+		fat.mn = aabb.mn - m_data.margin;
+		fat.mx = aabb.mx + m_data.margin;
+
+		for(int i = 0; i < 3; ++i)
+		{
+			const float d = displacement[i] * m_data.displacementScale;
+			if(d < 0.0f) { fat.mn[i] += d; }
+			else { fat.mx[i] += d; }
+		}
+
+		m_nodeList[proxy].aabb = fat;
+
+		InsertLeaf(proxy);
+		return true;
+	}
+
+	void CAABBTree::Clear()
+	{
+		m_nodeList.clear();
+		m_root = m_freeList = NULL_NODE;
+	}
+
+	// Method for copying another tree's nodes and settings, reusing this tree's node storage.
+	void CAABBTree::CopyFrom(const CAABBTree& tree)
+	{
+		m_data = tree.m_data;
+		m_root = tree.m_root;
+		m_freeList = tree.m_freeList;
+		m_nodeList.assign(tree.m_nodeList.begin(), tree.m_nodeList.end());
+	}
+
+	// Method for loading up to four rays into a packet. Unused lanes are masked off.
+	void CAABBTree::LoadRayPacket(const Math::CSIMDRay* pRayList, u32 count, RayPacket& packet)
+	{
+		alignas(16) float data[7][4] { };
+
+		for(u32 lane = 0; lane < count; ++lane)
+		{
+			const Math::CSIMDRay& ray = pRayList[lane];
+			for(u32 a = 0; a < 3; ++a)
+			{
+				data[a][lane] = ray.GetOrigin()[a];
+				data[3 + a][lane] = 1.0f / ray.GetDirection()[a];
+			}
+
+			data[6][lane] = ray.GetDistance();
+		}
+
+		packet.originX = _mm_load_ps(data[0]);
+		packet.originY = _mm_load_ps(data[1]);
+		packet.originZ = _mm_load_ps(data[2]);
+		packet.invDirX = _mm_load_ps(data[3]);
+		packet.invDirY = _mm_load_ps(data[4]);
+		packet.invDirZ = _mm_load_ps(data[5]);
+		packet.tMax = _mm_load_ps(data[6]);
+		packet.activeMask = (1U << count) - 1;
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// Node methods.
+	//-----------------------------------------------------------------------------------------------
+
+	u32 CAABBTree::AllocateNode()
+	{
+		u32 index;
+		if(m_freeList != NULL_NODE)
+		{
+			index = m_freeList;
+			m_freeList = m_nodeList[index].parent;
+		}
+		else
+		{
+			index = static_cast<u32>(m_nodeList.size());
+			m_nodeList.push_back({ });
+		}
+
+		Node& node = m_nodeList[index];
+		node.pUserData = nullptr;
+		node.parent = node.child1 = node.child2 = NULL_NODE;
+		node.height = 0;
+
+		return index;
+	}
+
+	void CAABBTree::FreeNode(u32 node)
+	{
+		m_nodeList[node].parent = m_freeList;
+		m_nodeList[node].height = -1;
+		m_freeList = node;
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// Tree methods.
+	//-----------------------------------------------------------------------------------------------
+
+	// Method for inserting a leaf next to the sibling that grows the tree's surface area the least.
+	void CAABBTree::InsertLeaf(u32 leaf)
+	{
+		if(m_root == NULL_NODE)
+		{
+			m_root = leaf;
+			m_nodeList[leaf].parent = NULL_NODE;
+			return;
+		}
+
+		const AABB leafAABB = m_nodeList[leaf].aabb;
+
+		u32 index = m_root;
+		while(!m_nodeList[index].IsLeaf())
+		{
+			const Node& node = m_nodeList[index];
+
+			const float cost = node.aabb.Cost();
+			const float combinedCost = AABB::Union(node.aabb, leafAABB).Cost();
+
+			// Cost of pairing with this node, and the cost every descendant pays for the growth.
+			const float pairCost = 2.0f * combinedCost;
+			const float inheritanceCost = 2.0f * (combinedCost - cost);
+
+			float childCost[2];
+			const u32 childList[2] = { node.child1, node.child2 };
+			for(int i = 0; i < 2; ++i)
+			{
+				const Node& child = m_nodeList[childList[i]];
+				const float unionCost = AABB::Union(leafAABB, child.aabb).Cost();
+				childCost[i] = (child.IsLeaf() ? unionCost : unionCost - child.aabb.Cost()) + inheritanceCost;
+			}
+
+			if(pairCost < childCost[0] && pairCost < childCost[1]) { break; }
+
+			index = childCost[0] < childCost[1] ? childList[0] : childList[1];
+		}
+
+		const u32 sibling = index;
+		const u32 oldParent = m_nodeList[sibling].parent;
+		const u32 newParent = AllocateNode();
+
+		Node& parent = m_nodeList[newParent];
+		parent.parent = oldParent;
+		parent.aabb = AABB::Union(leafAABB, m_nodeList[sibling].aabb);
+		parent.height = m_nodeList[sibling].height + 1;
+		parent.child1 = sibling;
+		parent.child2 = leaf;
+
+		if(oldParent != NULL_NODE)
+		{
+			if(m_nodeList[oldParent].child1 == sibling) { m_nodeList[oldParent].child1 = newParent; }
+			else { m_nodeList[oldParent].child2 = newParent; }
+		}
+		else
+		{
+			m_root = newParent;
+		}
+
+		m_nodeList[sibling].parent = newParent;
+		m_nodeList[leaf].parent = newParent;
+
+		Refit(m_nodeList[leaf].parent);
+	}
+
+	void CAABBTree::RemoveLeaf(u32 leaf)
+	{
+		if(leaf == m_root)
+		{
+			m_root = NULL_NODE;
+			return;
+		}
+
+		const u32 parent = m_nodeList[leaf].parent;
+		const u32 grandParent = m_nodeList[parent].parent;
+		const u32 sibling = m_nodeList[parent].child1 == leaf ? m_nodeList[parent].child2 : m_nodeList[parent].child1;
+
+		if(grandParent != NULL_NODE)
+		{ // Splice the sibling into the parent's place.
+			if(m_nodeList[grandParent].child1 == parent) { m_nodeList[grandParent].child1 = sibling; }
+			else { m_nodeList[grandParent].child2 = sibling; }
+
+			m_nodeList[sibling].parent = grandParent;
+			FreeNode(parent);
+
+			Refit(grandParent);
+		}
+		else
+		{
+			m_root = sibling;
+			m_nodeList[sibling].parent = NULL_NODE;
+			FreeNode(parent);
+		}
+	}
+
+	// Method for walking up from a node, rebalancing and refitting every ancestor.
+	void CAABBTree::Refit(u32 index)
+	{
+		while(index != NULL_NODE)
+		{
+			index = Balance(index);
+
+			Node& node = m_nodeList[index];
+			const Node& child1 = m_nodeList[node.child1];
+			const Node& child2 = m_nodeList[node.child2];
+
+			node.height = 1 + max(child1.height, child2.height);
+			node.aabb = AABB::Union(child1.aabb, child2.aabb);
+
+			index = node.parent;
+		}
+	}
+
+	// Method for rotating the taller child of A up when the subtree heights differ by more than one. Returns the new subtree root.
+	u32 CAABBTree::Balance(u32 iA)
+	{
+		Node& A = m_nodeList[iA];
+		if(A.IsLeaf() || A.height < 2) { return iA; }
+
+		const u32 iB = A.child1;
+		const u32 iC = A.child2;
+		Node& B = m_nodeList[iB];
+		Node& C = m_nodeList[iC];
+
+		const s32 balance = C.height - B.height;
+
+		if(balance > 1)
+		{ // Rotate C up.
+			const u32 iF = C.child1;
+			const u32 iG = C.child2;
+			Node& F = m_nodeList[iF];
+			Node& G = m_nodeList[iG];
+
+			C.child1 = iA;
+			C.parent = A.parent;
+			A.parent = iC;
+
+			if(C.parent != NULL_NODE)
+			{
+				if(m_nodeList[C.parent].child1 == iA) { m_nodeList[C.parent].child1 = iC; }
+				else { m_nodeList[C.parent].child2 = iC; }
+			}
+			else
+			{
+				m_root = iC;
+			}
+
+			if(F.height > G.height)
+			{
+				C.child2 = iF;
+				A.child2 = iG;
+				G.parent = iA;
+				A.aabb = AABB::Union(B.aabb, G.aabb);
+				C.aabb = AABB::Union(A.aabb, F.aabb);
+				A.height = 1 + max(B.height, G.height);
+				C.height = 1 + max(A.height, F.height);
+			}
+			else
+			{
+				C.child2 = iG;
+				A.child2 = iF;
+				F.parent = iA;
+				A.aabb = AABB::Union(B.aabb, F.aabb);
+				C.aabb = AABB::Union(A.aabb, G.aabb);
+				A.height = 1 + max(B.height, F.height);
+				C.height = 1 + max(A.height, G.height);
+			}
+
+			return iC;
+		}
+
+		if(balance < -1)
+		{ // Rotate B up.
+			const u32 iD = B.child1;
+			const u32 iE = B.child2;
+			Node& D = m_nodeList[iD];
+			Node& E = m_nodeList[iE];
+
+			B.child1 = iA;
+			B.parent = A.parent;
+			A.parent = iB;
+
+			if(B.parent != NULL_NODE)
+			{
+				if(m_nodeList[B.parent].child1 == iA) { m_nodeList[B.parent].child1 = iB; }
+				else { m_nodeList[B.parent].child2 = iB; }
+			}
+			else
+			{
+				m_root = iB;
+			}
+
+			if(D.height > E.height)
+			{
+				B.child2 = iD;
+				A.child1 = iE;
+				E.parent = iA;
+				A.aabb = AABB::Union(C.aabb, E.aabb);
+				B.aabb = AABB::Union(A.aabb, D.aabb);
+				A.height = 1 + max(C.height, E.height);
+				B.height = 1 + max(A.height, D.height);
+			}
+			else
+			{
+				B.child2 = iE;
+				A.child1 = iD;
+				D.parent = iA;
+				A.aabb = AABB::Union(C.aabb, D.aabb);
+				B.aabb = AABB::Union(A.aabb, E.aabb);
+				A.height = 1 + max(C.height, D.height);
+				B.height = 1 + max(A.height, E.height);
+			}
+
+			return iB;
+		}
+
+		return iA;
+	}
+};
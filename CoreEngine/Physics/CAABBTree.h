@@ -0,0 +1,268 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Copyright (c) Ryan Alasandro
+//
+// Static Library: Core Engine
+//
+// File: Physics/CAABBTree.h
+//
+//-------------------------------------------------------------------------------------------------
+
+#ifndef CAABBTREE_H
+#define CAABBTREE_H
+
+#include "../Globals/CGlobals.h"
+#include "../Math/CMathVector3.h"
+#include "../Math/CSIMDRay.h"
+#include <cassert>
+#include <vector>
+
+namespace Physics
+{
+	class CAABBTree
+	{
+	public:
+		static const u32 NULL_NODE = ~0U;
+
+		struct AABB
+		{
+			Math::Vector3 mn;
+			Math::Vector3 mx;
+
+			inline bool Overlaps(const AABB& aabb) const
+			{
+				return mn.x <= aabb.mx.x && mx.x >= aabb.mn.x &&
+					mn.y <= aabb.mx.y && mx.y >= aabb.mn.y &&
+					mn.z <= aabb.mx.z && mx.z >= aabb.mn.z;
+			}
+
+			inline bool Contains(const AABB& aabb) const
+			{
+				return mn.x <= aabb.mn.x && mn.y <= aabb.mn.y && mn.z <= aabb.mn.z &&
+					mx.x >= aabb.mx.x && mx.y >= aabb.mx.y && mx.z >= aabb.mx.z;
+			}
+
+			// Half the surface area, used as the insertion cost.
+			inline float Cost() const
+			{
+				const Math::Vector3 d = mx - mn;
+				return d.x * d.y + d.y * d.z + d.z * d.x;
+			}
+
+			static inline AABB Union(const AABB& a, const AABB& b)
+			{
+				AABB res;
+				for(int i = 0; i < 3; ++i)
+				{
+					res.mn[i] = a.mn[i] < b.mn[i] ? a.mn[i] : b.mn[i];
+					res.mx[i] = a.mx[i] > b.mx[i] ? a.mx[i] : b.mx[i];
+				}
+
+				return res;
+			}
+
+			// Method for growing a box to cover everything it passes through along the displacement.
+			static inline AABB Swept(const AABB& aabb, const Math::Vector3& displacement)
+			{
+				AABB res = aabb;
+				for(int i = 0; i < 3; ++i)
+				{
+					if(displacement[i] < 0.0f) { res.mn[i] += displacement[i]; }
+					else { res.mx[i] += displacement[i]; }
+				}
+
+				return res;
+			}
+		};
+
+		// Four rays in SoA form for packet traversal. Lanes outside the active mask are ignored,
+		//  and callers shrink tMax as hits are found so farther nodes get culled.
+		struct RayPacket
+		{
+			vf32 originX;
+			vf32 originY;
+			vf32 originZ;
+			vf32 invDirX;
+			vf32 invDirY;
+			vf32 invDirZ;
+			vf32 tMax;
+			u32 activeMask;
+		};
+
+		struct Data
+		{
+			// Padding around every fat AABB, and how many steps of displacement a moving proxy is grown by.
+			float margin = 0.25f;
+			float displacementScale = 2.0f;
+		};
+
+	private:
+		// Deep enough for any balanced tree. Deeper trees spill onto the heap rather than skip nodes.
+		static const u32 QUERY_STACK_SIZE = 64;
+
+		struct Node
+		{
+			AABB aabb;
+			void* pUserData;
+
+			// Parent of an allocated node, or the next free node.
+			u32 parent;
+			u32 child1;
+			u32 child2;
+
+			// Leaves are at height 0 and free nodes at -1.
+			s32 height;
+
+			inline bool IsLeaf() const { return child1 == NULL_NODE; }
+		};
+
+	public:
+		CAABBTree();
+		~CAABBTree();
+		CAABBTree(const CAABBTree&) = delete;
+		CAABBTree(CAABBTree&&) = delete;
+		CAABBTree& operator = (const CAABBTree&) = delete;
+		CAABBTree& operator = (CAABBTree&&) = delete;
+
+		u32 CreateProxy(const AABB& aabb, void* pUserData);
+		void DestroyProxy(u32 proxy);
+		bool MoveProxy(u32 proxy, const AABB& aabb, const Math::Vector3& displacement);
+		void Clear();
+		void CopyFrom(const CAABBTree& tree);
+
+		static void LoadRayPacket(const Math::CSIMDRay* pRayList, u32 count, RayPacket& packet);
+
+		// Method for replacing the user data of every proxy with whatever the callback returns for it.
+		template<typename T>
+		void RemapUserData(T callback)
+		{
+			for(Node& node : m_nodeList)
+			{
+				if(node.height == 0) { node.pUserData = callback(node.pUserData); }
+			}
+		}
+
+		// Method for visiting every proxy whose fat AABB overlaps the given one. Returning false from the callback stops the query.
+		template<typename T>
+		void Query(const AABB& aabb, T callback) const
+		{
+			u32 stack[QUERY_STACK_SIZE];
+			u32 count = 0;
+			std::vector<u32> overflowList;
+
+			if(m_root != NULL_NODE) { stack[count++] = m_root; }
+
+			while(count || !overflowList.empty())
+			{
+				u32 index;
+				if(!overflowList.empty()) { index = overflowList.back(); overflowList.pop_back(); }
+				else { index = stack[--count]; }
+
+				const Node& node = m_nodeList[index];
+				if(!node.aabb.Overlaps(aabb)) { continue; }
+
+				if(node.IsLeaf())
+				{
+					if(!callback(node.pUserData)) { return; }
+				}
+				else if(count + 2 <= QUERY_STACK_SIZE)
+				{
+					stack[count++] = node.child1;
+					stack[count++] = node.child2;
+				}
+				else
+				{ // Only a badly unbalanced tree gets this deep.
+					assert(count + 2 <= QUERY_STACK_SIZE);
+					overflowList.push_back(node.child1);
+					overflowList.push_back(node.child2);
+				}
+			}
+		}
+
+		// Method for visiting every proxy that at least one ray of the packet passes through. The callback receives the mask of lanes that hit.
+		template<typename T>
+		void QueryRays(RayPacket& packet, T callback) const
+		{
+			u32 stack[QUERY_STACK_SIZE];
+			u32 count = 0;
+			std::vector<u32> overflowList;
+
+			if(m_root != NULL_NODE) { stack[count++] = m_root; }
+
+			while(count || !overflowList.empty())
+			{
+				u32 index;
+				if(!overflowList.empty()) { index = overflowList.back(); overflowList.pop_back(); }
+				else { index = stack[--count]; }
+
+				const Node& node = m_nodeList[index];
+
+				const u32 mask = RayMask(node.aabb, packet);
+				if(mask == 0) { continue; }
+
+				if(node.IsLeaf())
+				{
+					callback(node.pUserData, mask);
+				}
+				else if(count + 2 <= QUERY_STACK_SIZE)
+				{
+					stack[count++] = node.child1;
+					stack[count++] = node.child2;
+				}
+				else
+				{ // Only a badly unbalanced tree gets this deep.
+					assert(count + 2 <= QUERY_STACK_SIZE);
+					overflowList.push_back(node.child1);
+					overflowList.push_back(node.child2);
+				}
+			}
+		}
+
+		// Accessors.
+		inline const AABB& GetFatAABB(u32 proxy) const { return m_nodeList[proxy].aabb; }
+		inline void* GetUserData(u32 proxy) const { return m_nodeList[proxy].pUserData; }
+		inline u32 GetHeight() const { return m_root == NULL_NODE ? 0 : static_cast<u32>(m_nodeList[m_root].height); }
+
+		// Modifiers.
+		inline void SetData(const Data& data) { m_data = data; }
+
+	private:
+		// Slab test of one box against all four rays at once.
+		static inline u32 RayMask(const AABB& aabb, const RayPacket& packet)
+		{
+			const vf32 t0x = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(aabb.mn.x), packet.originX), packet.invDirX);
+			const vf32 t1x = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(aabb.mx.x), packet.originX), packet.invDirX);
+			const vf32 t0y = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(aabb.mn.y), packet.originY), packet.invDirY);
+			const vf32 t1y = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(aabb.mx.y), packet.originY), packet.invDirY);
+			const vf32 t0z = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(aabb.mn.z), packet.originZ), packet.invDirZ);
+			const vf32 t1z = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(aabb.mx.z), packet.originZ), packet.invDirZ);
+
+			vf32 tEnter = _mm_max_ps(_mm_min_ps(t0x, t1x), _mm_setzero_ps());
+			tEnter = _mm_max_ps(tEnter, _mm_min_ps(t0y, t1y));
+			tEnter = _mm_max_ps(tEnter, _mm_min_ps(t0z, t1z));
+
+			vf32 tExit = _mm_min_ps(_mm_max_ps(t0x, t1x), packet.tMax);
+			tExit = _mm_min_ps(tExit, _mm_max_ps(t0y, t1y));
+			tExit = _mm_min_ps(tExit, _mm_max_ps(t0z, t1z));
+
+			return static_cast<u32>(_mm_movemask_ps(_mm_cmple_ps(tEnter, tExit))) & packet.activeMask;
+		}
+
+		u32 AllocateNode();
+		void FreeNode(u32 node);
+
+		void InsertLeaf(u32 leaf);
+		void RemoveLeaf(u32 leaf);
+		u32 Balance(u32 index);
+		void Refit(u32 index);
+
+	private:
+		Data m_data;
+
+		u32 m_root;
+		u32 m_freeList;
+		std::vector<Node> m_nodeList;
+	};
+};
+
+#endif
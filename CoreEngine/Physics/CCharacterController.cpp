@@ -0,0 +1,261 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Copyright (c) Ryan Alasandro
+//
+// Static Library: Core Engine
+//
+// File: Physics/CCharacterController.cpp
+//
+//-------------------------------------------------------------------------------------------------
+
+#include "CCharacterController.h"
+#include "CPhysics.h"
+#include "CVolume.h"
+#include "../Utilities/CTimer.h"
+#include <Windows.h>
+
+namespace Physics
+{
+	static const u32 SLIDE_ITERATIONS = 3;
+
+	CCharacterController::CCharacterController(const CVObject* pObject) :
+		CVComponent(pObject),
+		m_shape(nullptr),
+		m_position(Math::SIMD_VEC_ZERO),
+		m_velocity(Math::SIMD_VEC_ZERO),
+		m_fallSpeed(0.0f),
+		m_ground { false, -1, nullptr, Math::SIMD_VEC_ZERO },
+		m_bTeleport(false),
+		m_teleportPosition(Math::SIMD_VEC_ZERO),
+		m_lastPosition(Math::SIMD_VEC_ZERO),
+		m_nextPosition(Math::SIMD_VEC_ZERO),
+		m_stepDelta(0.0f),
+		m_step(0),
+		m_interpStep(0),
+		m_interpT(0.0f) { }
+
+	CCharacterController::~CCharacterController() { }
+
+	void CCharacterController::SetData(const Data& data)
+	{
+		m_data = data;
+
+		CVolumeCapsule::Data shapeData { };
+		shapeData.radius = m_data.radius;
+		shapeData.height = m_data.height;
+		shapeData.offset = m_data.offset;
+		shapeData.colliderType = ColliderType::Collider;
+		m_shape.SetData(shapeData);
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// Movement methods.
+	//-----------------------------------------------------------------------------------------------
+
+	// Method for moving the character without sweeping. Applied on the next move.
+	void CCharacterController::Teleport(const Math::SIMDVector& position)
+	{
+		std::lock_guard<std::mutex> lk(m_mutex);
+		m_teleportPosition = position;
+		m_lastPosition = m_nextPosition = position;
+		m_bTeleport = true;
+	}
+
+	// Method for moving the character one tick. Only the horizontal part of the velocity is used, gravity and
+	//  jumping own the vertical part. Physics thread only.
+	void CCharacterController::Move(const Math::SIMDVector& velocity)
+	{
+		const float delta = Util::CTimer::Instance().GetDelta();
+		if(delta <= 0.0f) { return; }
+
+		{ // Apply a pending teleport.
+			std::lock_guard<std::mutex> lk(m_mutex);
+			if(m_bTeleport)
+			{
+				m_position = m_teleportPosition;
+				m_lastPosition = m_nextPosition = m_position;
+				m_fallSpeed = 0.0f;
+				m_ground = { false, -1, nullptr, Math::SIMD_VEC_ZERO };
+				m_bTeleport = false;
+			}
+		}
+
+		const Math::SIMDVector start = m_position;
+		const bool bWasGrounded = m_ground.bGrounded;
+
+		// Gravity only builds up while airborne, so standing still on the ground costs nothing.
+		m_fallSpeed += CPhysics::Instance().GetData().gravity[1] * delta;
+		if(bWasGrounded && m_fallSpeed < 0.0f) { m_fallSpeed = 0.0f; }
+
+		// Walk.
+		const Math::SIMDVector walk(velocity[0] * delta, 0.0f, velocity[2] * delta);
+		const float walkLengthSq = _mm_cvtss_f32(walk.LengthSq());
+
+		bool bBlocked = false;
+		Math::SIMDVector position = SlideMove(start, walk, bBlocked);
+
+		// Blocked by a wall on the ground, so try the same walk a step higher and keep it if it got farther.
+		if(bBlocked && bWasGrounded && m_fallSpeed <= 0.0f && m_data.stepHeight > 0.0f)
+		{
+			SweepInfo info;
+			Sweep(start, Math::SIMD_VEC_UP * m_data.stepHeight, info);
+			const float rise = m_data.stepHeight * Advance(info.interval, m_data.stepHeight);
+
+			bool bStepBlocked = false;
+			Math::SIMDVector stepPosition = SlideMove(start + Math::SIMD_VEC_UP * rise, walk, bStepBlocked);
+
+			Ground stepGround;
+			if(SnapToGround(stepPosition, rise + m_data.skinWidth, stepGround))
+			{
+				const Math::SIMDVector walked = position - start;
+				const Math::SIMDVector stepped = stepPosition - start;
+				if(stepped[0] * stepped[0] + stepped[2] * stepped[2] > walked[0] * walked[0] + walked[2] * walked[2] + 1e-6f)
+				{
+					position = stepPosition;
+				}
+			}
+		}
+
+		Ground ground = { false, -1, nullptr, Math::SIMD_VEC_ZERO };
+
+		if(bWasGrounded && m_fallSpeed <= 0.0f)
+		{ // Step down onto lower ground. An idle character only checks that its cached ground is still there.
+			const float probe = walkLengthSq > 0.0f ? m_data.stepHeight + m_data.skinWidth : m_data.skinWidth * 2.0f;
+			SnapToGround(position, probe, ground);
+		}
+		else
+		{ // Fall or rise.
+			const float fall = m_fallSpeed * delta;
+
+			SweepInfo info;
+			if(Sweep(position, Math::SIMD_VEC_UP * fall, info))
+			{
+				position += Math::SIMD_VEC_UP * (fall * Advance(info.interval, fabsf(fall)));
+
+				if(fall < 0.0f && IsGround(info.normal))
+				{
+					ground = { true, info.index, info.pVolume, info.normal };
+				}
+
+				m_fallSpeed = 0.0f;
+			}
+			else
+			{
+				position += Math::SIMD_VEC_UP * fall;
+			}
+		}
+
+		m_velocity = (position - start) / delta;
+		m_position = position;
+		m_ground = ground;
+
+		// The registered volume follows on the next tick, the same as any other moved collider.
+		CPhysics::Instance().MarkObjectAsDirty(m_pObject, Math::SIMDMatrix::Translate(m_position));
+
+		{ // Publish the step for interpolation.
+			std::lock_guard<std::mutex> lk(m_mutex);
+			m_lastPosition = m_nextPosition;
+			m_nextPosition = m_position;
+			m_stepDelta = delta;
+			++m_step;
+		}
+	}
+
+	// Method for launching the character upward. Only works on the ground. Physics thread only.
+	void CCharacterController::Jump(float speed)
+	{
+		if(!m_ground.bGrounded) { return; }
+
+		m_fallSpeed = speed;
+		m_ground.bGrounded = false;
+	}
+
+	// Method for interpolating the transform between the last two steps. Main thread only.
+	void CCharacterController::UpdateTransform(Logic::CTransform& transform)
+	{
+		if(!transform.IsValid())
+		{
+			return;
+		}
+
+		Math::SIMDVector from;
+		Math::SIMDVector to;
+		float t;
+
+		{
+			std::lock_guard<std::mutex> lk(m_mutex);
+			if(m_step == 0 || m_stepDelta <= 0.0f) { return; }
+
+			if(m_interpStep != m_step)
+			{
+				m_interpStep = m_step;
+				m_interpT = 0.0f;
+			}
+
+			m_interpT = min(m_interpT + Util::CTimer::Instance().GetDelta() / m_stepDelta, 1.0f);
+
+			from = m_lastPosition;
+			to = m_nextPosition;
+			t = m_interpT;
+		}
+
+		transform.InterpolateRigidbodyPosition(from, to, t);
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// Sweep methods.
+	//-----------------------------------------------------------------------------------------------
+
+	bool CCharacterController::Sweep(const Math::SIMDVector& position, const Math::SIMDVector& displacement, SweepInfo& info)
+	{
+		m_shape.Place(position, Math::SIMD_QUAT_IDENTITY);
+		return CPhysics::Instance().SweepImmediate(&m_shape, displacement, m_data.pVolume, info);
+	}
+
+	// Method for moving along the displacement, sliding the remainder along whatever is hit. Blocked is set
+	//  when a hit isn't ground, which is what the step up looks for.
+	Math::SIMDVector CCharacterController::SlideMove(const Math::SIMDVector& position, const Math::SIMDVector& displacement, bool& bBlocked)
+	{
+		Math::SIMDVector current = position;
+		Math::SIMDVector remaining = displacement;
+
+		for(u32 i = 0; i < SLIDE_ITERATIONS; ++i)
+		{
+			const float length = _mm_cvtss_f32(remaining.Length());
+			if(length < 1e-6f) { break; }
+
+			SweepInfo info;
+			if(!Sweep(current, remaining, info))
+			{
+				current += remaining;
+				break;
+			}
+
+			bBlocked |= !IsGround(info.normal);
+
+			current += remaining * Advance(info.interval, length);
+
+			remaining *= 1.0f - info.interval;
+			remaining -= info.normal * _mm_cvtss_f32(Math::SIMDVector::Dot(remaining, info.normal));
+		}
+
+		return current;
+	}
+
+	// Method for dropping onto ground within the distance. The position is only changed if ground was found.
+	bool CCharacterController::SnapToGround(Math::SIMDVector& position, float distance, Ground& ground)
+	{
+		SweepInfo info;
+		if(!Sweep(position, Math::SIMD_VEC_UP * -distance, info) || !IsGround(info.normal)) { return false; }
+
+		position -= Math::SIMD_VEC_UP * (distance * Advance(info.interval, distance));
+		ground = { true, info.index, info.pVolume, info.normal };
+		return true;
+	}
+
+	// Method for converting a sweep interval to how far to actually move, stopping the skin width short of the hit.
+	float CCharacterController::Advance(float interval, float length) const
+	{
+		return max(interval - m_data.skinWidth / length, 0.0f);
+	}
+};
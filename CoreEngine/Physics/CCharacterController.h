@@ -0,0 +1,113 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Copyright (c) Ryan Alasandro
+//
+// Static Library: Core Engine
+//
+// File: Physics/CCharacterController.h
+//
+//-------------------------------------------------------------------------------------------------
+
+#ifndef CCHARACTERCONTROLLER_H
+#define CCHARACTERCONTROLLER_H
+
+#include "CPhysicsData.h"
+#include "CVolumeCapsule.h"
+#include "../Objects/CVComponent.h"
+#include "../Logic/CTransform.h"
+#include "../Math/CSIMDMatrix.h"
+#include <mutex>
+
+namespace Physics
+{
+	// Kinematic alternative to a rigidbody for player characters. Each physics tick the capsule is swept through
+	//  the world instead of being solved, sliding along walls, stepping up ledges and snapping down onto the ground.
+	class CCharacterController : public CVComponent
+	{
+	public:
+		struct Data
+		{
+			// Capsule shape, matching the volume the character is registered with.
+			float radius = 0.4f;
+			float height = 1.0f;
+			float offset = 0.0f;
+
+			// Tallest ledge the character walks up without jumping.
+			float stepHeight = 1.0f;
+
+			// Gap kept between the capsule and anything it hits, so the next sweep doesn't start touching.
+			float skinWidth = 1e-2f;
+
+			// Smallest up component of a hit normal that counts as ground.
+			float minGroundNormal = 0.7f;
+
+			// Registered volume of the character, which its own sweeps ignore.
+			const class CVolume* pVolume;
+		};
+
+		// Last surface the character stood on.
+		struct Ground
+		{
+			bool bGrounded;
+			int index;
+			const class CVolume* pVolume;
+			Math::SIMDVector normal;
+		};
+
+	public:
+		CCharacterController(const CVObject* pObject);
+		~CCharacterController();
+		CCharacterController(const CCharacterController&) = delete;
+		CCharacterController(CCharacterController&&) = delete;
+		CCharacterController& operator = (const CCharacterController&) = delete;
+		CCharacterController& operator = (CCharacterController&&) = delete;
+
+		void Teleport(const Math::SIMDVector& position);
+		void Move(const Math::SIMDVector& velocity);
+		void Jump(float speed);
+		void UpdateTransform(Logic::CTransform& transform);
+
+		// Accessors.
+		inline const Math::SIMDVector& GetPosition() const { return m_position; }
+		inline const Math::SIMDVector& GetVelocity() const { return m_velocity; }
+		inline bool OnGround() const { return m_ground.bGrounded; }
+		inline const Ground& GetGround() const { return m_ground; }
+
+		// Modifiers.
+		void SetData(const Data& data);
+
+	private:
+		bool Sweep(const Math::SIMDVector& position, const Math::SIMDVector& displacement, SweepInfo& info);
+		Math::SIMDVector SlideMove(const Math::SIMDVector& position, const Math::SIMDVector& displacement, bool& bBlocked);
+		bool SnapToGround(Math::SIMDVector& position, float distance, Ground& ground);
+		float Advance(float interval, float length) const;
+
+		inline bool IsGround(const Math::SIMDVector& normal) const { return normal[1] >= m_data.minGroundNormal; }
+
+	private:
+		std::mutex m_mutex;
+
+		Data m_data;
+		CVolumeCapsule m_shape;
+
+		// Physics thread state.
+		Math::SIMDVector m_position;
+		Math::SIMDVector m_velocity;
+		float m_fallSpeed;
+		Ground m_ground;
+
+		// Shared with the main thread under the mutex.
+		bool m_bTeleport;
+		Math::SIMDVector m_teleportPosition;
+		Math::SIMDVector m_lastPosition;
+		Math::SIMDVector m_nextPosition;
+		float m_stepDelta;
+		u32 m_step;
+
+		// Main thread state.
+		u32 m_interpStep;
+		float m_interpT;
+	};
+};
+
+#endif
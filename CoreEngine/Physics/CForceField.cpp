@@ -0,0 +1,168 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Copyright (c) Ryan Alasandro
+//
+// Static Library: Core Engine
+//
+// File: Physics/CForceField.cpp
+//
+//-------------------------------------------------------------------------------------------------
+
+#include "CForceField.h"
+#include "CVolume.h"
+#include "CVolumeArray.h"
+#include "CRigidbody.h"
+#include <Windows.h>
+
+namespace Physics
+{
+	CForceField::CForceField(const CVObject* pObject) :
+		CVComponent(pObject),
+		m_bDetonate(false) { }
+
+	CForceField::~CForceField() { }
+
+	// Method for setting off an explosion on the next physics step. Safe to call from any thread.
+	void CForceField::Detonate()
+	{
+		m_bDetonate = true;
+	}
+
+	// Method for checking whether the field applies this step. Explosions only apply once per detonation.
+	bool CForceField::PhysicsUpdate()
+	{
+		if(m_data.type == FieldType::Explosion)
+		{
+			return m_bDetonate.exchange(false);
+		}
+
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// Evaluation methods.
+	//-----------------------------------------------------------------------------------------------
+
+	// Method for adding the field's force to the given rigidbodies. Bodies are evaluated four at a time, and the force
+	//  is scaled by delta since the rigidbody adds its accumulated force to its velocity directly.
+	void CForceField::Apply(const CVolumeArray& rigidbodies, const u32* pSlotList, u32 count, const Math::Vector3& center, const CAABBTree::AABB& bounds, float delta) const
+	{
+		const vf32 zero = _mm_setzero_ps();
+		const vf32 epsilon = _mm_set1_ps(1e-5f);
+		const vf32 strength = _mm_set1_ps(m_data.strength * (m_data.type == FieldType::Explosion ? 1.0f : delta));
+		const vf32 drag = _mm_set1_ps(-m_data.drag * delta);
+		const vf32 invRadius = _mm_set1_ps(1.0f / m_data.radius);
+		const vf32 dirX = _mm_set1_ps(m_data.direction.x);
+		const vf32 dirY = _mm_set1_ps(m_data.direction.y);
+		const vf32 dirZ = _mm_set1_ps(m_data.direction.z);
+
+		for(u32 first = 0; first < count; first += 4)
+		{
+			const u32 lanes = min(count - first, 4U);
+
+			alignas(16) float position[3][4] { };
+			alignas(16) float velocity[3][4] { };
+			alignas(16) float bottom[4] { };
+			alignas(16) float height[4] { };
+
+			for(u32 lane = 0; lane < lanes; ++lane)
+			{
+				const u32 slot = pSlotList[first + lane];
+				const Math::Vector3& p = rigidbodies.GetPosition(slot);
+				const Math::Vector3& v = rigidbodies.GetVelocity(slot);
+
+				position[0][lane] = p.x - center.x;
+				position[1][lane] = p.y - center.y;
+				position[2][lane] = p.z - center.z;
+				velocity[0][lane] = v.x;
+				velocity[1][lane] = v.y;
+				velocity[2][lane] = v.z;
+				bottom[lane] = p.y + rigidbodies.GetMinExtents(slot).y;
+				height[lane] = rigidbodies.GetMaxExtents(slot).y - rigidbodies.GetMinExtents(slot).y;
+			}
+
+			const vf32 px = _mm_load_ps(position[0]);
+			const vf32 py = _mm_load_ps(position[1]);
+			const vf32 pz = _mm_load_ps(position[2]);
+			const vf32 vx = _mm_load_ps(velocity[0]);
+			const vf32 vy = _mm_load_ps(velocity[1]);
+			const vf32 vz = _mm_load_ps(velocity[2]);
+
+			vf32 fx = zero;
+			vf32 fy = zero;
+			vf32 fz = zero;
+
+			switch(m_data.type)
+			{
+				case FieldType::Directional:
+				{
+					fx = _mm_mul_ps(dirX, strength);
+					fy = _mm_mul_ps(dirY, strength);
+					fz = _mm_mul_ps(dirZ, strength);
+					break;
+				}
+				case FieldType::Radial:
+				case FieldType::Explosion:
+				{ // Push away from the center, fading out with distance.
+					const vf32 dist = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px, px), _mm_mul_ps(py, py)), _mm_mul_ps(pz, pz)));
+					const vf32 falloff = _mm_max_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(dist, invRadius)), zero);
+					const vf32 scale = _mm_div_ps(_mm_mul_ps(strength, falloff), _mm_max_ps(dist, epsilon));
+
+					fx = _mm_mul_ps(px, scale);
+					fy = _mm_mul_ps(py, scale);
+					fz = _mm_mul_ps(pz, scale);
+					break;
+				}
+				case FieldType::Vortex:
+				{ // Push around the axis through the center, fading out with distance from the axis.
+					const vf32 along = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, dirX), _mm_mul_ps(py, dirY)), _mm_mul_ps(pz, dirZ));
+					const vf32 rx = _mm_sub_ps(px, _mm_mul_ps(dirX, along));
+					const vf32 ry = _mm_sub_ps(py, _mm_mul_ps(dirY, along));
+					const vf32 rz = _mm_sub_ps(pz, _mm_mul_ps(dirZ, along));
+
+					const vf32 dist = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry)), _mm_mul_ps(rz, rz)));
+					const vf32 falloff = _mm_max_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(dist, invRadius)), zero);
+					const vf32 scale = _mm_div_ps(_mm_mul_ps(strength, falloff), _mm_max_ps(dist, epsilon));
+
+					fx = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(dirY, rz), _mm_mul_ps(dirZ, ry)), scale);
+					fy = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(dirZ, rx), _mm_mul_ps(dirX, rz)), scale);
+					fz = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(dirX, ry), _mm_mul_ps(dirY, rx)), scale);
+					break;
+				}
+				case FieldType::Drag:
+				{
+					fx = _mm_mul_ps(vx, drag);
+					fy = _mm_mul_ps(vy, drag);
+					fz = _mm_mul_ps(vz, drag);
+					break;
+				}
+				case FieldType::Buoyancy:
+				{ // Lift and drag scale with how much of the body's bounds is under the top of the field.
+					const vf32 depth = _mm_sub_ps(_mm_set1_ps(bounds.mx.y), _mm_load_ps(bottom));
+					vf32 submerged = _mm_div_ps(depth, _mm_max_ps(_mm_load_ps(height), epsilon));
+					submerged = _mm_min_ps(_mm_max_ps(submerged, zero), _mm_set1_ps(1.0f));
+
+					const vf32 submergedDrag = _mm_mul_ps(drag, submerged);
+					fx = _mm_mul_ps(vx, submergedDrag);
+					fy = _mm_add_ps(_mm_mul_ps(vy, submergedDrag), _mm_mul_ps(strength, submerged));
+					fz = _mm_mul_ps(vz, submergedDrag);
+					break;
+				}
+			}
+
+			alignas(16) float force[3][4];
+			_mm_store_ps(force[0], fx);
+			_mm_store_ps(force[1], fy);
+			_mm_store_ps(force[2], fz);
+
+			// Only bodies the field actually pushes get woken.
+			const u32 activeMask = static_cast<u32>(_mm_movemask_ps(_mm_or_ps(_mm_or_ps(_mm_cmpneq_ps(fx, zero), _mm_cmpneq_ps(fy, zero)), _mm_cmpneq_ps(fz, zero))));
+			for(u32 lane = 0; lane < lanes; ++lane)
+			{
+				if((activeMask & (1U << lane)) == 0) { continue; }
+
+				rigidbodies[pSlotList[first + lane]]->GetRigidbody()->AddForce(Math::SIMDVector(force[0][lane], force[1][lane], force[2][lane]));
+			}
+		}
+	}
+};
@@ -11,9 +11,11 @@
 #ifndef CFORCEFIELD_H
 #define CFORCEFIELD_H
 
+#include "CAABBTree.h"
 #include "../Objects/CVComponent.h"
 #include "../Math/CSIMDVector.h"
 #include "../Math/CSIMDMatrix.h"
+#include "../Math/CMathVector3.h"
 #include "../Logic/CTransform.h"
 
 namespace Physics
@@ -21,17 +23,51 @@ namespace Physics
 	class CForceField : public CVComponent
 	{
 	public:
-		CForceField(const CVObject* pObject) : CVComponent(pObject) { }
-		virtual ~CForceField() { }
+		enum class FieldType
+		{
+			Directional,
+			Radial,
+			Explosion,
+			Vortex,
+			Drag,
+			Buoyancy,
+		};
 
+		struct Data
+		{
+			FieldType type = FieldType::Directional;
+
+			// Force along the direction for directional fields, away from the center for radial fields and explosions,
+			//  around the direction for vortices and up for buoyancy. Explosions apply it once as an impulse.
+			float strength = 1.0f;
+			Math::Vector3 direction = Math::Vector3(0.0f, 1.0f, 0.0f);
+
+			// Radial fields, explosions and vortices fade out linearly to nothing at the radius.
+			float radius = 1.0f;
+
+			// Force against velocity, used by drag volumes and by the fluid of buoyancy volumes.
+			float drag = 0.0f;
+		};
+
+	public:
+		CForceField(const CVObject* pObject);
+		~CForceField();
 		CForceField(const CForceField&) = delete;
 		CForceField(CForceField&&) = delete;
 		CForceField& operator = (const CForceField&) = delete;
 		CForceField& operator = (CForceField&&) = delete;
 
-		void PhysicsUpdate() { }
+		void Detonate();
+		bool PhysicsUpdate();
+		void Apply(const class CVolumeArray& rigidbodies, const u32* pSlotList, u32 count, const Math::Vector3& center, const CAABBTree::AABB& bounds, float delta) const;
+
+		// Modifiers.
+		inline void SetData(const Data& data) { m_data = data; }
 
 	private:
+		Data m_data;
+
+		Abool m_bDetonate;
 	};
 };
 
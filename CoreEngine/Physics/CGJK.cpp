@@ -23,10 +23,14 @@ namespace Physics
 	thread_local const class CVolume* CGJK::m_pVolumeA = nullptr;
 	thread_local const class CVolume* CGJK::m_pVolumeB = nullptr;
 
+	thread_local u32 CGJK::m_callCount = 0;
+	thread_local u32 CGJK::m_iterationCount = 0;
+
 	static const int MAX_ITERATIONS = 256;
 
 	bool CGJK::Intersection(const class CVolume* pVolumeA, const class CVolume* pVolumeB)
 	{
+		++m_callCount;
 		m_pVolumeA = pVolumeA;
 		m_pVolumeB = pVolumeB;
 
@@ -38,6 +42,7 @@ namespace Physics
 		float err = Math::g_EpsilonTol;
 		while(_mm_cvtss_f32(_mm_sub_ps(v.Dot(v), v.Dot(w))) > err && iterations++ < MAX_ITERATIONS)
 		{
+			++m_iterationCount;
 			AddSimplex(w);
 
 			// Calculate new error from simplex data.
@@ -67,6 +72,7 @@ namespace Physics
 
 	Math::SIMDVector CGJK::Distance(const class CVolume* pVolumeA, const class CVolume* pVolumeB, bool bInset)
 	{
+		++m_callCount;
 		m_pVolumeA = pVolumeA;
 		m_pVolumeB = pVolumeB;
 
@@ -81,6 +87,7 @@ namespace Physics
 		float err = Math::g_EpsilonTol;
 		while(_mm_cvtss_f32(_mm_sub_ps(v.Dot(v), v.Dot(w))) > err && iterations++ < MAX_ITERATIONS)
 		{
+			++m_iterationCount;
 			AddSimplex(w);
 
 			// Calculate new error from simplex data.
@@ -110,6 +117,7 @@ namespace Physics
 
 	bool CGJK::MovingContact(const class CVolume* pVolumeA, const class CVolume* pVolumeB, const Math::SIMDVector& rDir, Math::SIMDVector& contact, Math::SIMDVector& normal, float& t, Math::SIMDVector& sepAxis)
 	{
+		++m_callCount;
 		m_pVolumeA = pVolumeA;
 		m_pVolumeB = pVolumeB;
 
@@ -128,6 +136,7 @@ namespace Physics
 		float err = Math::g_EpsilonTol;
 		while(bFirst || _mm_cvtss_f32(v.Dot(v)) > err && iterations++ < MAX_ITERATIONS)
 		{
+			++m_iterationCount;
 			p = Support(-v);
 
 			const float vp = _mm_cvtss_f32(v.Dot(p));
@@ -181,15 +190,21 @@ namespace Physics
 		return bHit;
 	}
 
-	bool CGJK::RestingContact(const class CVolume* pVolumeA, const class CVolume* pVolumeB, Math::SIMDVector& contactA, Math::SIMDVector& contactB, Math::SIMDVector& normal)
+	// Method for finding the contact between two resting volumes. The search starts from the closest point found
+	//  along sepAxis, which is last step's result for the pair, and the new closest point is written back to it.
+	//  Distance is the gap between the cores along the normal, or negative when the cores overlap.
+	bool CGJK::RestingContact(const class CVolume* pVolumeA, const class CVolume* pVolumeB, Math::SIMDVector& contactA, Math::SIMDVector& contactB, Math::SIMDVector& normal, Math::SIMDVector& sepAxis, float& distance)
 	{
+		++m_callCount;
 		m_pVolumeA = pVolumeA;
 		m_pVolumeB = pVolumeB;
+		distance = -1.0f;
 		
 		const float ra = m_pVolumeA->GetSkinDepth();
 		const float rb = m_pVolumeB->GetSkinDepth();
 
-		Math::SIMDVector v = Support(Math::SIMD_VEC_FORWARD);
+		const bool bWarm = _mm_cvtss_f32(sepAxis.LengthSq()) > Math::g_EpsilonTol * Math::g_EpsilonTol;
+		Math::SIMDVector v = bWarm ? Support(-sepAxis) : Support(Math::SIMD_VEC_FORWARD);
 		Math::SIMDVector w = Support(-v);
 		ResetSimplex();
 
@@ -198,10 +213,12 @@ namespace Physics
 		float err = Math::g_EpsilonTol;
 		while(iterations++ < MAX_ITERATIONS)
 		{
+			++m_iterationCount;
 			float vv = _mm_cvtss_f32(v.Dot(v));
 			float vw = _mm_cvtss_f32(v.Dot(w));
 			if(vv - vw <= err) { break; }
 			if(vw > 0.0f && (vw * vw) / vv > powf(ra + rb, 2.0f)) {
+				sepAxis = v;
 				return false;
 			}
 
@@ -225,12 +242,15 @@ namespace Physics
 			w = Support(-v);
 		}
 		
+		sepAxis = v;
+
 		if(_mm_cvtss_f32(v.Dot(v)) > err * err)
 		{
 			float len = _mm_cvtss_f32(v.Length());
 			normal = -v / len;
 			contactA = -normal * max(0.0f, ra - (len - rb));
 			contactB = normal * max(0.0f, rb - (len - ra));
+			distance = len;
 		}
 		else
 		{
@@ -246,6 +266,7 @@ namespace Physics
 			err = Math::g_EpsilonTol;
 			while(_mm_cvtss_f32(_mm_sub_ps(v.Dot(v), v.Dot(w))) > err && iterations++ < MAX_ITERATIONS)
 			{
+				++m_iterationCount;
 				AddSimplex(w);
 			
 				m_simplexSize = TestSimplex(nullptr, &v);
@@ -272,6 +293,57 @@ namespace Physics
 		return true;
 	}
 
+	// Method for rejecting up to four boxes against a volume in one SIMD pass, before running GJK on any of them.
+	//  Boxes share a half size and rotation, and centers are relative to the volume's solver position. Box i is
+	//  projected onto pAxisList[i], and its bit is set when the volume, swept by displacement, stays more than
+	//  margin away from it along that axis. Cached separating axes make good test axes, since they rarely change.
+	u32 CGJK::SeparatedBoxes(const class CVolume* pVolume, const Math::SIMDVector* pCenterList, const Math::SIMDVector* pAxisList, u32 count,
+		const Math::Vector3& halfSize, const Math::SIMDQuaternion& rotation, const Math::SIMDVector& displacement, float margin)
+	{
+		alignas(16) float localAxis[3][4] { };
+		alignas(16) float center[4] { };
+		alignas(16) float mn[4] { };
+		alignas(16) float mx[4] { };
+
+		// The volume's support is a virtual call, so it's gathered per lane. Everything after it runs four wide.
+		for(u32 lane = 0; lane < count; ++lane)
+		{
+			const Math::SIMDVector& axis = pAxisList[lane];
+			const Math::SIMDVector local = rotation.Conjugate() * axis;
+			const float sweep = _mm_cvtss_f32(axis.Dot(displacement));
+
+			localAxis[0][lane] = local.ToFloat()[0];
+			localAxis[1][lane] = local.ToFloat()[1];
+			localAxis[2][lane] = local.ToFloat()[2];
+			center[lane] = _mm_cvtss_f32(axis.Dot(pCenterList[lane]));
+			mx[lane] = _mm_cvtss_f32(axis.Dot(pVolume->SupportPoint(axis, pVolume))) + max(sweep, 0.0f);
+			mn[lane] = _mm_cvtss_f32(axis.Dot(pVolume->SupportPoint(-axis, pVolume))) + min(sweep, 0.0f);
+		}
+
+		const vf32 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+		vf32 radius = _mm_mul_ps(_mm_and_ps(_mm_load_ps(localAxis[0]), absMask), _mm_set1_ps(halfSize.x));
+		radius = _mm_add_ps(radius, _mm_mul_ps(_mm_and_ps(_mm_load_ps(localAxis[1]), absMask), _mm_set1_ps(halfSize.y)));
+		radius = _mm_add_ps(radius, _mm_mul_ps(_mm_and_ps(_mm_load_ps(localAxis[2]), absMask), _mm_set1_ps(halfSize.z)));
+		radius = _mm_add_ps(radius, _mm_set1_ps(margin));
+
+		const vf32 c = _mm_load_ps(center);
+		const vf32 above = _mm_cmpgt_ps(_mm_sub_ps(c, radius), _mm_load_ps(mx));
+		const vf32 below = _mm_cmplt_ps(_mm_add_ps(c, radius), _mm_load_ps(mn));
+
+		return static_cast<u32>(_mm_movemask_ps(_mm_or_ps(above, below))) & ((1U << count) - 1);
+	}
+
+	// Method for adding this thread's call and iteration counts to the stats.
+	void CGJK::FlushStats(CPhysicsStats& stats)
+	{
+		if(m_callCount == 0) { return; }
+
+		stats.Count(CPhysicsStats::Metric::GJKCalls, m_callCount);
+		stats.Count(CPhysicsStats::Metric::GJKIterations, m_iterationCount);
+		m_callCount = 0;
+		m_iterationCount = 0;
+	}
+
 	//-----------------------------------------------------------------------------------------------
 	// Simplex methods.
 	//-----------------------------------------------------------------------------------------------
@@ -11,7 +11,10 @@
 #ifndef CGJK_H
 #define CGJK_H
 
+#include "CPhysicsStats.h"
 #include "../Math/CSIMDMatrix.h"
+#include "../Math/CSIMDQuaternion.h"
+#include "../Math/CMathVector3.h"
 #include "../Math/CMathVector4.h"
 
 namespace Physics
@@ -22,7 +25,12 @@ namespace Physics
 		static bool Intersection(const class CVolume* pVolumeA, const class CVolume* pVolumeB);
 		static Math::SIMDVector Distance(const class CVolume* pVolumeA, const class CVolume* pVolumeB, bool bInset);
 		static bool MovingContact(const class CVolume* pVolumeA, const class CVolume* pVolumeB, const Math::SIMDVector& rDir, Math::SIMDVector& contact, Math::SIMDVector& normal, float& t, Math::SIMDVector& sepAxis);
-		static bool RestingContact(const class CVolume* pVolumeA, const class CVolume* pVolumeB, Math::SIMDVector& contactA, Math::SIMDVector& contactB, Math::SIMDVector& normal);
+		static bool RestingContact(const class CVolume* pVolumeA, const class CVolume* pVolumeB, Math::SIMDVector& contactA, Math::SIMDVector& contactB, Math::SIMDVector& normal, Math::SIMDVector& sepAxis, float& distance);
+
+		static u32 SeparatedBoxes(const class CVolume* pVolume, const Math::SIMDVector* pCenterList, const Math::SIMDVector* pAxisList, u32 count,
+			const Math::Vector3& halfSize, const Math::SIMDQuaternion& rotation, const Math::SIMDVector& displacement, float margin);
+
+		static void FlushStats(CPhysicsStats& stats);
 
 	private:
 		static int TestSimplex(Math::SIMDVector* pDir, Math::SIMDVector* pPoint);
@@ -85,6 +93,10 @@ namespace Physics
 
 		static thread_local const class CVolume* m_pVolumeA;
 		static thread_local const class CVolume* m_pVolumeB;
+
+		// Calls and iterations on this thread since the last flush.
+		static thread_local u32 m_callCount;
+		static thread_local u32 m_iterationCount;
 	};
 };
 
@@ -10,15 +10,23 @@
 
 #include "CPhysics.h"
 #include "CVolume.h"
+#include "CGJK.h"
 #include "../Utilities/CTimer.h"
+#include <Windows.h>
+#include <chrono>
+#include <cstring>
 #include <thread>
 
 namespace Physics
 {
 	CPhysics::CPhysics() :
 		m_exitFlag(false),
-		m_physicsUpdateBatch(4, 4)
-	{}
+		m_physicsUpdateBatch(4, 4),
+		m_snapshotIndex(0)
+	{
+		m_snapshotList[0] = std::make_shared<CPhysicsSnapshot>();
+		m_snapshot = m_snapshotList[0];
+	}
 
 	CPhysics::~CPhysics()
 	{}
@@ -48,23 +56,75 @@ namespace Physics
 
 	void CPhysics::CastRay(const QueryRay& query)
 	{
-		QueryRay q = query;
-		m_queryRayQueue.PushBack(q);
+		m_queryRayQueue.Push({ query, std::chrono::steady_clock::now() });
+	}
+
+	void CPhysics::CastRays(const QueryRayBatch& query)
+	{
+		m_queryRayBatchQueue.Push({ query, std::chrono::steady_clock::now() });
+	}
+
+	void CPhysics::Sweep(const QuerySweep& query)
+	{
+		m_querySweepQueue.Push({ query, std::chrono::steady_clock::now() });
+	}
+
+	void CPhysics::Overlap(const QueryOverlap& query)
+	{
+		m_queryOverlapQueue.Push({ query, std::chrono::steady_clock::now() });
+	}
+
+	std::future<std::vector<RaycastInfo>> CPhysics::CastRayAsync(const Math::CSIMDRay& ray)
+	{
+		return RunQuery<std::vector<RaycastInfo>>([ray](const CPhysicsSnapshot& snapshot, std::vector<RaycastInfo>& hitList){
+			QueryRay query { };
+			query.ray = ray;
+			snapshot.CastRay(query, hitList);
+		});
+	}
+
+	// Both lists belong to the caller and have to stay alive until the future is ready.
+	std::future<u32> CPhysics::CastRaysAsync(const Math::CSIMDRay* pRayList, RaycastInfo* pHitList, u32 count)
+	{
+		return RunQuery<u32>([pRayList, pHitList, count](const CPhysicsSnapshot& snapshot, u32& hitCount){
+			hitCount = snapshot.CastRays(pRayList, pHitList, count);
+		});
+	}
+
+	std::future<SweepInfo> CPhysics::SweepAsync(const QueryVolume& volume, const Math::SIMDVector& displacement)
+	{
+		return RunQuery<SweepInfo>([volume, displacement](const CPhysicsSnapshot& snapshot, SweepInfo& info){
+			snapshot.Sweep(volume, displacement, info);
+		});
+	}
+
+	std::future<std::vector<OverlapInfo>> CPhysics::OverlapAsync(const QueryVolume& volume)
+	{
+		return RunQuery<std::vector<OverlapInfo>>([volume](const CPhysicsSnapshot& snapshot, std::vector<OverlapInfo>& infoList){
+			snapshot.Overlap(volume, infoList);
+		});
 	}
 
 	//-----------------------------------------------------------------------------------------------
 	// Utilities.
 	//-----------------------------------------------------------------------------------------------
 
+	// Method for queuing a transform change. Objects without a registered volume are skipped on the physics thread.
 	void CPhysics::MarkObjectAsDirty(const CVObject* pObject, const Math::SIMDMatrix& world)
 	{
-		std::lock_guard<std::mutex> lk(m_mutex);
-		auto elem = m_volumeMap.find(pObject->GetHash());
-		if(elem != m_volumeMap.end())
-		{
-			std::pair<Physics::CVolume*, Math::SIMDMatrix> pair = { elem->second, world };
-			m_dirtyQueue.PushBack(pair);
-		}
+		m_colliderQueue.Push({ ColliderCommand::Type::Dirty, nullptr, pObject->GetHash(), world });
+	}
+
+	// Method for waking sleeping rigidbodies in a region, for changes the physics world can't see, like voxel edits.
+	void CPhysics::WakeRegion(const Math::Vector3& mn, const Math::Vector3& mx)
+	{
+		m_wakeQueue.Push({ mn, mx });
+	}
+
+	// Method for moving the point the world's regions are throttled around, usually the player.
+	void CPhysics::SetFocus(const Math::Vector3& focus)
+	{
+		m_focusQueue.Push(focus);
 	}
 
 	//-----------------------------------------------------------------------------------------------
@@ -73,16 +133,12 @@ namespace Physics
 
 	void CPhysics::RegisterVolume(CVolume* pVolume)
 	{
-		std::lock_guard<std::mutex> lk(m_mutex);
-		m_volumeMap.insert({ pVolume->GetVObject()->GetHash(), pVolume });
-		m_insertionQueue.PushBack(pVolume);
+		m_colliderQueue.Push({ ColliderCommand::Type::Insert, pVolume, pVolume->GetVObject()->GetHash(), Math::SIMDMatrix() });
 	}
 
 	void CPhysics::DeregisterVolume(CVolume* pVolume)
 	{
-		std::lock_guard<std::mutex> lk(m_mutex);
-		m_volumeMap.erase(pVolume->GetVObject()->GetHash());
-		m_deletionQueue.PushBack(pVolume);
+		m_colliderQueue.Push({ ColliderCommand::Type::Delete, pVolume, pVolume->GetVObject()->GetHash(), Math::SIMDMatrix() });
 	}
 
 	//-----------------------------------------------------------------------------------------------
@@ -92,75 +148,403 @@ namespace Physics
 	void CPhysics::PhysicsThread(std::promise<void> p)
 	{
 		Util::CTimer::Instance().SetTargetFrameRate(m_data.targetFPS);
+		CPhysicsRecorder* pRecorder = m_data.pRecorder;
+		m_physicsWorld.SetRegionData(m_data.regions);
 
 		while(!m_exitFlag)
 		{
 			Util::CTimer::Instance().Tick();
+			m_stats.BeginTick();
+			if(pRecorder) pRecorder->BeginFrame(Util::CTimer::Instance().GetDelta());
 			
 			// Process external collider updates.
-			ProcessColliderUpdates();
+			ProcessColliderUpdates(pRecorder);
+			m_stats.Lap(CPhysicsStats::Metric::ColliderUpdates);
 			
 			// Physics updates.
 			// Update game-driven rigidbodies.
+			if(pRecorder) m_physicsWorld.GetInputs(m_lastInputList);
 			m_physicsUpdateBatch.Update();
+			if(pRecorder) RecordInputs(*pRecorder);
+			m_stats.Lap(CPhysicsStats::Metric::PhysicsUpdates);
 
 			// Update phantoms.
 			// Update forces, apply impulses and adjust constraints.
 			m_physicsWorld.UpdateForceFields();
+			m_stats.Lap(CPhysicsStats::Metric::ForceFields);
 			m_physicsWorld.UpdateRigidbodies();
+			m_stats.Lap(CPhysicsStats::Metric::Rigidbodies);
 			
 			// Step the simulation.
-			m_physicsWorld.Solve(m_data.idleIterations, m_data.rayCastIterations);
+			m_physicsWorld.Solve(m_data.idleIterations, m_data.rayCastIterations, m_data.parallelFor);
+			if(pRecorder) RecordBodies(*pRecorder);
+			m_stats.Lap(CPhysicsStats::Metric::Solve);
 
 			// Update physics-driven game objects.
 			// Query phantoms.
 
 			// Perform collision cast queries.
-			ProcessQueries();
+			PublishSnapshot();
+			ProcessQueries(pRecorder);
+			m_stats.Lap(CPhysicsStats::Metric::Queries);
+
+			CGJK::FlushStats(m_stats);
+			m_stats.Publish();
+		}
+
+		// Nothing rebuilds the snapshots once the thread is gone, so they're swapped for an empty one. Volumes they
+		//  shared can be deregistered as soon as the readers still holding them are done.
+		m_snapshotList[0] = std::make_shared<CPhysicsSnapshot>();
+		m_snapshotList[1] = nullptr;
+
+		{
+			std::lock_guard<std::mutex> lk(m_snapshotMutex);
+			m_snapshot = m_snapshotList[0];
 		}
 
 		p.set_value();
 	}
 
+	//-----------------------------------------------------------------------------------------------
+	// Record and replay methods.
+	//-----------------------------------------------------------------------------------------------
+
+	// Entries are compared member by member, since their padding isn't guaranteed to match.
+	static bool SameInput(const CPhysicsRecorder::InputEntry& a, const CPhysicsRecorder::InputEntry& b)
+	{
+		return a.hash == b.hash && a.input.bWake == b.input.bWake &&
+			memcmp(&a.input.velocity, &b.input.velocity, sizeof(Math::SIMDVector)) == 0 &&
+			memcmp(&a.input.acceleration, &b.input.acceleration, sizeof(Math::SIMDVector)) == 0 &&
+			memcmp(&a.input.force, &b.input.force, sizeof(Math::SIMDVector)) == 0;
+	}
+
+	static bool SameBody(const CPhysicsRecorder::BodyEntry& a, const CPhysicsRecorder::BodyEntry& b)
+	{
+		return a.hash == b.hash &&
+			memcmp(&a.position, &b.position, sizeof(Math::Vector3)) == 0 &&
+			memcmp(&a.rotation, &b.rotation, sizeof(Math::Vector4)) == 0;
+	}
+
+	// Method for recording the rigidbody input the physics updates changed, so a replay doesn't need the game code behind them.
+	void CPhysics::RecordInputs(CPhysicsRecorder& recorder)
+	{
+		m_physicsWorld.GetInputs(m_inputList);
+		for(size_t i = 0; i < m_inputList.size(); ++i)
+		{
+			if(i < m_lastInputList.size() && SameInput(m_inputList[i], m_lastInputList[i])) { continue; }
+
+			recorder.RecordInput(m_inputList[i].hash, m_inputList[i].input);
+		}
+	}
+
+	void CPhysics::RecordBodies(CPhysicsRecorder& recorder)
+	{
+		m_physicsWorld.GetBodies(m_bodyList);
+		for(const CPhysicsRecorder::BodyEntry& body : m_bodyList)
+		{
+			recorder.RecordBody(body.hash, body.position, body.rotation);
+		}
+	}
+
+	// Method for running a recording on the calling thread in place of the physics thread, which must not be running.
+	//  The scene's volumes have to be registered beforehand; they're bound to the recording by object hash, and the
+	//  recorded collider commands replace their own. In deterministic mode islands are solved serially and every tick's
+	//  rigidbody transforms are compared bitwise against the recording.
+	void CPhysics::Replay(const CPhysicsRecorder& recording, bool bDeterministic, CPhysicsRecorder::Report& report)
+	{
+		std::unordered_map<u64, CVolume*> sceneMap;
+		m_colliderQueue.Consume([&sceneMap](ColliderCommand& command){
+			if(command.type == ColliderCommand::Type::Insert) { sceneMap[command.hash] = command.pVolume; }
+		});
+
+		m_wakeQueue.Clear();
+		m_focusQueue.Clear();
+		m_physicsWorld.SetRegionData(m_data.regions);
+
+		report = { };
+		report.mismatchFrame = CPhysicsRecorder::INVALID_FRAME;
+
+		const ParallelFor parallelFor = bDeterministic ? nullptr : m_data.parallelFor;
+
+		QueryRay queryRay { };
+
+		auto start = std::chrono::steady_clock::now();
+		auto lap = [&start](CPhysicsRecorder::PhaseTime& phase){
+			const auto now = std::chrono::steady_clock::now();
+			phase.Add(std::chrono::duration<float, std::milli>(now - start).count());
+			start = now;
+		};
+
+		for(u32 f = 0; f < recording.GetFrameCount(); ++f)
+		{
+			const CPhysicsRecorder::Frame& frame = recording.GetFrame(f);
+			Util::CTimer::Instance().Step(frame.delta);
+			start = std::chrono::steady_clock::now();
+
+			{ // Collider updates.
+				const CPhysicsRecorder::ColliderEntry* pColliderList = recording.GetColliders(frame);
+				for(u32 i = 0; i < frame.colliders.count; ++i)
+				{
+					const CPhysicsRecorder::ColliderEntry& entry = pColliderList[i];
+					switch(static_cast<ColliderCommand::Type>(entry.type))
+					{
+						case ColliderCommand::Type::Insert:
+						{
+							auto elem = sceneMap.find(entry.hash);
+							if(elem != sceneMap.end())
+							{
+								m_volumeMap.insert({ entry.hash, elem->second });
+								m_physicsWorld.AddVolume(elem->second);
+							}
+						} break;
+						case ColliderCommand::Type::Delete:
+						{
+							auto elem = m_volumeMap.find(entry.hash);
+							if(elem != m_volumeMap.end())
+							{
+								m_physicsWorld.RemoveVolume(elem->second);
+								m_volumeMap.erase(elem);
+							}
+						} break;
+						case ColliderCommand::Type::Dirty:
+						{
+							auto elem = m_volumeMap.find(entry.hash);
+							if(elem != m_volumeMap.end())
+							{
+								m_physicsWorld.UpdateVolume(elem->second, entry.world);
+							}
+						} break;
+					}
+				}
+
+				const CAABBTree::AABB* pWakeList = recording.GetWakes(frame);
+				for(u32 i = 0; i < frame.wakes.count; ++i)
+				{
+					m_physicsWorld.WakeRegion(pWakeList[i]);
+				}
+
+				const Math::Vector3* pFocusList = recording.GetFocuses(frame);
+				for(u32 i = 0; i < frame.focuses.count; ++i)
+				{
+					m_physicsWorld.SetFocus(pFocusList[i]);
+				}
+
+				lap(report.colliders);
+			}
+
+			{ // Recorded physics update input.
+				const CPhysicsRecorder::InputEntry* pInputList = recording.GetInputs(frame);
+				for(u32 i = 0; i < frame.inputs.count; ++i)
+				{
+					m_physicsWorld.SetInput(pInputList[i]);
+				}
+
+				lap(report.inputs);
+			}
+
+			m_physicsWorld.UpdateForceFields();
+			lap(report.forceFields);
+
+			m_physicsWorld.UpdateRigidbodies();
+			lap(report.rigidbodies);
+
+			m_physicsWorld.Solve(m_data.idleIterations, m_data.rayCastIterations, parallelFor);
+			lap(report.solve);
+
+			{ // Queries.
+				PublishSnapshot();
+
+				const Math::CSIMDRay* pRayList = recording.GetRays(frame);
+				for(u32 i = 0; i < frame.rays.count; ++i)
+				{
+					queryRay.ray = pRayList[i];
+					m_rayHitList.clear();
+					m_snapshotList[m_snapshotIndex]->CastRay(queryRay, m_rayHitList);
+				}
+
+				lap(report.queries);
+			}
+
+			if(bDeterministic && report.mismatchFrame == CPhysicsRecorder::INVALID_FRAME)
+			{ // Verify trajectories.
+				m_physicsWorld.GetBodies(m_bodyList);
+				const CPhysicsRecorder::BodyEntry* pBodyList = recording.GetBodies(frame);
+
+				for(u32 i = 0; i < max(frame.bodies.count, static_cast<u32>(m_bodyList.size())); ++i)
+				{
+					if(i >= frame.bodies.count || i >= m_bodyList.size() || !SameBody(pBodyList[i], m_bodyList[i]))
+					{
+						report.mismatchFrame = f;
+						report.mismatchHash = i < m_bodyList.size() ? m_bodyList[i].hash : pBodyList[i].hash;
+						break;
+					}
+				}
+			}
+
+			++report.frameCount;
+		}
+	}
+
 	//-----------------------------------------------------------------------------------------------
 	// Processor and query methods.
 	//-----------------------------------------------------------------------------------------------
 
-	void CPhysics::ProcessColliderUpdates()
+	// Method for applying every collider change queued since the last tick, in one pass.
+	void CPhysics::ProcessColliderUpdates(CPhysicsRecorder* pRecorder)
 	{
-		{ // Process deleted colliders.
-			CVolume* pVolume;
-			while(m_deletionQueue.TryPopFront(pVolume))
+		m_colliderQueue.Consume([this, pRecorder](ColliderCommand& command){
+			if(pRecorder) pRecorder->RecordCollider(static_cast<u32>(command.type), command.hash, command.world);
+
+			switch(command.type)
 			{
-				m_physicsWorld.RemoveVolume(pVolume);
+				case ColliderCommand::Type::Insert:
+				{
+					m_volumeMap.insert({ command.hash, command.pVolume });
+					m_physicsWorld.AddVolume(command.pVolume);
+				} break;
+				case ColliderCommand::Type::Delete:
+				{
+					m_volumeMap.erase(command.hash);
+					m_physicsWorld.RemoveVolume(command.pVolume);
+				} break;
+				case ColliderCommand::Type::Dirty:
+				{
+					auto elem = m_volumeMap.find(command.hash);
+					if(elem != m_volumeMap.end())
+					{
+						m_physicsWorld.UpdateVolume(elem->second, command.world);
+					}
+				} break;
 			}
+		});
+
+		m_wakeQueue.Consume([this, pRecorder](CAABBTree::AABB& aabb){
+			if(pRecorder) pRecorder->RecordWake(aabb);
+			m_physicsWorld.WakeRegion(aabb);
+		});
+
+		m_focusQueue.Consume([this, pRecorder](Math::Vector3& focus){
+			if(pRecorder) pRecorder->RecordFocus(focus);
+			m_physicsWorld.SetFocus(focus);
+		});
+	}
+
+	// Method for publishing the solved step to readers on other threads.
+	void CPhysics::PublishSnapshot()
+	{
+		m_snapshotIndex ^= 1;
+
+		std::shared_ptr<CPhysicsSnapshot>& pSnapshot = m_snapshotList[m_snapshotIndex];
+		if(pSnapshot == nullptr || pSnapshot.use_count() > 1)
+		{ // Readers still hold the buffer, so it's left to them and the snapshot is built from scratch.
+			pSnapshot = std::make_shared<CPhysicsSnapshot>();
 		}
 
-		{ // Process inserted colliders.
-			CVolume* pVolume;
-			while(m_insertionQueue.TryPopFront(pVolume))
+		// Make sure the last reader is done with the buffer before it's overwritten.
+		std::atomic_thread_fence(std::memory_order_acquire);
+
+		m_physicsWorld.BuildSnapshot(*pSnapshot);
+
+		std::lock_guard<std::mutex> lk(m_snapshotMutex);
+		m_snapshot = pSnapshot;
+	}
+
+	// Method for resolving the queries queued since the last tick against the snapshot just published.
+	void CPhysics::ProcessQueries(CPhysicsRecorder* pRecorder)
+	{
+		u32 queryCount = 0;
+		u64 latency = 0;
+		auto countLatency = [&queryCount, &latency](const std::chrono::steady_clock::time_point& time){
+			latency += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - time).count();
+			++queryCount;
+		};
+
+		const CPhysicsSnapshot& snapshot = *m_snapshotList[m_snapshotIndex];
+
+		m_queryRayQueue.Consume([this, pRecorder, &snapshot, &countLatency](PendingQuery<QueryRay>& pending){
+			if(pRecorder) pRecorder->RecordRay(pending.query.ray);
+
+			m_rayHitList.clear();
+			snapshot.CastRay(pending.query, m_rayHitList);
+			pending.query.callback(m_rayHitList);
+			countLatency(pending.time);
+		});
+
+		m_queryRayBatchQueue.Consume([pRecorder, &snapshot, &countLatency](PendingQuery<QueryRayBatch>& pending){
+			if(pRecorder)
 			{
-				m_physicsWorld.AddVolume(pVolume);
+				for(u32 i = 0; i < pending.query.count; ++i)
+				{
+					pRecorder->RecordRay(pending.query.pRayList[i]);
+				}
+			}
+
+			const u32 hitCount = snapshot.CastRays(pending.query.pRayList, pending.query.pHitList, pending.query.count);
+			if(pending.query.callback) { pending.query.callback(hitCount); }
+			countLatency(pending.time);
+		});
+
+		{ // Process sweeps. Every sweep is resolved before any callback runs.
+			m_querySweepQueue.Consume([this](PendingQuery<QuerySweep>& pending){
+				m_querySweepList.push_back(std::move(pending.query));
+				m_queryTimeList.push_back(pending.time);
+			});
+
+			const u32 count = static_cast<u32>(m_querySweepList.size());
+			m_sweepInfoList.resize(count);
+			m_sweepHitList.resize(count);
+
+			for(u32 i = 0; i < count; ++i)
+			{
+				m_sweepHitList[i] = snapshot.Sweep(m_querySweepList[i].volume, m_querySweepList[i].displacement, m_sweepInfoList[i]);
 			}
-		}
 
-		{ // Process dirty colliders.
-			std::pair<CVolume*, Math::SIMDMatrix> elem;
-			while(m_dirtyQueue.TryPopFront(elem))
+			for(u32 i = 0; i < count; ++i)
 			{
-				m_physicsWorld.UpdateVolume(elem.first, elem.second);
+				if(m_querySweepList[i].callback) { m_querySweepList[i].callback(m_sweepHitList[i] != 0, m_sweepInfoList[i]); }
 			}
+
+			m_querySweepList.clear();
 		}
-	}
 
-	void CPhysics::ProcessQueries()
-	{
-		{ // Process rays.
-			QueryRay ray;
-			while(m_queryRayQueue.TryPopFront(ray))
+		{ // Process overlaps. Results are gathered into one list, and each callback gets its own range of it.
+			m_queryOverlapQueue.Consume([this](PendingQuery<QueryOverlap>& pending){
+				m_queryOverlapList.push_back(std::move(pending.query));
+				m_queryTimeList.push_back(pending.time);
+			});
+
+			const u32 count = static_cast<u32>(m_queryOverlapList.size());
+			m_overlapInfoList.clear();
+			m_overlapCountList.resize(count);
+
+			for(u32 i = 0; i < count; ++i)
+			{
+				const u32 first = static_cast<u32>(m_overlapInfoList.size());
+				snapshot.Overlap(m_queryOverlapList[i].volume, m_overlapInfoList);
+				m_overlapCountList[i] = static_cast<u32>(m_overlapInfoList.size()) - first;
+			}
+
+			u32 first = 0;
+			for(u32 i = 0; i < count; ++i)
 			{
-				m_physicsWorld.CastRay(ray);
+				if(m_queryOverlapList[i].callback) { m_queryOverlapList[i].callback(m_overlapInfoList.data() + first, m_overlapCountList[i]); }
+				first += m_overlapCountList[i];
 			}
+
+			m_queryOverlapList.clear();
+		}
+
+		for(const auto& time : m_queryTimeList)
+		{
+			countLatency(time);
+		}
+
+		m_queryTimeList.clear();
+
+		if(queryCount)
+		{
+			m_stats.Count(CPhysicsStats::Metric::QueryCount, queryCount);
+			m_stats.Count(CPhysicsStats::Metric::QueryLatency, static_cast<u32>(latency));
 		}
 	}
 };
@@ -12,12 +12,18 @@
 #define CPHYSICS_H
 
 #include "CPhysicsWorld.h"
+#include "CGJK.h"
 #include "CPhysicsUpdate.h"
 #include "CPhysicsData.h"
+#include "CPhysicsRecorder.h"
+#include "CPhysicsStats.h"
+#include "CPhysicsSnapshot.h"
 #include "../Globals/CGlobals.h"
 #include "../Objects/CVObject.h"
-#include "../Utilities/CTSDeque.h"
+#include "../Utilities/CCommandQueue.h"
+#include <chrono>
 #include <future>
+#include <memory>
 #include <mutex>
 #include <unordered_map>
 
@@ -35,6 +41,18 @@ namespace Physics
 			u32 idleIterations;
 			u32 rayCastIterations;
 			Math::SIMDVector gravity;
+
+			// Partitioning of the world around the focus, and how often each region steps.
+			RegionData regions;
+
+			// Optional hook for solving islands on other threads. Islands are solved serially without it.
+			ParallelFor parallelFor;
+
+			// Optional hook for running snapshot queries on other threads. They run on the calling thread without it.
+			RunAsync runAsync;
+
+			// Optional recorder for every tick's input. The recording is complete once the thread has halted.
+			CPhysicsRecorder* pRecorder;
 		};
 
 	public:
@@ -56,10 +74,29 @@ namespace Physics
 		void Initialize();
 		void Halt();
 		void Release();
+		void Replay(const CPhysicsRecorder& recording, bool bDeterministic, CPhysicsRecorder::Report& report);
 
 		void CastRay(const QueryRay& query);
+		void CastRays(const QueryRayBatch& query);
+		void Sweep(const QuerySweep& query);
+		void Overlap(const QueryOverlap& query);
+
+		// Queries against the last published snapshot. They never wait on the physics thread, and hit volumes
+		//  have to outlive the future being read. Rays that hit nothing are left with a null volume.
+		std::future<std::vector<RaycastInfo>> CastRayAsync(const Math::CSIMDRay& ray);
+		std::future<u32> CastRaysAsync(const Math::CSIMDRay* pRayList, RaycastInfo* pHitList, u32 count);
+		std::future<SweepInfo> SweepAsync(const QueryVolume& volume, const Math::SIMDVector& displacement);
+		std::future<std::vector<OverlapInfo>> OverlapAsync(const QueryVolume& volume);
+
+		// Sweep against the live world for physics updates, such as character controllers. Physics thread only.
+		inline bool SweepImmediate(const class CVolume* pShape, const Math::SIMDVector& displacement, const class CVolume* pIgnore, SweepInfo& info) const
+		{
+			return m_physicsWorld.Sweep(pShape, displacement, pIgnore, info);
+		}
 
 		void MarkObjectAsDirty(const CVObject* pObject, const Math::SIMDMatrix& world);
+		void WakeRegion(const Math::Vector3& mn, const Math::Vector3& mx);
+		void SetFocus(const Math::Vector3& focus);
 
 		// Registrars.
 		inline void CreatePhysicsUpdate(CPhysicsUpdateRef* pRef, const CVObject* pObject) { m_physicsUpdateBatch.Pull(pRef, pObject); }
@@ -67,6 +104,14 @@ namespace Physics
 
 		// Accessors.
 		inline const Data& GetData() const { return m_data; }
+		inline CPhysicsStats& GetStats() { return m_stats; }
+
+		// Snapshot of the last finished tick, empty before the first one. Safe to hold and query from any thread.
+		inline std::shared_ptr<const CPhysicsSnapshot> GetSnapshot() const
+		{
+			std::lock_guard<std::mutex> lk(m_snapshotMutex);
+			return m_snapshot;
+		}
 
 		// Modifiers.
 		inline void SetData(const Data& data) { m_data = data; }
@@ -78,20 +123,110 @@ namespace Physics
 	private:
 		void PhysicsThread(std::promise<void> p);
 
-		void ProcessColliderUpdates();
-		void ProcessQueries();
+		void ProcessColliderUpdates(CPhysicsRecorder* pRecorder);
+		void ProcessQueries(CPhysicsRecorder* pRecorder);
+		void RecordInputs(CPhysicsRecorder& recorder);
+		void RecordBodies(CPhysicsRecorder& recorder);
+		void PublishSnapshot();
+
+		// Method for running a query against the current snapshot through the async hook.
+		template<typename T, typename F>
+		std::future<T> RunQuery(F query)
+		{
+			auto pTask = std::make_shared<QueryTask<T>>();
+			pTask->task = std::packaged_task<T()>([this, query, pSnapshot = GetSnapshot(), time = std::chrono::steady_clock::now()](){
+				T res { };
+				query(*pSnapshot, res);
+
+				// Worker threads rarely solve islands, so their GJK counts are handed over here rather than left for one.
+				CGJK::FlushStats(m_stats);
+
+				m_stats.Count(CPhysicsStats::Metric::QueryCount, 1);
+				m_stats.Count(CPhysicsStats::Metric::QueryLatency, static_cast<u32>(
+					std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - time).count()));
+				return res;
+			});
+
+			std::future<T> future = pTask->task.get_future();
+			if(m_data.runAsync) { m_data.runAsync(pTask); }
+			else { pTask->Run(); }
+
+			return future;
+		}
 
 	private:
-		mutable std::mutex m_mutex;
+		// Query handed to the async hook. The future is taken from the task before it's queued.
+		template<typename T>
+		struct QueryTask : public AsyncTask
+		{
+			std::packaged_task<T()> task;
 
+			virtual void Run() final { task(); }
+		};
+
+		// Change to the set of volumes. Commands from every thread share one queue, so they apply in the order they were made.
+		struct ColliderCommand
+		{
+			enum class Type
+			{
+				Insert,
+				Delete,
+				Dirty,
+			};
+
+			Type type;
+			class CVolume* pVolume;
+			u64 hash;
+			Math::SIMDMatrix world;
+		};
+
+		// Query waiting on the physics thread, stamped with when it was made so its latency can be measured.
+		template<typename T>
+		struct PendingQuery
+		{
+			T query;
+			std::chrono::steady_clock::time_point time;
+		};
+
+	private:
 		Data m_data;
 
 		CPhysicsUpdateBatch m_physicsUpdateBatch;
+		// Only touched by the physics thread.
 		std::unordered_map<u64, class CVolume*> m_volumeMap;
-		Util::CTSDeque<class CVolume*> m_insertionQueue;
-		Util::CTSDeque<class CVolume*> m_deletionQueue;
-		Util::CTSDeque<std::pair<class CVolume*, Math::SIMDMatrix>> m_dirtyQueue;
-		Util::CTSDeque<QueryRay> m_queryRayQueue;
+
+		Util::CCommandQueue<ColliderCommand> m_colliderQueue;
+		Util::CCommandQueue<CAABBTree::AABB> m_wakeQueue;
+		Util::CCommandQueue<Math::Vector3> m_focusQueue;
+		Util::CCommandQueue<PendingQuery<QueryRay>> m_queryRayQueue;
+		Util::CCommandQueue<PendingQuery<QueryRayBatch>> m_queryRayBatchQueue;
+		Util::CCommandQueue<PendingQuery<QuerySweep>> m_querySweepQueue;
+		Util::CCommandQueue<PendingQuery<QueryOverlap>> m_queryOverlapQueue;
+
+		// Shape queries drained from their queues each step and resolved as one batch.
+		std::vector<QuerySweep> m_querySweepList;
+		std::vector<QueryOverlap> m_queryOverlapList;
+		std::vector<std::chrono::steady_clock::time_point> m_queryTimeList;
+		std::vector<SweepInfo> m_sweepInfoList;
+		std::vector<u8> m_sweepHitList;
+		std::vector<OverlapInfo> m_overlapInfoList;
+		std::vector<u32> m_overlapCountList;
+		std::vector<RaycastInfo> m_rayHitList;
+
+		// Snapshot of the last finished tick. The physics thread builds into whichever of its two buffers
+		//  it published longest ago, or a fresh one while a reader still holds that buffer. The mutex only
+		//  guards swapping the published pointer, never the build.
+		mutable std::mutex m_snapshotMutex;
+		std::shared_ptr<const CPhysicsSnapshot> m_snapshot;
+		std::shared_ptr<CPhysicsSnapshot> m_snapshotList[2];
+		u32 m_snapshotIndex;
+
+		CPhysicsStats m_stats;
+
+		// Scratch lists for recording and replays.
+		std::vector<CPhysicsRecorder::InputEntry> m_lastInputList;
+		std::vector<CPhysicsRecorder::InputEntry> m_inputList;
+		std::vector<CPhysicsRecorder::BodyEntry> m_bodyList;
 
 		Abool m_exitFlag;
 		std::future<void> m_futureExit;
@@ -12,7 +12,10 @@
 #define CPHYSICSDATA_H
 
 #include "../Math/CSIMDRay.h"
+#include "../Math/CSIMDQuaternion.h"
+#include "../Math/CMathVector3.h"
 #include <functional>
+#include <memory>
 #include <vector>
 
 namespace Physics
@@ -33,6 +36,27 @@ namespace Physics
 		int index;
 	};
 
+	// Resting contact against one feature of a volume, such as a chunk's block. The offset is the rigidbody's
+	//  position relative to the volume when the distance was measured.
+	struct ManifoldPoint
+	{
+		int feature;
+		u32 step;
+		float distance;
+		Math::SIMDVector normal;
+		Math::SIMDVector offset;
+	};
+
+	// Resting contacts between a rigidbody and one volume, kept from step to step.
+	struct ContactManifold
+	{
+		static const u32 MAX_POINTS = 4;
+
+		const class CVolume* pVolume;
+		u32 pointCount;
+		ManifoldPoint pointList[MAX_POINTS];
+	};
+
 	struct RaycastInfo
 	{
 		int index;
@@ -46,6 +70,90 @@ namespace Physics
 		Math::CSIMDRay ray;
 		std::function<void(const std::vector<RaycastInfo>&)> callback;
 	};
+
+	// Rays resolved together. Hit i receives the closest hit of ray i, or a null volume on a miss.
+	//  Both lists belong to the caller and have to stay alive until the callback runs.
+	struct QueryRayBatch
+	{
+		const Math::CSIMDRay* pRayList;
+		RaycastInfo* pHitList;
+		u32 count;
+		std::function<void(u32 hitCount)> callback;
+	};
+
+	enum class QueryShape
+	{
+		Sphere,
+		Capsule,
+		OBB,
+	};
+
+	// Shape swept or tested by a query. Spheres use the radius, capsules the radius and height, and boxes the half size.
+	struct QueryVolume
+	{
+		QueryShape shape;
+		Math::SIMDVector position;
+		Math::SIMDQuaternion rotation;
+		Math::Vector3 halfSize;
+		float radius;
+		float height;
+	};
+
+	struct SweepInfo
+	{
+		int index;
+		float interval;
+		const class CVolume* pVolume;
+		Math::SIMDVector point;
+		Math::SIMDVector normal;
+	};
+
+	struct OverlapInfo
+	{
+		int index;
+		const class CVolume* pVolume;
+	};
+
+	// Sweeps the volume along the displacement. The interval of a hit is the fraction of the displacement covered before contact.
+	struct QuerySweep
+	{
+		QueryVolume volume;
+		Math::SIMDVector displacement;
+		std::function<void(bool bHit, const SweepInfo& info)> callback;
+	};
+
+	// Finds every volume intersecting the shape. Grid volumes report one entry per overlapped cell.
+	struct QueryOverlap
+	{
+		QueryVolume volume;
+		std::function<void(const OverlapInfo* pInfoList, u32 count)> callback;
+	};
+
+	// How the world is split into cubic regions around a focus, usually the player. Regions line up with chunks when the
+	//  size matches the chunk size, and radii are counted in regions from the one holding the focus.
+	struct RegionData
+	{
+		float size = 32.0f;
+
+		// Regions within the near radius step every tick, and regions within the far radius step once every far
+		//  interval ticks over the whole interval. Anything farther is frozen until the focus comes back.
+		u32 nearRadius = 2;
+		u32 farRadius = 6;
+		u32 farInterval = 4;
+	};
+
+	// Runs task(0) to task(count - 1), possibly in parallel, and returns once all of them are done.
+	typedef std::function<void(u32 count, const std::function<void(u32)>& task)> ParallelFor;
+
+	// Work handed to the async hook. Shared, so the hook only has to hold onto a pointer until it runs.
+	struct AsyncTask
+	{
+		virtual ~AsyncTask() { }
+		virtual void Run() = 0;
+	};
+
+	// Starts the task on another thread and returns without waiting for it.
+	typedef std::function<void(const std::shared_ptr<AsyncTask>& pTask)> RunAsync;
 };
 
 #endif
@@ -0,0 +1,178 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Copyright (c) Ryan Alasandro
+//
+// Static Library: Core Engine
+//
+// File: Physics/CPhysicsRecorder.cpp
+//
+//-------------------------------------------------------------------------------------------------
+
+#include "CPhysicsRecorder.h"
+#include <fstream>
+
+namespace Physics
+{
+	static const u32 RECORDING_MAGIC = 0x52535950; // "PYSR"
+	static const u32 RECORDING_VERSION = 2;
+
+	CPhysicsRecorder::CPhysicsRecorder() { }
+
+	CPhysicsRecorder::~CPhysicsRecorder() { }
+
+	//-----------------------------------------------------------------------------------------------
+	// Record methods.
+	//-----------------------------------------------------------------------------------------------
+
+	// Method for starting a tick. Every entry recorded after this belongs to the new frame.
+	void CPhysicsRecorder::BeginFrame(float delta)
+	{
+		Frame frame;
+		frame.delta = delta;
+		frame.colliders = { static_cast<u32>(m_colliderList.size()), 0 };
+		frame.wakes = { static_cast<u32>(m_wakeList.size()), 0 };
+		frame.focuses = { static_cast<u32>(m_focusList.size()), 0 };
+		frame.inputs = { static_cast<u32>(m_inputList.size()), 0 };
+		frame.rays = { static_cast<u32>(m_rayList.size()), 0 };
+		frame.bodies = { static_cast<u32>(m_bodyList.size()), 0 };
+		m_frameList.push_back(frame);
+	}
+
+	void CPhysicsRecorder::RecordCollider(u32 type, u64 hash, const Math::SIMDMatrix& world)
+	{
+		m_colliderList.push_back({ type, hash, world });
+		++m_frameList.back().colliders.count;
+	}
+
+	void CPhysicsRecorder::RecordWake(const CAABBTree::AABB& aabb)
+	{
+		m_wakeList.push_back(aabb);
+		++m_frameList.back().wakes.count;
+	}
+
+	void CPhysicsRecorder::RecordFocus(const Math::Vector3& focus)
+	{
+		m_focusList.push_back(focus);
+		++m_frameList.back().focuses.count;
+	}
+
+	void CPhysicsRecorder::RecordInput(u64 hash, const CRigidbody::Input& input)
+	{
+		m_inputList.push_back({ hash, input });
+		++m_frameList.back().inputs.count;
+	}
+
+	void CPhysicsRecorder::RecordRay(const Math::CSIMDRay& ray)
+	{
+		m_rayList.push_back(ray);
+		++m_frameList.back().rays.count;
+	}
+
+	void CPhysicsRecorder::RecordBody(u64 hash, const Math::Vector3& position, const Math::Vector4& rotation)
+	{
+		m_bodyList.push_back({ hash, position, rotation });
+		++m_frameList.back().bodies.count;
+	}
+
+	void CPhysicsRecorder::Clear()
+	{
+		m_frameList.clear();
+		m_colliderList.clear();
+		m_wakeList.clear();
+		m_focusList.clear();
+		m_inputList.clear();
+		m_rayList.clear();
+		m_bodyList.clear();
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// File methods.
+	//-----------------------------------------------------------------------------------------------
+
+	// Every entry is plain data, so each list is written as its size followed by its raw contents.
+	template<typename T>
+	static void WriteList(std::ofstream& output, const std::vector<T>& list)
+	{
+		const u32 sz = static_cast<u32>(list.size());
+		output.write(reinterpret_cast<const char*>(&sz), sizeof(sz));
+		output.write(reinterpret_cast<const char*>(list.data()), sizeof(T) * sz);
+	}
+
+	template<typename T>
+	static void ReadList(std::ifstream& input, std::vector<T>& list)
+	{
+		u32 sz = 0;
+		input.read(reinterpret_cast<char*>(&sz), sizeof(sz));
+		if(!input) { return; }
+
+		list.resize(sz);
+		input.read(reinterpret_cast<char*>(list.data()), sizeof(T) * sz);
+	}
+
+	// Method for checking that a frame's range lies within its list.
+	template<typename T>
+	static bool InRange(const CPhysicsRecorder::Range& range, const std::vector<T>& list)
+	{
+		return static_cast<u64>(range.first) + range.count <= list.size();
+	}
+
+	bool CPhysicsRecorder::Save(const std::string& filename) const
+	{
+		std::ofstream output(filename, std::ios::binary);
+		if(!output.is_open()) { return false; }
+
+		output.write(reinterpret_cast<const char*>(&RECORDING_MAGIC), sizeof(RECORDING_MAGIC));
+		output.write(reinterpret_cast<const char*>(&RECORDING_VERSION), sizeof(RECORDING_VERSION));
+
+		WriteList(output, m_frameList);
+		WriteList(output, m_colliderList);
+		WriteList(output, m_wakeList);
+		WriteList(output, m_focusList);
+		WriteList(output, m_inputList);
+		WriteList(output, m_rayList);
+		WriteList(output, m_bodyList);
+
+		return output.good();
+	}
+
+	bool CPhysicsRecorder::Load(const std::string& filename)
+	{
+		Clear();
+
+		std::ifstream input(filename, std::ios::binary);
+		if(!input.is_open()) { return false; }
+
+		u32 magic = 0;
+		u32 version = 0;
+		input.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+		input.read(reinterpret_cast<char*>(&version), sizeof(version));
+		if(magic != RECORDING_MAGIC || version != RECORDING_VERSION) { return false; }
+
+		ReadList(input, m_frameList);
+		ReadList(input, m_colliderList);
+		ReadList(input, m_wakeList);
+		ReadList(input, m_focusList);
+		ReadList(input, m_inputList);
+		ReadList(input, m_rayList);
+		ReadList(input, m_bodyList);
+
+		if(!input)
+		{
+			Clear();
+			return false;
+		}
+
+		// A corrupt recording could point frames past the end of a list, which replay reads without checking.
+		for(const Frame& frame : m_frameList)
+		{
+			if(!InRange(frame.colliders, m_colliderList) || !InRange(frame.wakes, m_wakeList) || !InRange(frame.focuses, m_focusList) ||
+				!InRange(frame.inputs, m_inputList) || !InRange(frame.rays, m_rayList) || !InRange(frame.bodies, m_bodyList))
+			{
+				Clear();
+				return false;
+			}
+		}
+
+		return true;
+	}
+};
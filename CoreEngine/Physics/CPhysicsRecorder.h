@@ -0,0 +1,140 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Copyright (c) Ryan Alasandro
+//
+// Static Library: Core Engine
+//
+// File: Physics/CPhysicsRecorder.h
+//
+//-------------------------------------------------------------------------------------------------
+
+#ifndef CPHYSICSRECORDER_H
+#define CPHYSICSRECORDER_H
+
+#include "CAABBTree.h"
+#include "CRigidbody.h"
+#include "../Globals/CGlobals.h"
+#include "../Math/CSIMDMatrix.h"
+#include "../Math/CSIMDRay.h"
+#include "../Math/CMathVector3.h"
+#include "../Math/CMathVector4.h"
+#include <string>
+#include <vector>
+
+namespace Physics
+{
+	// Everything the physics thread took in over a run, one frame per tick, along with the rigidbody transforms each tick
+	//  produced. Volumes are referred to by object hash, so a recording can be replayed against the same scene in a later run.
+	class CPhysicsRecorder
+	{
+	public:
+		static const u32 INVALID_FRAME = ~0U;
+
+		// Range of one of the entry lists.
+		struct Range
+		{
+			u32 first;
+			u32 count;
+		};
+
+		struct Frame
+		{
+			float delta;
+			Range colliders;
+			Range wakes;
+			Range focuses;
+			Range inputs;
+			Range rays;
+			Range bodies;
+		};
+
+		// Collider command, with type matching CPhysics' collider command types.
+		struct ColliderEntry
+		{
+			u32 type;
+			u64 hash;
+			Math::SIMDMatrix world;
+		};
+
+		// Rigidbody input changed by a physics update.
+		struct InputEntry
+		{
+			u64 hash;
+			CRigidbody::Input input;
+		};
+
+		struct BodyEntry
+		{
+			u64 hash;
+			Math::Vector3 position;
+			Math::Vector4 rotation;
+		};
+
+		// Milliseconds spent in one phase of the step, over a whole replay.
+		struct PhaseTime
+		{
+			float totalMs;
+			float maxMs;
+
+			inline void Add(float ms) { totalMs += ms; maxMs = ms > maxMs ? ms : maxMs; }
+		};
+
+		struct Report
+		{
+			u32 frameCount;
+
+			// First frame whose rigidbody transforms differ from the recording, and the rigidbody that differed.
+			u32 mismatchFrame;
+			u64 mismatchHash;
+
+			PhaseTime colliders;
+			PhaseTime inputs;
+			PhaseTime forceFields;
+			PhaseTime rigidbodies;
+			PhaseTime solve;
+			PhaseTime queries;
+		};
+
+	public:
+		CPhysicsRecorder();
+		~CPhysicsRecorder();
+		CPhysicsRecorder(const CPhysicsRecorder&) = delete;
+		CPhysicsRecorder(CPhysicsRecorder&&) = delete;
+		CPhysicsRecorder& operator = (const CPhysicsRecorder&) = delete;
+		CPhysicsRecorder& operator = (CPhysicsRecorder&&) = delete;
+
+		void BeginFrame(float delta);
+		void RecordCollider(u32 type, u64 hash, const Math::SIMDMatrix& world);
+		void RecordWake(const CAABBTree::AABB& aabb);
+		void RecordFocus(const Math::Vector3& focus);
+		void RecordInput(u64 hash, const CRigidbody::Input& input);
+		void RecordRay(const Math::CSIMDRay& ray);
+		void RecordBody(u64 hash, const Math::Vector3& position, const Math::Vector4& rotation);
+		void Clear();
+
+		bool Save(const std::string& filename) const;
+		bool Load(const std::string& filename);
+
+		// Accessors.
+		inline u32 GetFrameCount() const { return static_cast<u32>(m_frameList.size()); }
+		inline const Frame& GetFrame(u32 frame) const { return m_frameList[frame]; }
+
+		inline const ColliderEntry* GetColliders(const Frame& frame) const { return m_colliderList.data() + frame.colliders.first; }
+		inline const CAABBTree::AABB* GetWakes(const Frame& frame) const { return m_wakeList.data() + frame.wakes.first; }
+		inline const Math::Vector3* GetFocuses(const Frame& frame) const { return m_focusList.data() + frame.focuses.first; }
+		inline const InputEntry* GetInputs(const Frame& frame) const { return m_inputList.data() + frame.inputs.first; }
+		inline const Math::CSIMDRay* GetRays(const Frame& frame) const { return m_rayList.data() + frame.rays.first; }
+		inline const BodyEntry* GetBodies(const Frame& frame) const { return m_bodyList.data() + frame.bodies.first; }
+
+	private:
+		std::vector<Frame> m_frameList;
+		std::vector<ColliderEntry> m_colliderList;
+		std::vector<CAABBTree::AABB> m_wakeList;
+		std::vector<Math::Vector3> m_focusList;
+		std::vector<InputEntry> m_inputList;
+		std::vector<Math::CSIMDRay> m_rayList;
+		std::vector<BodyEntry> m_bodyList;
+	};
+};
+
+#endif
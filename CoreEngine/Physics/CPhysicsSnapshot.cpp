@@ -0,0 +1,246 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Copyright (c) Ryan Alasandro
+//
+// Static Library: Core Engine
+//
+// File: Physics/CPhysicsSnapshot.cpp
+//
+//-------------------------------------------------------------------------------------------------
+
+#include "CPhysicsSnapshot.h"
+#include "CVolume.h"
+#include <Windows.h>
+#include <cstdint>
+
+namespace Physics
+{
+	CPhysicsSnapshot::CPhysicsSnapshot() :
+		m_build(0)
+	{
+	}
+
+	CPhysicsSnapshot::~CPhysicsSnapshot()
+	{
+		for(auto& elem : m_copyMap)
+		{
+			delete elem.second.pVolume;
+		}
+
+		for(const CVolume* pVolume : m_sharedList)
+		{
+			pVolume->ReleaseSnapshotRef();
+		}
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// Build methods.
+	//-----------------------------------------------------------------------------------------------
+
+	// Method for copying the live trees. Physics thread only, and never while the snapshot is being queried.
+	void CPhysicsSnapshot::Build(const CAABBTree& broadphase, const CAABBTree& rayTree)
+	{
+		++m_build;
+		m_entryList.clear();
+		m_entryMap.clear();
+
+		// The last build's references are only let go once this build holds its own, so a volume in both never drops to zero.
+		m_releaseList.swap(m_sharedList);
+		m_sharedList.clear();
+
+		CopyTree(m_broadphase, broadphase);
+		CopyTree(m_rayTree, rayTree);
+
+		for(const CVolume* pVolume : m_releaseList)
+		{
+			pVolume->ReleaseSnapshotRef();
+		}
+
+		m_releaseList.clear();
+
+		// Proxies hold entry indices until every entry has been made, since the entry list may grow while copying.
+		auto toEntry = [this](void* pUserData){
+			return static_cast<void*>(&m_entryList[reinterpret_cast<uintptr_t>(pUserData)]);
+		};
+
+		m_broadphase.RemapUserData(toEntry);
+		m_rayTree.RemapUserData(toEntry);
+
+		// Drop the copies of volumes that left the world.
+		for(auto elem = m_copyMap.begin(); elem != m_copyMap.end();)
+		{
+			if(elem->second.build != m_build)
+			{
+				delete elem->second.pVolume;
+				elem = m_copyMap.erase(elem);
+			}
+			else
+			{
+				++elem;
+			}
+		}
+	}
+
+	// Method for copying one tree and pointing its proxies at entries. A volume in both trees shares one entry.
+	void CPhysicsSnapshot::CopyTree(CAABBTree& tree, const CAABBTree& source)
+	{
+		tree.CopyFrom(source);
+		tree.RemapUserData([this](void* pUserData){
+			const CVolume* pSource = reinterpret_cast<const CVolume*>(pUserData);
+
+			auto elem = m_entryMap.find(pSource);
+			if(elem != m_entryMap.end()) { return reinterpret_cast<void*>(static_cast<uintptr_t>(elem->second)); }
+
+			Copy& copy = m_copyMap[pSource];
+			CVolume* pCopy = pSource->CopyShape(copy.pVolume);
+			if(pCopy != copy.pVolume) { delete copy.pVolume; }
+
+			copy.pVolume = pCopy;
+			copy.build = m_build;
+
+			if(pCopy == nullptr)
+			{
+				pSource->AddSnapshotRef();
+				m_sharedList.push_back(pSource);
+			}
+
+			const u32 index = static_cast<u32>(m_entryList.size());
+			m_entryList.push_back({ pCopy ? pCopy : pSource, pSource });
+			m_entryMap.insert({ pSource, index });
+
+			return reinterpret_cast<void*>(static_cast<uintptr_t>(index));
+		});
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// Query methods.
+	//-----------------------------------------------------------------------------------------------
+
+	void CPhysicsSnapshot::CastRay(const QueryRay& query, std::vector<RaycastInfo>& hitList) const
+	{
+		RaycastInfo info;
+
+		CAABBTree::RayPacket packet;
+		CAABBTree::LoadRayPacket(&query.ray, 1, packet);
+
+		m_rayTree.QueryRays(packet, [&](void* pUserData, u32 mask){
+			const Entry& entry = *reinterpret_cast<const Entry*>(pUserData);
+			if(entry.pShape->RayTest(query, info))
+			{
+				info.pVolume = entry.pSource;
+				hitList.push_back(info);
+			}
+		});
+	}
+
+	// Method for resolving the closest hit of many rays. Rays go through the ray tree four at a time,
+	//  and every hit shortens its lane so the rest of the traversal culls anything farther away.
+	u32 CPhysicsSnapshot::CastRays(const Math::CSIMDRay* pRayList, RaycastInfo* pHitList, u32 count) const
+	{
+		u32 hitCount = 0;
+
+		for(u32 base = 0; base < count; base += 4)
+		{
+			const u32 laneCount = min(count - base, 4U);
+			const Math::CSIMDRay* pRays = pRayList + base;
+			RaycastInfo* pHits = pHitList + base;
+
+			QueryRay queryList[4];
+			alignas(16) float tMax[4] { };
+
+			for(u32 lane = 0; lane < laneCount; ++lane)
+			{
+				queryList[lane].ray = pRays[lane];
+				tMax[lane] = pRays[lane].GetDistance();
+
+				pHits[lane].index = -1;
+				pHits[lane].distance = tMax[lane];
+				pHits[lane].pVolume = nullptr;
+				pHits[lane].normal = Math::SIMD_VEC_ZERO;
+			}
+
+			CAABBTree::RayPacket packet;
+			CAABBTree::LoadRayPacket(pRays, laneCount, packet);
+
+			m_rayTree.QueryRays(packet, [&](void* pUserData, u32 mask){
+				const Entry& entry = *reinterpret_cast<const Entry*>(pUserData);
+
+				for(u32 lane = 0; lane < laneCount; ++lane)
+				{
+					if((mask & (1 << lane)) == 0) { continue; }
+
+					RaycastInfo info;
+					queryList[lane].ray.SetDistance(tMax[lane]);
+					if(entry.pShape->RayTest(queryList[lane], info) && info.distance <= tMax[lane])
+					{
+						info.pVolume = entry.pSource;
+						pHits[lane] = info;
+						tMax[lane] = info.distance;
+					}
+				}
+
+				packet.tMax = _mm_load_ps(tMax);
+			});
+		}
+
+		for(u32 i = 0; i < count; ++i)
+		{
+			hitCount += pHitList[i].pVolume != nullptr;
+		}
+
+		return hitCount;
+	}
+
+	// Method for finding the first volume hit along the displacement. The volume of a miss is null.
+	bool CPhysicsSnapshot::Sweep(const QueryVolume& volume, const Math::SIMDVector& displacement, SweepInfo& info) const
+	{
+		const CVolume* pShape = CVolume::PlaceQueryVolume(volume);
+		const Math::Vector3 position = *reinterpret_cast<const Math::Vector3*>(volume.position.ToFloat());
+		const Math::Vector3 offset = *reinterpret_cast<const Math::Vector3*>(displacement.ToFloat());
+
+		const CAABBTree::AABB aabb = CAABBTree::AABB::Swept({ position + pShape->GetMinExtents(), position + pShape->GetMaxExtents() }, offset);
+
+		info = { -1, 1.0f, nullptr, volume.position + displacement, Math::SIMD_VEC_ZERO };
+		bool bHit = false;
+
+		m_broadphase.Query(aabb, [&](void* pUserData){
+			const Entry& entry = *reinterpret_cast<const Entry*>(pUserData);
+
+			SweepInfo hit;
+			if(entry.pShape->SweepTest(pShape, displacement, hit) && hit.interval <= info.interval)
+			{
+				hit.pVolume = entry.pSource;
+				info = hit;
+				bHit = true;
+			}
+
+			return true;
+		});
+
+		return bHit;
+	}
+
+	// Method for appending every volume intersecting the shape to the list.
+	void CPhysicsSnapshot::Overlap(const QueryVolume& volume, std::vector<OverlapInfo>& infoList) const
+	{
+		const CVolume* pShape = CVolume::PlaceQueryVolume(volume);
+		const Math::Vector3 position = *reinterpret_cast<const Math::Vector3*>(volume.position.ToFloat());
+
+		CAABBTree::AABB aabb;
+		aabb.mn = position + pShape->GetMinExtents();
+		aabb.mx = position + pShape->GetMaxExtents();
+
+		m_broadphase.Query(aabb, [&](void* pUserData){
+			const Entry& entry = *reinterpret_cast<const Entry*>(pUserData);
+
+			const size_t first = infoList.size();
+			entry.pShape->OverlapTest(pShape, infoList);
+			for(size_t i = first; i < infoList.size(); ++i)
+			{
+				infoList[i].pVolume = entry.pSource;
+			}
+
+			return true;
+		});
+	}
+};
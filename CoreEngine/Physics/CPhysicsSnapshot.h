@@ -0,0 +1,76 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Copyright (c) Ryan Alasandro
+//
+// Static Library: Core Engine
+//
+// File: Physics/CPhysicsSnapshot.h
+//
+//-------------------------------------------------------------------------------------------------
+
+#ifndef CPHYSICSSNAPSHOT_H
+#define CPHYSICSSNAPSHOT_H
+
+#include "CPhysicsData.h"
+#include "CAABBTree.h"
+#include "../Globals/CGlobals.h"
+#include "../Math/CSIMDRay.h"
+#include <unordered_map>
+#include <vector>
+
+namespace Physics
+{
+	// Frozen copy of the broadphase and ray tree at the end of a tick. Shapes are copied at their solver placement, so
+	//  once built a snapshot can be queried from any number of threads while the physics thread moves on. Volumes that
+	//  can't be copied, like voxel chunks, are shared with the live world, and referenced so they can't be deregistered
+	//  while the snapshot still reaches them. Hits report the live volume, not the copy.
+	class CPhysicsSnapshot
+	{
+	public:
+		CPhysicsSnapshot();
+		~CPhysicsSnapshot();
+		CPhysicsSnapshot(const CPhysicsSnapshot&) = delete;
+		CPhysicsSnapshot(CPhysicsSnapshot&&) = delete;
+		CPhysicsSnapshot& operator = (const CPhysicsSnapshot&) = delete;
+		CPhysicsSnapshot& operator = (CPhysicsSnapshot&&) = delete;
+
+		void Build(const CAABBTree& broadphase, const CAABBTree& rayTree);
+
+		void CastRay(const QueryRay& query, std::vector<RaycastInfo>& hitList) const;
+		u32 CastRays(const Math::CSIMDRay* pRayList, RaycastInfo* pHitList, u32 count) const;
+		bool Sweep(const QueryVolume& volume, const Math::SIMDVector& displacement, SweepInfo& info) const;
+		void Overlap(const QueryVolume& volume, std::vector<OverlapInfo>& infoList) const;
+
+	private:
+		// What a tree proxy points at in the snapshot.
+		struct Entry
+		{
+			const class CVolume* pShape;
+			const class CVolume* pSource;
+		};
+
+		// Copy of a live volume, kept between builds so it can be refreshed in place.
+		struct Copy
+		{
+			class CVolume* pVolume;
+			u32 build;
+		};
+
+		void CopyTree(CAABBTree& tree, const CAABBTree& source);
+
+	private:
+		CAABBTree m_broadphase;
+		CAABBTree m_rayTree;
+		std::vector<Entry> m_entryList;
+
+		u32 m_build;
+		std::unordered_map<const class CVolume*, u32> m_entryMap;
+		std::unordered_map<const class CVolume*, Copy> m_copyMap;
+
+		// Live volumes the snapshot holds a reference to.
+		std::vector<const class CVolume*> m_sharedList;
+		std::vector<const class CVolume*> m_releaseList;
+	};
+};
+
+#endif
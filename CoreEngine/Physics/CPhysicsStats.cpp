@@ -0,0 +1,157 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Copyright (c) Ryan Alasandro
+//
+// Static Library: Core Engine
+//
+// File: Physics/CPhysicsStats.cpp
+//
+//-------------------------------------------------------------------------------------------------
+
+#include "CPhysicsStats.h"
+#include <cmath>
+#include <cstring>
+
+namespace Physics
+{
+	// Upper bound of the first histogram bucket for each metric.
+	static const float BUCKET_BASE[CPhysicsStats::METRIC_COUNT] = {
+		0.01f, 0.01f, 0.01f, 0.01f, 0.01f, 0.01f, // Phase timings.
+		1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, // Counts.
+		0.01f, // Query latency.
+	};
+
+	CPhysicsStats::CPhysicsStats() :
+		m_historyCount(0),
+		m_historyIndex(0),
+		m_working { },
+		m_sequence(0),
+		m_published { }
+	{
+		memset(m_sampleList, 0, sizeof(m_sampleList));
+		memset(m_historyList, 0, sizeof(m_historyList));
+
+		for(Au64& counter : m_counterList)
+		{
+			counter = 0;
+		}
+
+		m_lapTime = std::chrono::steady_clock::now();
+	}
+
+	CPhysicsStats::~CPhysicsStats() { }
+
+	//-----------------------------------------------------------------------------------------------
+	// Collection methods.
+	//-----------------------------------------------------------------------------------------------
+
+	// Method for starting the tick's phase timer. Physics thread only.
+	void CPhysicsStats::BeginTick()
+	{
+		m_lapTime = std::chrono::steady_clock::now();
+	}
+
+	// Method for charging the time since the last lap to a phase. Physics thread only.
+	void CPhysicsStats::Lap(Metric metric)
+	{
+		const auto now = std::chrono::steady_clock::now();
+		m_sampleList[static_cast<u32>(metric)] += std::chrono::duration<float, std::milli>(now - m_lapTime).count();
+		m_lapTime = now;
+	}
+
+	// Method for adding to a counter from any thread. Query latency is counted in microseconds.
+	void CPhysicsStats::Count(Metric metric, u32 amount)
+	{
+		m_counterList[static_cast<u32>(metric)].fetch_add(amount, std::memory_order_relaxed);
+	}
+
+	// Method for closing the tick and publishing a new snapshot. Physics thread only.
+	void CPhysicsStats::Publish()
+	{
+		u64 counterList[METRIC_COUNT];
+		for(u32 i = 0; i < METRIC_COUNT; ++i)
+		{
+			counterList[i] = m_counterList[i].exchange(0, std::memory_order_relaxed);
+		}
+
+		const u32 gjkCalls = static_cast<u32>(Metric::GJKCalls);
+		const u32 gjkIterations = static_cast<u32>(Metric::GJKIterations);
+		const u32 queryCount = static_cast<u32>(Metric::QueryCount);
+		const u32 queryLatency = static_cast<u32>(Metric::QueryLatency);
+
+		for(u32 i = 0; i < METRIC_COUNT; ++i)
+		{
+			float value = m_sampleList[i] + static_cast<float>(counterList[i]);
+			if(i == gjkIterations)
+			{
+				value = counterList[gjkCalls] ? static_cast<float>(counterList[i]) / counterList[gjkCalls] : 0.0f;
+			}
+			else if(i == queryLatency)
+			{
+				value = counterList[queryCount] ? static_cast<float>(counterList[i]) * 1e-3f / counterList[queryCount] : 0.0f;
+			}
+
+			m_historyList[i][m_historyIndex] = value;
+			m_sampleList[i] = 0.0f;
+		}
+
+		m_historyIndex = (m_historyIndex + 1) % HISTORY_SIZE;
+		m_historyCount = m_historyCount < HISTORY_SIZE ? m_historyCount + 1 : HISTORY_SIZE;
+		++m_working.tick;
+
+		// Rebuild the rolling stats from the history.
+		for(u32 i = 0; i < METRIC_COUNT; ++i)
+		{
+			MetricStats& stats = m_working.metricList[i];
+			stats.last = m_historyList[i][(m_historyIndex + HISTORY_SIZE - 1) % HISTORY_SIZE];
+			stats.min = stats.last;
+			stats.max = stats.last;
+			memset(stats.histogram, 0, sizeof(stats.histogram));
+
+			float total = 0.0f;
+			for(u32 h = 0; h < m_historyCount; ++h)
+			{
+				const float value = m_historyList[i][h];
+				total += value;
+				stats.min = value < stats.min ? value : stats.min;
+				stats.max = value > stats.max ? value : stats.max;
+
+				u32 bucket = 0;
+				if(value >= BUCKET_BASE[i])
+				{
+					bucket = 1 + static_cast<u32>(log2f(value / BUCKET_BASE[i]));
+					bucket = bucket < HISTOGRAM_BUCKETS ? bucket : HISTOGRAM_BUCKETS - 1;
+				}
+
+				++stats.histogram[bucket];
+			}
+
+			stats.average = total / m_historyCount;
+		}
+
+		// Sequence lock write.
+		const u32 sequence = m_sequence.load(std::memory_order_relaxed);
+		m_sequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		memcpy(&m_published, &m_working, sizeof(Snapshot));
+
+		m_sequence.store(sequence + 2, std::memory_order_release);
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// Read methods.
+	//-----------------------------------------------------------------------------------------------
+
+	// Method for copying the last published snapshot. Retries if the physics thread publishes mid copy.
+	void CPhysicsStats::Read(Snapshot& snapshot) const
+	{
+		u32 sequence;
+		do
+		{
+			sequence = m_sequence.load(std::memory_order_acquire);
+			memcpy(&snapshot, &m_published, sizeof(Snapshot));
+			std::atomic_thread_fence(std::memory_order_acquire);
+		} while((sequence & 1) || sequence != m_sequence.load(std::memory_order_relaxed));
+	}
+};
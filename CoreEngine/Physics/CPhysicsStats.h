@@ -0,0 +1,102 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Copyright (c) Ryan Alasandro
+//
+// Static Library: Core Engine
+//
+// File: Physics/CPhysicsStats.h
+//
+//-------------------------------------------------------------------------------------------------
+
+#ifndef CPHYSICSSTATS_H
+#define CPHYSICSSTATS_H
+
+#include "../Globals/CGlobals.h"
+#include <chrono>
+
+namespace Physics
+{
+	// Per tick counters and timers for the physics thread. Counters can be bumped from any thread during a tick, the physics
+	//  thread publishes them once per tick, and any thread can read the last published snapshot without taking a lock.
+	class CPhysicsStats
+	{
+	public:
+		enum class Metric
+		{
+			// Milliseconds spent in each phase of the tick.
+			ColliderUpdates,
+			PhysicsUpdates,
+			ForceFields,
+			Rigidbodies,
+			Solve,
+			Queries,
+
+			// Counts per tick.
+			IdleIterations,
+			RayCastIterations,
+			GJKCalls,
+			GJKIterations,
+			VoxelCandidates,
+			QueryCount,
+
+			// Average milliseconds between a query being made and its callback running.
+			QueryLatency,
+
+			Count,
+		};
+
+		static const u32 METRIC_COUNT = static_cast<u32>(Metric::Count);
+		static const u32 HISTORY_SIZE = 128;
+		static const u32 HISTOGRAM_BUCKETS = 16;
+
+		// Metric over the last HISTORY_SIZE ticks. Bucket 0 holds samples under the metric's base value,
+		//  and each bucket after it covers twice the range of the one before.
+		struct MetricStats
+		{
+			float last;
+			float average;
+			float min;
+			float max;
+			u32 histogram[HISTOGRAM_BUCKETS];
+		};
+
+		struct Snapshot
+		{
+			u64 tick;
+			MetricStats metricList[METRIC_COUNT];
+		};
+
+	public:
+		CPhysicsStats();
+		~CPhysicsStats();
+		CPhysicsStats(const CPhysicsStats&) = delete;
+		CPhysicsStats(CPhysicsStats&&) = delete;
+		CPhysicsStats& operator = (const CPhysicsStats&) = delete;
+		CPhysicsStats& operator = (CPhysicsStats&&) = delete;
+
+		void BeginTick();
+		void Lap(Metric metric);
+		void Count(Metric metric, u32 amount);
+		void Publish();
+
+		void Read(Snapshot& snapshot) const;
+
+	private:
+		// Physics thread state.
+		std::chrono::steady_clock::time_point m_lapTime;
+		float m_sampleList[METRIC_COUNT];
+		float m_historyList[METRIC_COUNT][HISTORY_SIZE];
+		u32 m_historyCount;
+		u32 m_historyIndex;
+		Snapshot m_working;
+
+		// Counters shared with other threads.
+		Au64 m_counterList[METRIC_COUNT];
+
+		// Sequence lock around the published snapshot. It's odd while a publish is in progress.
+		Au32 m_sequence;
+		Snapshot m_published;
+	};
+};
+
+#endif
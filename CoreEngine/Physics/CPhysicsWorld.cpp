@@ -9,15 +9,24 @@
 //-------------------------------------------------------------------------------------------------
 
 #include "CPhysicsWorld.h"
+#include "CPhysics.h"
+#include "CGJK.h"
 #include "CVolume.h"
 #include "CRigidbody.h"
 #include "CForceField.h"
 #include "../Objects/CVObject.h"
+#include "../Utilities/CTimer.h"
 #include <Windows.h>
+#include <algorithm>
 
 namespace Physics
 {
-	CPhysicsWorld::CPhysicsWorld() { }
+	CPhysicsWorld::CPhysicsWorld() :
+		m_focusCoord { },
+		m_tick(0),
+		m_bRegionsDirty(false)
+	{
+	}
 
 	CPhysicsWorld::~CPhysicsWorld() { }
 		
@@ -27,20 +36,63 @@ namespace Physics
 
 	void CPhysicsWorld::AddVolume(CVolume* pVolume)
 	{
-		m_volumeMap.insert({ pVolume->GetVObject()->GetHash(), pVolume });
-		if(pVolume->AllowsRays()) m_rayCastMap.insert({ pVolume->GetVObject()->GetHash(), pVolume });
-		if(pVolume->IsCollider()) m_colliderMap.insert({ pVolume->GetVObject()->GetHash(), pVolume });
-		if(pVolume->GetRigidbody()) m_rigidbodyMap.insert({ pVolume->GetVObject()->GetHash(), pVolume });
-		if(pVolume->GetForceField()) m_forceFieldMap.insert({ pVolume->GetVObject()->GetHash(), pVolume });
+		m_volumes.Add(pVolume);
+		if(pVolume->AllowsRays())
+		{
+			const u32 slot = m_rayCasts.Add(pVolume);
+			if(m_rayCasts.GetProxy(slot) == CAABBTree::NULL_NODE)
+			{
+				m_rayCasts.SetProxy(slot, m_rayTree.CreateProxy(m_rayCasts.GetBounds(slot), pVolume));
+			}
+		}
+
+		u32 proxy = CAABBTree::NULL_NODE;
+		if(pVolume->IsCollider())
+		{
+			const u32 slot = m_colliders.Add(pVolume);
+			if(m_colliders.GetProxy(slot) == CAABBTree::NULL_NODE)
+			{
+				m_colliders.SetProxy(slot, m_broadphase.CreateProxy(m_colliders.GetBounds(slot), pVolume));
+			}
+
+			proxy = m_colliders.GetProxy(slot);
+		}
+
+		// Rigidbodies that are also colliders share the proxy, so they can refit it without a lookup.
+		if(pVolume->GetRigidbody())
+		{
+			const u32 slot = m_rigidbodies.Add(pVolume);
+			m_rigidbodies.SetProxy(slot, proxy);
+			AddToRegion(pVolume, m_rigidbodies.GetPosition(slot));
+		}
+
+		if(pVolume->GetForceField()) m_forceFields.Add(pVolume);
 	}
 
 	void CPhysicsWorld::RemoveVolume(CVolume* pVolume)
 	{
-		m_volumeMap.erase(pVolume->GetVObject()->GetHash());
-		if(pVolume->AllowsRays()) m_rayCastMap.erase(pVolume->GetVObject()->GetHash());
-		if(pVolume->IsCollider()) m_colliderMap.erase(pVolume->GetVObject()->GetHash());
-		if(pVolume->GetRigidbody()) m_rigidbodyMap.erase(pVolume->GetVObject()->GetHash());
-		if(pVolume->GetForceField()) m_forceFieldMap.erase(pVolume->GetVObject()->GetHash());
+		const u32 slot = m_colliders.Find(pVolume->GetVObject()->GetHash());
+		if(slot != CVolumeArray::INVALID_SLOT)
+		{
+			m_broadphase.DestroyProxy(m_colliders.GetProxy(slot));
+
+			// Anything resting on the collider has lost its support.
+			WakeRegion(m_colliders.GetBounds(slot));
+		}
+
+		const u32 raySlot = m_rayCasts.Find(pVolume->GetVObject()->GetHash());
+		if(raySlot != CVolumeArray::INVALID_SLOT)
+		{
+			m_rayTree.DestroyProxy(m_rayCasts.GetProxy(raySlot));
+		}
+
+		if(pVolume->GetRigidbody()) RemoveFromRegion(pVolume);
+
+		m_volumes.Remove(pVolume);
+		m_rayCasts.Remove(pVolume);
+		m_colliders.Remove(pVolume);
+		m_rigidbodies.Remove(pVolume);
+		m_forceFields.Remove(pVolume);
 	}
 	
 	//-----------------------------------------------------------------------------------------------
@@ -50,26 +102,118 @@ namespace Physics
 	void CPhysicsWorld::UpdateVolume(CVolume* pVolume, const Math::SIMDMatrix& world)
 	{
 		pVolume->Recalculate(world);
+
+		const u32 slot = m_colliders.Find(pVolume->GetVObject()->GetHash());
+		if(slot != CVolumeArray::INVALID_SLOT)
+		{
+			const CAABBTree::AABB lastBounds = m_colliders.GetBounds(slot);
+
+			m_colliders.Gather(slot);
+			m_broadphase.MoveProxy(m_colliders.GetProxy(slot), m_colliders.GetBounds(slot), 0.0f);
+
+			WakeRegion(CAABBTree::AABB::Union(lastBounds, m_colliders.GetBounds(slot)));
+		}
+
+		const u32 raySlot = m_rayCasts.Find(pVolume->GetVObject()->GetHash());
+		if(raySlot != CVolumeArray::INVALID_SLOT)
+		{
+			m_rayCasts.Gather(raySlot);
+			m_rayTree.MoveProxy(m_rayCasts.GetProxy(raySlot), m_rayCasts.GetBounds(raySlot), 0.0f);
+		}
+
+		const u32 fieldSlot = m_forceFields.Find(pVolume->GetVObject()->GetHash());
+		if(fieldSlot != CVolumeArray::INVALID_SLOT)
+		{
+			m_forceFields.Gather(fieldSlot);
+		}
+
+		const u32 bodySlot = m_rigidbodies.Find(pVolume->GetVObject()->GetHash());
+		if(bodySlot != CVolumeArray::INVALID_SLOT)
+		{ // A moved body may have left its region.
+			m_rigidbodies.Gather(bodySlot);
+			UpdateRegion(bodySlot);
+		}
 	}
 	
+	// Method for waking every rigidbody whose collider overlaps the region.
+	void CPhysicsWorld::WakeRegion(const CAABBTree::AABB& aabb)
+	{
+		m_broadphase.Query(aabb, [](void* pUserData){
+			CVolume* pVolume = reinterpret_cast<CVolume*>(pUserData);
+			if(pVolume->GetRigidbody()) { pVolume->GetRigidbody()->Wake(); }
+			return true;
+		});
+	}
+
 	//-----------------------------------------------------------------------------------------------
 	// Update methods.
 	//-----------------------------------------------------------------------------------------------
 
+	// Method for applying every force field to the rigidbodies the broadphase finds inside its bounds.
 	void CPhysicsWorld::UpdateForceFields()
 	{
-		for(auto elem : m_forceFieldMap)
+		const float delta = Util::CTimer::Instance().GetDelta();
+
+		for(u32 f = 0; f < m_forceFields.Size(); ++f)
 		{
-			elem.second->GetForceField()->PhysicsUpdate();
+			CForceField* pForceField = m_forceFields[f]->GetForceField();
+			if(!pForceField->PhysicsUpdate()) { continue; }
+
+			const CAABBTree::AABB bounds = m_forceFields.GetBounds(f);
+
+			m_fieldSlotList.clear();
+			m_broadphase.Query(bounds, [this](void* pUserData){
+				const CVolume* pVolume = reinterpret_cast<const CVolume*>(pUserData);
+				if(pVolume->GetRigidbody())
+				{
+					const u32 slot = m_rigidbodies.Find(pVolume->GetVObject()->GetHash());
+					if(slot != CVolumeArray::INVALID_SLOT) { m_fieldSlotList.push_back(slot); }
+				}
+
+				return true;
+			});
+
+			if(m_fieldSlotList.empty()) { continue; }
+			pForceField->Apply(m_rigidbodies, m_fieldSlotList.data(), static_cast<u32>(m_fieldSlotList.size()), m_forceFields.GetPosition(f), bounds, delta);
 		}
 	}
 
+	// Method for picking the rigidbodies that step this tick. Only live regions are visited, and far regions take turns,
+	//  so the cost of a tick follows the bodies near the focus rather than every body in the world.
 	void CPhysicsWorld::UpdateRigidbodies()
 	{
-		for(auto rigidbody : m_rigidbodyMap)
+		++m_tick;
+		if(m_bRegionsDirty) { BuildLiveRegions(); }
+
+		m_activeList.clear();
+		m_stepTickList.resize(m_rigidbodies.Size(), 0);
+
+		const u32 farInterval = max(m_regionData.farInterval, 1U);
+		for(Region* pRegion : m_liveRegionList)
 		{
-			rigidbody.second->GetRigidbody()->Calculate();
-			rigidbody.second->GetRigidbody()->SetupIdleSolver();
+			float stepScale = 1.0f;
+			if(pRegion->rate == RegionRate::Far)
+			{
+				if((m_tick + pRegion->phase) % farInterval != 0) { continue; }
+				stepScale = static_cast<float>(farInterval);
+			}
+
+			pRegion->stepTick = m_tick;
+			pRegion->stepScale = stepScale;
+
+			for(CVolume* pVolume : pRegion->bodyList)
+			{
+				CRigidbody* pRigidbody = pVolume->GetRigidbody();
+				if(!pRigidbody->ProcessWake()) { continue; }
+
+				pRigidbody->SetStepScale(stepScale);
+				pRigidbody->Calculate();
+				pRigidbody->SetupIdleSolver();
+
+				const u32 slot = m_rigidbodies.Find(pVolume->GetVObject()->GetHash());
+				m_stepTickList[slot] = m_tick;
+				m_activeList.push_back(slot);
+			}
 		}
 	}
 	
@@ -77,8 +221,73 @@ namespace Physics
 	// Solver.
 	//-----------------------------------------------------------------------------------------------
 	
-	void CPhysicsWorld::Solve(u32 idleIterations, u32 rayCastIterations)
+	// Most tasks a solve is split into. Islands are dealt out to tasks round robin.
+	static const u32 MAX_ISLAND_TASKS = 16;
+
+	void CPhysicsWorld::Solve(u32 idleIterations, u32 rayCastIterations, const ParallelFor& parallelFor)
+	{
+		const float delta = Util::CTimer::Instance().GetDelta();
+
+		for(u32 r : m_activeList)
+		{
+			m_rigidbodies.Gather(r);
+		}
+
+		FindPairs();
+		BuildIslands();
+
+		// Islands share no rigidbodies, so they can be solved in any order on any thread and still give the same result.
+		const u32 islandCount = static_cast<u32>(m_islandList.size());
+		if(parallelFor && islandCount > 1)
+		{
+			const u32 taskCount = min(islandCount, MAX_ISLAND_TASKS);
+			parallelFor(taskCount, [&](u32 task){
+				for(u32 island = task; island < islandCount; island += taskCount)
+				{
+					SolveIsland(island, idleIterations, rayCastIterations, delta);
+				}
+			});
+		}
+		else
+		{
+			for(u32 island = 0; island < islandCount; ++island)
+			{
+				SolveIsland(island, idleIterations, rayCastIterations, delta);
+			}
+		}
+
+		// The tree isn't thread safe, so proxies are refit once every island is done.
+		for(u32 r : m_activeList)
+		{
+			CRigidbody* pRigidbody = m_rigidbodies[r]->GetRigidbody();
+			const float bodyDelta = delta * pRigidbody->GetStepScale();
+			pRigidbody->UpdateSleep(bodyDelta);
+
+			if(m_rigidbodies.GetProxy(r) != CAABBTree::NULL_NODE)
+			{ // Moving colliders keep their proxies up to date, stretched along their velocity.
+				m_broadphase.MoveProxy(m_rigidbodies.GetProxy(r), m_rigidbodies.GetBounds(r), m_rigidbodies.GetVelocity(r) * bodyDelta);
+			}
+
+			if(m_rigidbodies[r]->AllowsRays())
+			{
+				const u32 raySlot = m_rayCasts.Find(m_rigidbodies[r]->GetVObject()->GetHash());
+				if(raySlot != CVolumeArray::INVALID_SLOT)
+				{
+					m_rayCasts.Gather(raySlot);
+					m_rayTree.MoveProxy(m_rayCasts.GetProxy(raySlot), m_rayCasts.GetBounds(raySlot), m_rigidbodies.GetVelocity(r) * bodyDelta);
+				}
+			}
+
+			UpdateRegion(r);
+		}
+	}
+
+	// Method for solving one island. Runs on job threads, so the tick's delta is passed in rather than read from the timer.
+	void CPhysicsWorld::SolveIsland(u32 island, u32 idleIterations, u32 rayCastIterations, float delta)
 	{
+		const u32* pBodyList = m_islandBodyList.data() + m_islandList[island].first;
+		const u32 bodyCount = m_islandList[island].count;
+
 		bool bAnyResponse;
 		u32 i, j;
 
@@ -86,14 +295,13 @@ namespace Physics
 		for(i = 0; i < idleIterations; ++i)
 		{
 			bAnyResponse = false;
-			for(auto rigidbody : m_rigidbodyMap)
+			for(u32 b = 0; b < bodyCount; ++b)
 			{
-				for(auto collider : m_colliderMap)
+				const u32 r = pBodyList[b];
+				const PairRange& range = m_pairRangeList[r];
+				for(u32 c = range.first; c < range.first + range.count; ++c)
 				{
-					if(collider.second != rigidbody.second)
-					{
-						bAnyResponse |= collider.second->IdleSolver(rigidbody.second);
-					}
+					bAnyResponse |= m_pairList[c]->IdleSolver(m_rigidbodies[r]);
 				}
 			}
 
@@ -101,29 +309,30 @@ namespace Physics
 		}
 		
 		// Apply idle iterations, and prep for ray cast iterations.
-		for(auto rigidbody : m_rigidbodyMap)
+		for(u32 b = 0; b < bodyCount; ++b)
 		{
-			rigidbody.second->GetRigidbody()->ApplyIdleSolver();
-			rigidbody.second->GetRigidbody()->ResetSolverState();
+			const u32 r = pBodyList[b];
+			m_rigidbodies[r]->GetRigidbody()->ApplyIdleSolver();
+			m_rigidbodies[r]->GetRigidbody()->ResetSolverState(delta);
+			m_rigidbodies.Gather(r);
 		}
 
 		// Perform ray cast iterations.
 		for(j = 0; j < rayCastIterations; ++j)
 		{
 			bAnyResponse = false;
-			for(auto rigidbody : m_rigidbodyMap)
+			for(u32 b = 0; b < bodyCount; ++b)
 			{
-				if(_mm_cvtss_f32(rigidbody.second->GetRigidbody()->GetVelocity().LengthSq()) > 1e-10f)
+				const u32 r = pBodyList[b];
+				if(m_rigidbodies.GetVelocity(r).LengthSq() > 1e-10f)
 				{
-					for(auto collider : m_colliderMap)
+					const PairRange& range = m_pairRangeList[r];
+					for(u32 c = range.first; c < range.first + range.count; ++c)
 					{
-						if(collider.second != rigidbody.second)
-						{
-							collider.second->MotionSolver(rigidbody.second);
-						}
+						m_pairList[c]->MotionSolver(m_rigidbodies[r]);
 					}
 
-					bAnyResponse |= rigidbody.second->GetRigidbody()->Response();
+					bAnyResponse |= m_rigidbodies[r]->GetRigidbody()->Response();
 				}
 			}
 
@@ -133,70 +342,464 @@ namespace Physics
 		// If max ray cast iterations are reached, reset and perform a single final ray cast for rigidbodies that are still invalid.
 		if(j >= rayCastIterations)
 		{
-			for(auto rigidbody : m_rigidbodyMap)
+			for(u32 b = 0; b < bodyCount; ++b)
 			{
-				if(rigidbody.second->GetRigidbody()->IsValid()) continue;
-				if(_mm_cvtss_f32(rigidbody.second->GetRigidbody()->GetVelocity().LengthSq()) > 1e-10f)
+				const u32 r = pBodyList[b];
+				CRigidbody* pRigidbody = m_rigidbodies[r]->GetRigidbody();
+				if(pRigidbody->IsValid()) continue;
+				if(m_rigidbodies.GetVelocity(r).LengthSq() > 1e-10f)
 				{
-					rigidbody.second->GetRigidbody()->ResetSolverState();
+					pRigidbody->ResetSolverState(delta);
 
-					for(auto collider : m_colliderMap)
+					const PairRange& range = m_pairRangeList[r];
+					for(u32 c = range.first; c < range.first + range.count; ++c)
 					{
-						if(collider.second != rigidbody.second)
-						{
-							collider.second->MotionSolver(rigidbody.second);
-						}
+						m_pairList[c]->MotionSolver(m_rigidbodies[r]);
 					}
 
-					rigidbody.second->GetRigidbody()->Response();
+					pRigidbody->Response();
 				}
 			}
 		}
 		
-		// Apply ray cast adjustments, and perform some idle iterations to make sure that are resting in the right spop.
-		//  TODO: Try to remove the need for the addition idle iterations in the future.
-		for(auto rigidbody : m_rigidbodyMap)
+		// Apply ray cast adjustments. The contact manifolds from the idle iterations settle the final position,
+		//  so no further GJK queries are needed.
+		for(u32 b = 0; b < bodyCount; ++b)
 		{
-			rigidbody.second->GetRigidbody()->Apply([&](){
-				//if(i == 0 && j == 0) return;
+			const u32 r = pBodyList[b];
+			CRigidbody* pRigidbody = m_rigidbodies[r]->GetRigidbody();
 
-				rigidbody.second->GetRigidbody()->SetupIdleSolver();
-				
-				bool bSolved = false;
-				for(i = 0; !bSolved && i < idleIterations; ++i)
-				{
-					bSolved = true;
+			pRigidbody->Apply(delta, [pRigidbody](){
+				pRigidbody->SetupIdleSolver();
+				pRigidbody->ProjectContacts();
+				pRigidbody->ApplyIdleSolver();
+			});
 
-					for(auto collider : m_colliderMap)
-					{
-						if(collider.second != rigidbody.second)
-						{
-							bSolved &= !collider.second->IdleSolver(rigidbody.second);
-						}
-					}
+			m_rigidbodies.Gather(r);
+		}
+
+		// Iterations that broke early still ran the pass they broke on.
+		CPhysicsStats& stats = CPhysics::Instance().GetStats();
+		stats.Count(CPhysicsStats::Metric::IdleIterations, min(i + 1, idleIterations));
+		stats.Count(CPhysicsStats::Metric::RayCastIterations, min(j + 1, rayCastIterations));
+		CGJK::FlushStats(stats);
+	}
+
+	// Method for bringing a sleeping rigidbody into this step, after the update pass has already run. Only bodies in
+	//  a region stepping this tick are woken, with that region's step scale. Bodies in frozen or resting far regions
+	//  stay put as colliders.
+	void CPhysicsWorld::WakeRigidbody(CVolume* pVolume)
+	{
+		const u32 slot = m_rigidbodies.Find(pVolume->GetVObject()->GetHash());
+		if(slot == CVolumeArray::INVALID_SLOT || m_stepTickList[slot] == m_tick) { return; }
+
+		auto body = m_bodyRegionMap.find(pVolume->GetVObject()->GetHash());
+		if(body == m_bodyRegionMap.end()) { return; }
+
+		auto elem = m_regionMap.find(body->second);
+		if(elem == m_regionMap.end() || elem->second.stepTick != m_tick) { return; }
+
+		CRigidbody* pRigidbody = pVolume->GetRigidbody();
+		pRigidbody->Wake();
+		pRigidbody->ProcessWake();
+		pRigidbody->SetStepScale(elem->second.stepScale);
+		pRigidbody->Calculate();
+		pRigidbody->SetupIdleSolver();
+
+		m_rigidbodies.Gather(slot);
+		m_stepTickList[slot] = m_tick;
+		m_activeList.push_back(slot);
+	}
+
+	// Method for gathering the colliders each rigidbody can reach this step. Bodies query the tree with their bounds
+	//  swept along their velocity, so the solvers only ever see overlapping pairs. Sleeping bodies stay put as
+	//  colliders unless a moving body reaches them and their region steps this tick, in which case they're woken
+	//  and join the step.
+	void CPhysicsWorld::FindPairs()
+	{
+		const float delta = Util::CTimer::Instance().GetDelta();
+
+		m_pairRangeList.resize(m_rigidbodies.Size());
+		m_pairList.clear();
+
+		// Woken bodies are appended to the active list, so it's walked by index.
+		for(size_t a = 0; a < m_activeList.size(); ++a)
+		{
+			const u32 r = m_activeList[a];
+			CVolume* pRigidbody = m_rigidbodies[r];
+			const bool bWakes = !pRigidbody->GetRigidbody()->IsResting();
+
+			const CAABBTree::AABB aabb = CAABBTree::AABB::Swept(m_rigidbodies.GetBounds(r), m_rigidbodies.GetVelocity(r) * delta);
+
+			PairRange& range = m_pairRangeList[r];
+			range.first = static_cast<u32>(m_pairList.size());
+
+			m_broadphase.Query(aabb, [this, pRigidbody, bWakes](void* pUserData){
+				CVolume* pCollider = reinterpret_cast<CVolume*>(pUserData);
+				if(pCollider == pRigidbody) { return true; }
+
+				m_pairList.push_back(pCollider);
+				if(bWakes && pCollider->GetRigidbody() && pCollider->GetRigidbody()->IsAsleep())
+				{
+					WakeRigidbody(pCollider);
 				}
-			
-				rigidbody.second->GetRigidbody()->ApplyIdleSolver();
+
+				return true;
 			});
+
+			range.count = static_cast<u32>(m_pairList.size()) - range.first;
+		}
+	}
+
+	static inline u32 FindIsland(std::vector<u32>& parentList, u32 index)
+	{
+		while(parentList[index] != index)
+		{
+			parentList[index] = parentList[parentList[index]];
+			index = parentList[index];
+		}
+
+		return index;
+	}
+
+	// Method for grouping rigidbodies that reach each other through a pair. Static colliders are only read by the
+	//  solvers, so they never join islands. Roots are the lowest slot, which keeps island and body order stable.
+	void CPhysicsWorld::BuildIslands()
+	{
+		// Only bodies stepping this tick are grouped. Sleeping bodies, and awake bodies in frozen or resting far regions,
+		//  are left out the same way static colliders are.
+		std::sort(m_activeList.begin(), m_activeList.end());
+
+		m_islandParentList.resize(m_rigidbodies.Size());
+		for(u32 r : m_activeList)
+		{
+			m_islandParentList[r] = r;
+		}
+
+		for(u32 r : m_activeList)
+		{
+			const PairRange& range = m_pairRangeList[r];
+			for(u32 c = range.first; c < range.first + range.count; ++c)
+			{
+				if(m_pairList[c]->GetRigidbody() == nullptr) { continue; }
+
+				const u32 other = m_rigidbodies.Find(m_pairList[c]->GetVObject()->GetHash());
+				if(other == CVolumeArray::INVALID_SLOT || m_stepTickList[other] != m_tick) { continue; }
+
+				const u32 a = FindIsland(m_islandParentList, r);
+				const u32 b = FindIsland(m_islandParentList, other);
+				if(a < b) { m_islandParentList[b] = a; }
+				else if(b < a) { m_islandParentList[a] = b; }
+			}
+		}
+
+		// Parents never point to a higher slot, so one ascending pass flattens every body onto its root.
+		for(u32 r : m_activeList)
+		{
+			m_islandParentList[r] = FindIsland(m_islandParentList, r);
+		}
+
+		// Number the islands by root, then bucket the bodies by island.
+		m_islandList.clear();
+		m_islandBodyList.resize(m_activeList.size());
+
+		for(u32 r : m_activeList)
+		{
+			const u32 root = m_islandParentList[r];
+			if(root == r)
+			{
+				m_islandParentList[r] = static_cast<u32>(m_islandList.size());
+				m_islandList.push_back({ 0, 0 });
+			}
+			else
+			{ // Roots come before their bodies, so the root already holds its island index.
+				m_islandParentList[r] = m_islandParentList[root];
+			}
+
+			++m_islandList[m_islandParentList[r]].count;
+		}
+
+		u32 first = 0;
+		for(Island& island : m_islandList)
+		{
+			island.first = first;
+			first += island.count;
+			island.count = 0;
+		}
+
+		for(u32 r : m_activeList)
+		{
+			Island& island = m_islandList[m_islandParentList[r]];
+			m_islandBodyList[island.first + island.count++] = r;
 		}
 	}
 
 	//-----------------------------------------------------------------------------------------------
-	// Query methods.
+	// Recording methods.
 	//-----------------------------------------------------------------------------------------------
 
-	void CPhysicsWorld::CastRay(const QueryRay& queryRay)
+	// Method for capturing the input of every rigidbody, in slot order.
+	void CPhysicsWorld::GetInputs(std::vector<CPhysicsRecorder::InputEntry>& inputList) const
 	{
-		std::vector<RaycastInfo> res;
-		RaycastInfo info;
-		for(auto elem : m_rayCastMap)
+		inputList.resize(m_rigidbodies.Size());
+		for(u32 r = 0; r < m_rigidbodies.Size(); ++r)
 		{
-			if(elem.second->RayTest(queryRay, info))
+			inputList[r] = { m_rigidbodies[r]->GetVObject()->GetHash(), m_rigidbodies[r]->GetRigidbody()->GetInput() };
+		}
+	}
+
+	void CPhysicsWorld::SetInput(const CPhysicsRecorder::InputEntry& entry)
+	{
+		const u32 slot = m_rigidbodies.Find(entry.hash);
+		if(slot == CVolumeArray::INVALID_SLOT) { return; }
+
+		m_rigidbodies[slot]->GetRigidbody()->SetInput(entry.input);
+	}
+
+	// Method for capturing the transform of every rigidbody, in slot order.
+	void CPhysicsWorld::GetBodies(std::vector<CPhysicsRecorder::BodyEntry>& bodyList) const
+	{
+		bodyList.resize(m_rigidbodies.Size());
+		for(u32 r = 0; r < m_rigidbodies.Size(); ++r)
+		{
+			bodyList[r] = { m_rigidbodies[r]->GetVObject()->GetHash(), m_rigidbodies.GetPosition(r), m_rigidbodies.GetRotation(r) };
+		}
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// Region methods.
+	//-----------------------------------------------------------------------------------------------
+
+	static void RegionCoord(const Math::Vector3& position, float size, s32 coord[3])
+	{
+		for(int a = 0; a < 3; ++a)
+		{
+			coord[a] = static_cast<s32>(floorf(position[a] / size));
+		}
+	}
+
+	// Region coordinates are packed 21 bits to an axis.
+	static u64 RegionKey(const s32 coord[3])
+	{
+		return (static_cast<u64>(coord[0] & 0x1FFFFF) << 42) | (static_cast<u64>(coord[1] & 0x1FFFFF) << 21) | static_cast<u64>(coord[2] & 0x1FFFFF);
+	}
+
+	// Method for changing how the world is split. Every rigidbody is sorted into the new regions.
+	void CPhysicsWorld::SetRegionData(const RegionData& data)
+	{
+		for(auto& elem : m_regionMap)
+		{
+			SetRegionRate(elem.second, RegionRate::Near);
+		}
+
+		m_regionMap.clear();
+		m_bodyRegionMap.clear();
+		m_regionData = data;
+		m_bRegionsDirty = true;
+
+		for(u32 r = 0; r < m_rigidbodies.Size(); ++r)
+		{
+			AddToRegion(m_rigidbodies[r], m_rigidbodies.GetPosition(r));
+		}
+	}
+
+	// Method for moving the focus. Regions are only reclassified when the focus crosses into another region.
+	void CPhysicsWorld::SetFocus(const Math::Vector3& focus)
+	{
+		s32 coord[3];
+		RegionCoord(focus, m_regionData.size, coord);
+		if(coord[0] == m_focusCoord[0] && coord[1] == m_focusCoord[1] && coord[2] == m_focusCoord[2]) { return; }
+
+		for(int a = 0; a < 3; ++a)
+		{
+			m_focusCoord[a] = coord[a];
+		}
+
+		for(auto& elem : m_regionMap)
+		{
+			SetRegionRate(elem.second, ClassifyRegion(elem.second));
+		}
+	}
+
+	void CPhysicsWorld::AddToRegion(CVolume* pVolume, const Math::Vector3& position)
+	{
+		const u64 hash = pVolume->GetVObject()->GetHash();
+		if(m_bodyRegionMap.find(hash) != m_bodyRegionMap.end()) { return; }
+
+		s32 coord[3];
+		RegionCoord(position, m_regionData.size, coord);
+		const u64 key = RegionKey(coord);
+
+		auto elem = m_regionMap.find(key);
+		if(elem == m_regionMap.end())
+		{
+			Region region { };
+			region.coord[0] = coord[0];
+			region.coord[1] = coord[1];
+			region.coord[2] = coord[2];
+
+			// Spread far regions over the interval so they don't all step on the same tick.
+			region.phase = (static_cast<u32>(coord[0]) * 73856093U ^ static_cast<u32>(coord[1]) * 19349663U ^ static_cast<u32>(coord[2]) * 83492791U) % max(m_regionData.farInterval, 1U);
+			region.rate = ClassifyRegion(region);
+
+			elem = m_regionMap.insert({ key, std::move(region) }).first;
+			m_bRegionsDirty = true;
+		}
+
+		Region& region = elem->second;
+		region.bodyList.push_back(pVolume);
+		if(region.rate == RegionRate::Frozen)
+		{
+			region.frozenList.push_back({ hash, pVolume->GetRigidbody()->GetInput() });
+		}
+
+		m_bodyRegionMap.insert({ hash, key });
+	}
+
+	// Method for taking a body out of its region. A frozen body gets its input back, and empty regions are dropped.
+	void CPhysicsWorld::RemoveFromRegion(const CVolume* pVolume)
+	{
+		const u64 hash = pVolume->GetVObject()->GetHash();
+
+		auto body = m_bodyRegionMap.find(hash);
+		if(body == m_bodyRegionMap.end()) { return; }
+
+		auto elem = m_regionMap.find(body->second);
+		m_bodyRegionMap.erase(body);
+		if(elem == m_regionMap.end()) { return; }
+
+		Region& region = elem->second;
+		for(size_t i = 0; i < region.bodyList.size(); ++i)
+		{
+			if(region.bodyList[i] != pVolume) { continue; }
+
+			region.bodyList[i] = region.bodyList.back();
+			region.bodyList.pop_back();
+			break;
+		}
+
+		for(size_t i = 0; i < region.frozenList.size(); ++i)
+		{
+			if(region.frozenList[i].hash != hash) { continue; }
+
+			pVolume->GetRigidbody()->SetInput(region.frozenList[i].input);
+			region.frozenList[i] = region.frozenList.back();
+			region.frozenList.pop_back();
+			break;
+		}
+
+		if(region.bodyList.empty())
+		{
+			m_regionMap.erase(elem);
+			m_bRegionsDirty = true;
+		}
+	}
+
+	// Method for moving a rigidbody to the region its gathered position is in.
+	void CPhysicsWorld::UpdateRegion(u32 slot)
+	{
+		CVolume* pVolume = m_rigidbodies[slot];
+
+		s32 coord[3];
+		RegionCoord(m_rigidbodies.GetPosition(slot), m_regionData.size, coord);
+
+		auto body = m_bodyRegionMap.find(pVolume->GetVObject()->GetHash());
+		if(body != m_bodyRegionMap.end() && body->second == RegionKey(coord)) { return; }
+
+		RemoveFromRegion(pVolume);
+		AddToRegion(pVolume, m_rigidbodies.GetPosition(slot));
+	}
+
+	// Method for freezing or thawing a region. Freezing keeps the input of every body in the region, so whatever
+	//  changes it while the region is frozen is undone when the region thaws.
+	void CPhysicsWorld::SetRegionRate(Region& region, RegionRate rate)
+	{
+		if(region.rate == rate) { return; }
+
+		if(rate == RegionRate::Frozen)
+		{
+			region.frozenList.clear();
+			for(CVolume* pVolume : region.bodyList)
+			{
+				region.frozenList.push_back({ pVolume->GetVObject()->GetHash(), pVolume->GetRigidbody()->GetInput() });
+			}
+		}
+		else if(region.rate == RegionRate::Frozen)
+		{
+			for(const CPhysicsRecorder::InputEntry& entry : region.frozenList)
 			{
-				res.push_back(info);
+				SetInput(entry);
 			}
+
+			region.frozenList.clear();
+		}
+
+		region.rate = rate;
+		m_bRegionsDirty = true;
+	}
+
+	// Regions are measured by the largest distance along any axis, so each rate covers a cube around the focus.
+	CPhysicsWorld::RegionRate CPhysicsWorld::ClassifyRegion(const Region& region) const
+	{
+		u32 distance = 0;
+		for(int a = 0; a < 3; ++a)
+		{
+			const s32 d = region.coord[a] - m_focusCoord[a];
+			distance = max(distance, static_cast<u32>(d < 0 ? -d : d));
 		}
 
-		queryRay.callback(res);
+		if(distance <= m_regionData.nearRadius) { return RegionRate::Near; }
+		if(distance <= m_regionData.farRadius) { return RegionRate::Far; }
+		return RegionRate::Frozen;
+	}
+
+	void CPhysicsWorld::BuildLiveRegions()
+	{
+		m_liveRegionList.clear();
+		for(auto& elem : m_regionMap)
+		{
+			if(elem.second.rate != RegionRate::Frozen) { m_liveRegionList.push_back(&elem.second); }
+		}
+
+		m_bRegionsDirty = false;
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// Query methods.
+	//-----------------------------------------------------------------------------------------------
+
+	// Method for freezing the world's current state for queries. Called once the step is solved.
+	void CPhysicsWorld::BuildSnapshot(CPhysicsSnapshot& snapshot) const
+	{
+		snapshot.Build(m_broadphase, m_rayTree);
+	}
+
+	// Method for finding the first collider the placed shape hits along the displacement, as the world stands right now.
+	//  Triggers and the ignored volume are skipped.
+	bool CPhysicsWorld::Sweep(const CVolume* pShape, const Math::SIMDVector& displacement, const CVolume* pIgnore, SweepInfo& info) const
+	{
+		const Math::Vector3 position = *reinterpret_cast<const Math::Vector3*>(pShape->GetSolverPosition().ToFloat());
+		const Math::Vector3 offset = *reinterpret_cast<const Math::Vector3*>(displacement.ToFloat());
+
+		const CAABBTree::AABB aabb = CAABBTree::AABB::Swept({ position + pShape->GetMinExtents(), position + pShape->GetMaxExtents() }, offset);
+
+		info = { -1, 1.0f, nullptr, pShape->GetSolverPosition() + displacement, Math::SIMD_VEC_ZERO };
+		bool bHit = false;
+
+		m_broadphase.Query(aabb, [&](void* pUserData){
+			const CVolume* pVolume = reinterpret_cast<const CVolume*>(pUserData);
+			if(pVolume == pIgnore || pVolume->GetColliderType() != ColliderType::Collider) { return true; }
+
+			SweepInfo hit;
+			if(pVolume->SweepTest(pShape, displacement, hit) && hit.interval <= info.interval)
+			{
+				info = hit;
+				bHit = true;
+			}
+
+			return true;
+		});
+
+		return bHit;
 	}
 };
@@ -12,9 +12,14 @@
 #define CPHYSICSWORLD_H
 
 #include "CPhysicsData.h"
+#include "CAABBTree.h"
+#include "CVolumeArray.h"
+#include "CPhysicsRecorder.h"
+#include "CPhysicsSnapshot.h"
 #include "../Math/CSIMDMatrix.h"
 #include "../Utilities/CTSDeque.h"
 #include <unordered_map>
+#include <vector>
 
 namespace Physics
 {
@@ -31,19 +36,106 @@ namespace Physics
 		void AddVolume(class CVolume* pVolume);
 		void RemoveVolume(class CVolume* pVolume);
 		void UpdateVolume(class CVolume* pVolume, const Math::SIMDMatrix& world);
+		void WakeRegion(const CAABBTree::AABB& aabb);
+
+		void SetRegionData(const RegionData& data);
+		void SetFocus(const Math::Vector3& focus);
 
 		void UpdateForceFields();
 		void UpdateRigidbodies();
-		void Solve(u32 idleIterations, u32 rayCastIterations);
+		void Solve(u32 idleIterations, u32 rayCastIterations, const ParallelFor& parallelFor);
+
+		void BuildSnapshot(CPhysicsSnapshot& snapshot) const;
+		bool Sweep(const class CVolume* pShape, const Math::SIMDVector& displacement, const class CVolume* pIgnore, SweepInfo& info) const;
+
+		void GetInputs(std::vector<CPhysicsRecorder::InputEntry>& inputList) const;
+		void SetInput(const CPhysicsRecorder::InputEntry& entry);
+		void GetBodies(std::vector<CPhysicsRecorder::BodyEntry>& bodyList) const;
+
+	private:
+		void WakeRigidbody(class CVolume* pVolume);
+		void FindPairs();
+		void BuildIslands();
+		void SolveIsland(u32 island, u32 idleIterations, u32 rayCastIterations, float delta);
+
+	private:
+		// Colliders the broadphase found for one rigidbody, stored as a range of the pair list. Ranges share the rigidbody's slot.
+		struct PairRange
+		{
+			u32 first;
+			u32 count;
+		};
+
+		// Rigidbodies that can touch each other, stored as a range of the island body list.
+		struct Island
+		{
+			u32 first;
+			u32 count;
+		};
+
+		enum class RegionRate
+		{
+			Near,
+			Far,
+			Frozen,
+		};
 
-		void CastRay(const QueryRay& queryRay);
+		// Cube of the world holding the rigidbodies whose position is inside it. A frozen region keeps the input of its
+		//  bodies as plain entries, and gives it back when the region thaws.
+		struct Region
+		{
+			s32 coord[3];
+			RegionRate rate;
+			u32 phase;
+
+			// Last tick the region stepped on, and the step scale it stepped with.
+			u32 stepTick;
+			float stepScale;
+			std::vector<class CVolume*> bodyList;
+			std::vector<CPhysicsRecorder::InputEntry> frozenList;
+		};
+
+	private:
+		void AddToRegion(class CVolume* pVolume, const Math::Vector3& position);
+		void RemoveFromRegion(const class CVolume* pVolume);
+		void UpdateRegion(u32 slot);
+		void SetRegionRate(Region& region, RegionRate rate);
+		RegionRate ClassifyRegion(const Region& region) const;
+		void BuildLiveRegions();
 
 	private:
-		std::unordered_map<u64, class CVolume*> m_volumeMap;
-		std::unordered_map<u64, class CVolume*> m_colliderMap;
-		std::unordered_map<u64, class CVolume*> m_rigidbodyMap;
-		std::unordered_map<u64, class CVolume*> m_forceFieldMap;
-		std::unordered_map<u64, class CVolume*> m_rayCastMap;
+		CVolumeArray m_volumes;
+		CVolumeArray m_colliders;
+		CVolumeArray m_rigidbodies;
+		CVolumeArray m_forceFields;
+		CVolumeArray m_rayCasts;
+
+		// Slots of the rigidbodies that are awake this step. Sleeping bodies are skipped by every solver pass.
+		std::vector<u32> m_activeList;
+
+		// Tick each rigidbody slot last joined the step on. Bodies not stamped this tick are read as static colliders.
+		std::vector<u32> m_stepTickList;
+
+		// Rigidbody slots inside the bounds of the force field being applied.
+		std::vector<u32> m_fieldSlotList;
+
+		CAABBTree m_broadphase;
+		CAABBTree m_rayTree;
+		std::vector<PairRange> m_pairRangeList;
+		std::vector<class CVolume*> m_pairList;
+
+		std::vector<u32> m_islandParentList;
+		std::vector<u32> m_islandBodyList;
+		std::vector<Island> m_islandList;
+
+		// Regions keyed by packed coordinates, and the region of every rigidbody. Only the live regions are visited each tick.
+		RegionData m_regionData;
+		s32 m_focusCoord[3];
+		u32 m_tick;
+		bool m_bRegionsDirty;
+		std::unordered_map<u64, Region> m_regionMap;
+		std::unordered_map<u64, u64> m_bodyRegionMap;
+		std::vector<Region*> m_liveRegionList;
 	};
 };
 
@@ -17,7 +17,12 @@
 namespace Physics
 {
 	CRigidbody::CRigidbody(const CVObject* pObject) :
-		CVComponent(pObject) { }
+		CVComponent(pObject),
+		m_cacheStep(0),
+		m_stepScale(1.0f),
+		m_bAsleep(false),
+		m_sleepTimer(0.0f),
+		m_bWakeRequested(false) { }
 
 	CRigidbody::~CRigidbody() { }
 
@@ -92,6 +97,8 @@ namespace Physics
 		
 		m_firstContactPoint = Math::SIMD_VEC_ZERO;
 		m_contactList.clear();
+		m_sepAxisList.clear();
+		m_manifoldList.clear();
 		m_bLastHit = false;
 		m_bHit = false;
 		m_bOnGround = false;
@@ -99,13 +106,19 @@ namespace Physics
 		m_lastStamp = { };
 		m_stampQueue.Clear();
 		m_interpT = 0.0f;
+
+		m_bAsleep = false;
+		m_sleepTimer = 0.0f;
+		m_bWakeRequested = false;
 	}
 
-	void CRigidbody::ResetSolverState()
+	// Method for starting the solver from the current volume. The delta is the tick's, read on the physics thread,
+	//  since the solver can run on job threads that have no timer of their own.
+	void CRigidbody::ResetSolverState(float delta)
 	{
 		m_solverPosition = m_data.pVolume->m_position;
 		m_solverRotation = m_data.pVolume->m_rotation;
-		m_solverVelocity = m_velocity * Util::CTimer::Instance().GetDelta();
+		m_solverVelocity = m_velocity * (delta * m_stepScale);
 		m_finalPosition = m_data.pVolume->m_position + m_solverVelocity;
 		m_finalVelocity = m_solverVelocity;
 		m_finalRotation = m_solverRotation;
@@ -115,7 +128,7 @@ namespace Physics
 
 	void CRigidbody::Calculate()
 	{
-		const float delta = Util::CTimer::Instance().GetDelta();
+		const float delta = Util::CTimer::Instance().GetDelta() * m_stepScale;
 		
 		//m_acceleration += m_forceAccum * m_data.invMass;
 		m_velocity += (m_acceleration + CPhysics::Instance().GetData().gravity) * delta;
@@ -125,6 +138,7 @@ namespace Physics
 
 		// Set adjustable values that can change during the solvers iterations.
 		ClearAccumulator();
+		EvictCaches();
 		m_bOnGround = false;
 	}
 	
@@ -178,9 +192,9 @@ namespace Physics
 		}
 	}
 
-	void CRigidbody::Apply(std::function<void()> onWasHit)
+	void CRigidbody::Apply(float tickDelta, std::function<void()> onWasHit)
 	{
-		const float delta = Util::CTimer::Instance().GetDelta();
+		const float delta = tickDelta * m_stepScale;
 		
 		Math::SIMDVector lastPos = m_data.pVolume->m_position;
 
@@ -244,6 +258,63 @@ namespace Physics
 		m_data.pVolume->UpdateBounds();
 	}
 	
+	//-----------------------------------------------------------------------------------------------
+	// Sleep methods.
+	//-----------------------------------------------------------------------------------------------
+
+	// Method for requesting a wake. Safe to call from any thread; the physics thread picks it up on its next step.
+	void CRigidbody::Wake()
+	{
+		m_bWakeRequested = true;
+	}
+
+	// Method for applying a pending wake. Returns true if the body is awake.
+	bool CRigidbody::ProcessWake()
+	{
+		if(m_bWakeRequested.exchange(false))
+		{
+			m_bAsleep = false;
+			m_sleepTimer = 0.0f;
+		}
+
+		return !m_bAsleep;
+	}
+
+	// Method for advancing the sleep timer after a solve. Returns true if the body fell asleep.
+	bool CRigidbody::UpdateSleep(float delta)
+	{
+		if(_mm_cvtss_f32(m_velocity.LengthSq()) > m_data.sleepSpeed * m_data.sleepSpeed)
+		{
+			m_sleepTimer = 0.0f;
+			return false;
+		}
+
+		m_sleepTimer += delta;
+		if(m_sleepTimer < m_data.sleepTime) { return false; }
+
+		m_velocity = Math::SIMD_VEC_ZERO;
+		m_bAsleep = true;
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// Input methods.
+	//-----------------------------------------------------------------------------------------------
+
+	CRigidbody::Input CRigidbody::GetInput() const
+	{
+		return { m_velocity, m_acceleration, m_forceAccum, m_bWakeRequested.load() };
+	}
+
+	// Method for restoring recorded input. Unlike the modifiers, this only wakes the body if the input requested it.
+	void CRigidbody::SetInput(const Input& input)
+	{
+		m_velocity = input.velocity;
+		m_acceleration = input.acceleration;
+		m_forceAccum = input.force;
+		if(input.bWake) { Wake(); }
+	}
+
 	//-----------------------------------------------------------------------------------------------
 	// Internal methods.
 	//-----------------------------------------------------------------------------------------------
@@ -258,6 +329,61 @@ namespace Physics
 		m_contactList.clear();
 	}
 
+	// Method for dropping axes and contacts of pairs that went a whole step without being tested.
+	void CRigidbody::EvictCaches()
+	{
+		++m_cacheStep;
+
+		for(size_t i = 0; i < m_sepAxisList.size();)
+		{
+			if(m_cacheStep - m_sepAxisList[i].step > 1)
+			{
+				m_sepAxisList[i] = m_sepAxisList.back();
+				m_sepAxisList.pop_back();
+			}
+			else
+			{
+				++i;
+			}
+		}
+
+		for(size_t i = 0; i < m_manifoldList.size();)
+		{
+			ContactManifold& manifold = m_manifoldList[i];
+			for(u32 p = 0; p < manifold.pointCount;)
+			{
+				if(m_cacheStep - manifold.pointList[p].step > 1)
+				{
+					manifold.pointList[p] = manifold.pointList[--manifold.pointCount];
+				}
+				else
+				{
+					++p;
+				}
+			}
+
+			if(manifold.pointCount == 0)
+			{
+				m_manifoldList[i] = m_manifoldList.back();
+				m_manifoldList.pop_back();
+			}
+			else
+			{
+				++i;
+			}
+		}
+	}
+
+	ContactManifold* CRigidbody::FindManifold(const CVolume* pVolume)
+	{
+		for(ContactManifold& manifold : m_manifoldList)
+		{
+			if(manifold.pVolume == pVolume) { return &manifold; }
+		}
+
+		return nullptr;
+	}
+
 	//-----------------------------------------------------------------------------------------------
 	// Utility methods.
 	//-----------------------------------------------------------------------------------------------
@@ -276,6 +402,127 @@ namespace Physics
 		m_stampQueue.PushBack(nextStamp);
 	}
 
+	// Method for getting the cached separating axis against a feature of a volume, such as a chunk's block.
+	//  Pairs without one start from the initial axis.
+	Math::SIMDVector& CRigidbody::GetSeparatingAxis(const CVolume* pVolume, int feature, const Math::SIMDVector& initial)
+	{
+		for(SepAxis& sepAxis : m_sepAxisList)
+		{
+			if(sepAxis.pVolume == pVolume && sepAxis.feature == feature)
+			{
+				sepAxis.step = m_cacheStep;
+				return sepAxis.axis;
+			}
+		}
+
+		m_sepAxisList.push_back({ pVolume, feature, m_cacheStep, initial });
+		return m_sepAxisList.back().axis;
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// Contact manifold methods.
+	//-----------------------------------------------------------------------------------------------
+
+	// Method for reusing a cached resting contact. The offset is this body's position relative to the volume,
+	//  and the stored distance is carried along the normal by how far the body moved since it was measured.
+	bool CRigidbody::FindContact(const CVolume* pVolume, int feature, const Math::SIMDVector& offset, Math::SIMDVector& normal, float& distance)
+	{
+		ContactManifold* pManifold = FindManifold(pVolume);
+		if(pManifold == nullptr) { return false; }
+
+		for(u32 p = 0; p < pManifold->pointCount; ++p)
+		{
+			ManifoldPoint& point = pManifold->pointList[p];
+			if(point.feature != feature) { continue; }
+
+			const Math::SIMDVector moved = offset - point.offset;
+			if(_mm_cvtss_f32(moved.LengthSq()) > m_data.contactReuseDistance * m_data.contactReuseDistance) { return false; }
+
+			point.step = m_cacheStep;
+			normal = point.normal;
+			distance = point.distance + _mm_cvtss_f32(normal.Dot(moved));
+			return true;
+		}
+
+		return false;
+	}
+
+	// Method for caching a freshly measured resting contact. A full manifold gives up its farthest point.
+	void CRigidbody::StoreContact(const CVolume* pVolume, int feature, const Math::SIMDVector& offset, const Math::SIMDVector& normal, float distance)
+	{
+		ContactManifold* pManifold = FindManifold(pVolume);
+		if(pManifold == nullptr)
+		{
+			m_manifoldList.push_back({ pVolume, 0 });
+			pManifold = &m_manifoldList.back();
+		}
+
+		const ManifoldPoint point { feature, m_cacheStep, distance, normal, offset };
+
+		u32 farthest = 0;
+		for(u32 p = 0; p < pManifold->pointCount; ++p)
+		{
+			if(pManifold->pointList[p].feature == feature)
+			{
+				pManifold->pointList[p] = point;
+				return;
+			}
+
+			if(pManifold->pointList[p].distance > pManifold->pointList[farthest].distance)
+			{
+				farthest = p;
+			}
+		}
+
+		if(pManifold->pointCount < ContactManifold::MAX_POINTS)
+		{
+			pManifold->pointList[pManifold->pointCount++] = point;
+		}
+		else if(pManifold->pointList[farthest].distance > distance)
+		{
+			pManifold->pointList[farthest] = point;
+		}
+	}
+
+	void CRigidbody::RemoveContact(const CVolume* pVolume, int feature)
+	{
+		ContactManifold* pManifold = FindManifold(pVolume);
+		if(pManifold == nullptr) { return; }
+
+		for(u32 p = 0; p < pManifold->pointCount; ++p)
+		{
+			if(pManifold->pointList[p].feature == feature)
+			{
+				pManifold->pointList[p] = pManifold->pointList[--pManifold->pointCount];
+				return;
+			}
+		}
+	}
+
+	// Method for pushing the body out of every contact touched this step, using the cached contacts alone.
+	//  Returns true if the body moved.
+	bool CRigidbody::ProjectContacts()
+	{
+		bool bMoved = false;
+		for(const ContactManifold& manifold : m_manifoldList)
+		{
+			const float skin = m_data.pVolume->GetSkinDepth() + manifold.pVolume->GetSkinDepth();
+			for(u32 p = 0; p < manifold.pointCount; ++p)
+			{
+				const ManifoldPoint& point = manifold.pointList[p];
+				if(point.step != m_cacheStep) { continue; }
+
+				const Math::SIMDVector offset = m_solverPosition - manifold.pVolume->GetSolverPosition();
+				const float push = skin - (point.distance + _mm_cvtss_f32(point.normal.Dot(offset - point.offset)));
+				if(push < 0.0f) { continue; }
+
+				bMoved |= StepIdleSolver(point.normal * push, point.normal);
+			}
+		}
+
+		return bMoved;
+	}
+
 	// Method for attempting to add contact data to the rigidbodies contact list.
 	bool CRigidbody::TryToAddContact(const ContactData& contactData)
 	{
@@ -31,6 +31,15 @@ namespace Physics
 			Math::SIMDQuaternion rotation;
 		};
 
+		// Last separating axis GJK found against one feature of a volume, used to warm start the next query.
+		struct SepAxis
+		{
+			const class CVolume* pVolume;
+			int feature;
+			u32 step;
+			Math::SIMDVector axis;
+		};
+
 	public:
 		struct Data
 		{
@@ -38,10 +47,26 @@ namespace Physics
 			float damping;
 			class CVolume* pVolume;
 
+			// A body slower than the sleep speed for the sleep time is put to sleep until something wakes it.
+			float sleepSpeed = 0.05f;
+			float sleepTime = 0.5f;
+
+			// A cached resting contact is reused while the body stays within this distance of where it was measured.
+			float contactReuseDistance = 0.02f;
+
 			// Modifiers.
 			inline void SetMass(float mass) { invMass = 1.0f / mass; }
 		};
 
+		// State game code can change between steps. The physics recorder captures it so a replay can restore it.
+		struct Input
+		{
+			Math::SIMDVector velocity;
+			Math::SIMDVector acceleration;
+			Math::SIMDVector force;
+			bool bWake;
+		};
+
 
 	public:
 		CRigidbody(const CVObject* pObject);
@@ -52,11 +77,11 @@ namespace Physics
 		CRigidbody& operator = (CRigidbody&&) = delete;
 
 		void Reset();
-		void ResetSolverState();
+		void ResetSolverState(float delta);
 		void UpdateTransform(Logic::CTransform& tranform);
 		void Calculate();
 		bool Response();
-		void Apply(std::function<void()> onWasHit);
+		void Apply(float delta, std::function<void()> onWasHit);
 
 		void SetupIdleSolver();
 		bool StepIdleSolver(const Math::SIMDVector& contact, const Math::SIMDVector& normal);
@@ -64,6 +89,19 @@ namespace Physics
 
 		void UpdateTransformFromVolume();
 		bool TryToAddContact(const ContactData& contactData);
+		Math::SIMDVector& GetSeparatingAxis(const class CVolume* pVolume, int feature, const Math::SIMDVector& initial = Math::SIMD_VEC_FORWARD);
+
+		bool FindContact(const class CVolume* pVolume, int feature, const Math::SIMDVector& offset, Math::SIMDVector& normal, float& distance);
+		void StoreContact(const class CVolume* pVolume, int feature, const Math::SIMDVector& offset, const Math::SIMDVector& normal, float distance);
+		void RemoveContact(const class CVolume* pVolume, int feature);
+		bool ProjectContacts();
+
+		void Wake();
+		bool ProcessWake();
+		bool UpdateSleep(float delta);
+
+		Input GetInput() const;
+		void SetInput(const Input& input);
 		
 		// Accessors.
 		inline const Math::SIMDVector& GetVelocity() const { return m_velocity; }
@@ -72,17 +110,25 @@ namespace Physics
 		inline const Math::SIMDQuaternion& GetSolverRotation() const { return m_solverRotation; }
 		inline bool OnGround() const { return m_bOnGround; }
 		inline bool IsValid() const { return !m_bLastHit; }
+		inline bool IsAsleep() const { return m_bAsleep; }
+		inline bool IsResting() const { return m_sleepTimer > 0.0f; }
+		inline float GetStepScale() const { return m_stepScale; }
 
 		// Modifiers.
 		inline void SetData(const Data& data) { m_data = data; }
 
-		inline void SetAcceleration(const Math::SIMDVector& acceleration) { m_acceleration = acceleration; }
-		inline void SetVelocity(const Math::SIMDVector& velocity) { m_velocity = velocity; }
-		inline void AddForce(const Math::SIMDVector& force) { m_forceAccum += force; }
+		// Number of ticks the body's next step covers. Bodies in throttled regions step less often over a longer delta.
+		inline void SetStepScale(float scale) { m_stepScale = scale; }
+
+		inline void SetAcceleration(const Math::SIMDVector& acceleration) { m_acceleration = acceleration; Wake(); }
+		inline void SetVelocity(const Math::SIMDVector& velocity) { m_velocity = velocity; if(_mm_cvtss_f32(velocity.LengthSq()) > 0.0f) { Wake(); } }
+		inline void AddForce(const Math::SIMDVector& force) { m_forceAccum += force; Wake(); }
 
 	private:
 		void ClearAccumulator();
 		void ClearContacts();
+		void EvictCaches();
+		ContactManifold* FindManifold(const class CVolume* pVolume);
 
 	private:
 		std::mutex m_mutex;
@@ -103,13 +149,22 @@ namespace Physics
 		
 		Math::SIMDVector m_firstContactPoint;
 		std::vector<ContactData> m_contactList;
+		std::vector<SepAxis> m_sepAxisList;
+		std::vector<ContactManifold> m_manifoldList;
+		u32 m_cacheStep;
 		bool m_bLastHit;
 		bool m_bHit;
 		bool m_bOnGround;
+		float m_stepScale;
 
 		Stamp m_lastStamp;
 		Util::CDeque<Stamp> m_stampQueue;
 		float m_interpT;
+
+		// Sleep state is owned by the physics thread. Other threads only request a wake.
+		bool m_bAsleep;
+		float m_sleepTimer;
+		Abool m_bWakeRequested;
 	};
 };
 
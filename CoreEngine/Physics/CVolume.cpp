@@ -12,13 +12,17 @@
 #include "CPhysics.h"
 #include "CRigidbody.h"
 #include "CGJK.h"
+#include "CVolumeSphere.h"
+#include "CVolumeCapsule.h"
+#include "CVolumeOBB.h"
 #include "../Logic/CTransform.h"
 #include "../Utilities/CTimer.h"
 //#include <Windows.h>
 
 namespace Physics
 {
-	CVolume::CVolume(const CVObject* pObject) : CVComponent(pObject), m_sepAxis(Math::SIMD_VEC_FORWARD)
+	CVolume::CVolume(const CVObject* pObject) : CVComponent(pObject),
+		m_snapshotRefs(0)
 	{
 	}
 
@@ -30,11 +34,14 @@ namespace Physics
 	
 	void CVolume::Register(const Math::SIMDMatrix& world)
 	{
+		AddSnapshotRef();
 		Recalculate(world);
 		OnPhysicsRegistered();
 		CPhysics::Instance().RegisterVolume(this);
 	}
 
+	// Volumes shared with snapshots are still read until the physics thread has built past them and every reader
+	//  holding an older snapshot is done. Deregistering doesn't wait for that, the last of them calls OnSnapshotsReleased.
 	void CVolume::Deregister()
 	{
 		CPhysics::Instance().DeregisterVolume(this);
@@ -44,6 +51,16 @@ namespace Physics
 		{
 			GetData().pRigidbody->Reset();
 		}
+
+		ReleaseSnapshotRef();
+	}
+
+	void CVolume::ReleaseSnapshotRef() const
+	{
+		if(m_snapshotRefs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			OnSnapshotsReleased();
+		}
 	}
 	
 	//-----------------------------------------------------------------------------------------------
@@ -52,14 +69,26 @@ namespace Physics
 	
 	// Solving for solving against a moving rigidbody.
 	bool CVolume::MotionSolver(CVolume* pOther)
+	{
+		return SolveMotion(pOther, 0);
+	}
+	
+	// Solving for solving against an idle/resting rigidbody.
+	bool CVolume::IdleSolver(CVolume* pOther)
+	{
+		return SolveIdle(pOther, 0);
+	}
+
+	bool CVolume::SolveMotion(CVolume* pOther, int feature)
 	{
 		ContactData contactData { };
 		Math::SIMDVector r = (pOther->GetSolverVelocity() - GetSolverVelocity());
+		Math::SIMDVector& sepAxis = pOther->GetRigidbody()->GetSeparatingAxis(this, feature);
 
-		if(CGJK::MovingContact(this, pOther, r, contactData.hitPoint, contactData.hitNormal, contactData.interval, pOther->m_sepAxis))
+		if(CGJK::MovingContact(this, pOther, r, contactData.hitPoint, contactData.hitNormal, contactData.interval, sepAxis))
 		{
 			contactData.pVolume = this;
-			contactData.index = 0;
+			contactData.index = feature;
 
 			if(contactData.interval == 0.0f)
 			{
@@ -78,21 +107,116 @@ namespace Physics
 		return false;
 	}
 	
-	// Solving for solving against an idle/resting rigidbody.
-	bool CVolume::IdleSolver(CVolume* pOther)
+	// Resting contacts are cached per feature, and GJK only runs again once the rigidbody has moved too far from where
+	//  the cached contact was measured.
+	bool CVolume::SolveIdle(CVolume* pOther, int feature)
 	{
-		Math::SIMDVector contactA;
-		Math::SIMDVector contactB;
+		CRigidbody* pRigidbody = pOther->GetRigidbody();
+		const Math::SIMDVector offset = pOther->GetSolverPosition() - GetSolverPosition();
+
 		Math::SIMDVector normal = Math::SIMD_VEC_ZERO;
+		float distance;
 
-		if(CGJK::RestingContact(this, pOther, contactA, contactB, normal))
+		if(!pRigidbody->FindContact(this, feature, offset, normal, distance))
 		{
-			return pOther->GetRigidbody()->StepIdleSolver(contactB, normal);
+			Math::SIMDVector contactA;
+			Math::SIMDVector contactB;
+			Math::SIMDVector& sepAxis = pRigidbody->GetSeparatingAxis(this, feature);
+
+			if(!CGJK::RestingContact(this, pOther, contactA, contactB, normal, sepAxis, distance))
+			{
+				pRigidbody->RemoveContact(this, feature);
+				return false;
+			}
+
+			if(distance < 0.0f)
+			{ // Cores overlap, so there's no distance to carry forward.
+				pRigidbody->RemoveContact(this, feature);
+				return pRigidbody->StepIdleSolver(contactB, normal);
+			}
+
+			pRigidbody->StoreContact(this, feature, offset, normal, distance);
 		}
 
-		return false;
+		const float push = GetSkinDepth() + pOther->GetSkinDepth() - distance;
+		if(push < 0.0f) { return false; }
+
+		return pRigidbody->StepIdleSolver(normal * push, normal);
 	}
 	
+	//-----------------------------------------------------------------------------------------------
+	// Query methods.
+	//-----------------------------------------------------------------------------------------------
+
+	// Method for sweeping a query shape against this volume.
+	bool CVolume::SweepTest(const CVolume* pShape, const Math::SIMDVector& displacement, SweepInfo& info) const
+	{
+		Math::SIMDVector sepAxis = Math::SIMD_VEC_FORWARD;
+		if(!CGJK::MovingContact(this, pShape, displacement, info.point, info.normal, info.interval, sepAxis)) { return false; }
+
+		info.index = 0;
+		info.pVolume = this;
+
+		if(info.interval == 0.0f)
+		{
+			info.normal = -CGJK::Distance(this, pShape, false);
+			if(_mm_cvtss_f32(info.normal.LengthSq()) > Math::g_EpsilonTol * Math::g_EpsilonTol)
+			{
+				info.normal.Normalize();
+			}
+		}
+
+		return true;
+	}
+
+	bool CVolume::OverlapTest(const CVolume* pShape, std::vector<OverlapInfo>& infoList) const
+	{
+		if(!CGJK::Intersection(this, pShape)) { return false; }
+
+		infoList.push_back({ 0, this });
+		return true;
+	}
+
+	// Method for shaping and placing the volume that stands in for a query. Each thread has its own stand-ins.
+	const CVolume* CVolume::PlaceQueryVolume(const QueryVolume& volume)
+	{
+		thread_local CVolumeSphere querySphere(nullptr);
+		thread_local CVolumeCapsule queryCapsule(nullptr);
+		thread_local CVolumeOBB queryOBB(nullptr);
+
+		CVolume* pVolume = nullptr;
+
+		switch(volume.shape)
+		{
+			case QueryShape::Sphere:
+			{
+				CVolumeSphere::Data data { };
+				data.radius = volume.radius;
+				querySphere.SetData(data);
+				pVolume = &querySphere;
+			} break;
+			case QueryShape::Capsule:
+			{
+				CVolumeCapsule::Data data { };
+				data.radius = volume.radius;
+				data.height = volume.height;
+				queryCapsule.SetData(data);
+				pVolume = &queryCapsule;
+			} break;
+			case QueryShape::OBB:
+			default:
+			{
+				CVolumeOBB::Data data { };
+				data.halfSize = volume.halfSize;
+				queryOBB.SetData(data);
+				pVolume = &queryOBB;
+			} break;
+		}
+
+		pVolume->Place(volume.position, volume.rotation);
+		return pVolume;
+	}
+
 	//-----------------------------------------------------------------------------------------------
 	// Internal methods.
 	//-----------------------------------------------------------------------------------------------
@@ -146,4 +270,12 @@ namespace Physics
 
 		UpdateBounds();
 	}
+
+	void CVolume::Place(const Math::SIMDVector& position, const Math::SIMDQuaternion& rotation)
+	{
+		m_position = position;
+		m_rotation = rotation;
+
+		UpdateBounds();
+	}
 };
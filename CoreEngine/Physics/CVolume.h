@@ -12,6 +12,7 @@
 #define CVOLUME_H
 
 #include "CPhysicsData.h"
+#include "../Globals/CGlobals.h"
 #include "../Objects/CVComponent.h"
 #include "../Math/CSIMDVector.h"
 #include "../Math/CMathVector3.h"
@@ -54,10 +55,29 @@ namespace Physics
 
 		// We are always assuming a rigid world matrix for physics colliders.
 		void Recalculate(const Math::SIMDMatrix& world);
+
+		// Method for moving a volume that isn't registered with the world, such as a query shape.
+		void Place(const Math::SIMDVector& position, const Math::SIMDQuaternion& rotation);
 		
 		virtual bool RayTest(const QueryRay& query, RaycastInfo& info) const { return false; }
+		virtual bool SweepTest(const CVolume* pShape, const Math::SIMDVector& displacement, SweepInfo& info) const;
+		virtual bool OverlapTest(const CVolume* pShape, std::vector<OverlapInfo>& infoList) const;
 		virtual Math::SIMDVector SupportPoint(const Math::SIMDVector& dir, const CVolume* pVolumeA, float inset = 0.0f) const { return Math::SIMD_VEC_ZERO; }
 
+		// Method for copying the volume's shape and solver placement into a standalone volume, reusing pCopy if it's the same
+		//  shape. Volumes that can't be copied return nullptr.
+		virtual CVolume* CopyShape(CVolume* pCopy) const { return nullptr; }
+
+		// Snapshots query volumes they couldn't copy in place, so they hold a reference to them, as does registration.
+		//  Whoever lets go last once the volume is deregistered calls OnSnapshotsReleased.
+		inline void AddSnapshotRef() const { m_snapshotRefs.fetch_add(1, std::memory_order_relaxed); }
+		void ReleaseSnapshotRef() const;
+
+		static const CVolume* PlaceQueryVolume(const QueryVolume& volume);
+
+		// Whether grid colliders may resolve against the volume's bounds instead of running GJK on its exact shape.
+		virtual bool AllowsBoundsSolver() const { return false; }
+
 		// Accessors.
 		inline const CVObject* GetVObject() const { return m_pObject; }
 
@@ -73,8 +93,24 @@ namespace Physics
 		inline class CForceField* GetForceField() const { return GetData().pForceField; }
 
 	protected:
+		// Solvers against one feature of the volume. Features key the rigidbody's cached separating axes.
+		bool SolveMotion(CVolume* pOther, int feature);
+		bool SolveIdle(CVolume* pOther, int feature);
+
 		virtual inline const mData& GetData() const = 0;
 
+		// Called from whichever thread drops the last reference after deregistering, so owners can free what queries
+		//  read from the volume without waiting on readers of older snapshots.
+		virtual void OnSnapshotsReleased() const { }
+
+		// Method for dropping the links a copied volume mustn't share with its source.
+		static inline void ClearLinks(mData& data)
+		{
+			data.pRigidbody = nullptr;
+			data.pForceField = nullptr;
+			data.onCollision = nullptr;
+		}
+
 		// Accessors
 		inline const Math::SIMDVector& GetPosition() const { return m_position; }
 		inline const Math::SIMDQuaternion& GetRotation() const { return m_rotation; }
@@ -99,8 +135,8 @@ namespace Physics
 	private:
 		Math::SIMDVector m_position;
 		Math::SIMDQuaternion m_rotation;
-		
-		Math::SIMDVector m_sepAxis;
+
+		mutable Au32 m_snapshotRefs;
 	};
 };
 
@@ -0,0 +1,135 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Copyright (c) Ryan Alasandro
+//
+// Static Library: Core Engine
+//
+// File: Physics/CVolumeArray.cpp
+//
+//-------------------------------------------------------------------------------------------------
+
+#include "CVolumeArray.h"
+#include "CVolume.h"
+#include "../Objects/CVObject.h"
+
+namespace Physics
+{
+	CVolumeArray::CVolumeArray() { }
+
+	CVolumeArray::~CVolumeArray() { }
+
+	// Method for appending a volume. Adding a volume that is already present returns its existing slot.
+	u32 CVolumeArray::Add(CVolume* pVolume)
+	{
+		const u64 handle = pVolume->GetVObject()->GetHash();
+
+		auto elem = m_slotMap.find(handle);
+		if(elem != m_slotMap.end()) { return elem->second; }
+
+		const u32 slot = Size();
+		m_slotMap.insert({ handle, slot });
+
+		m_volumeList.push_back(pVolume);
+		m_handleList.push_back(handle);
+		m_positionList.push_back(0.0f);
+		m_rotationList.push_back(0.0f);
+		m_minExtentsList.push_back(0.0f);
+		m_maxExtentsList.push_back(0.0f);
+		m_velocityList.push_back(0.0f);
+		m_proxyList.push_back(CAABBTree::NULL_NODE);
+
+		Gather(slot);
+		return slot;
+	}
+
+	bool CVolumeArray::Remove(const CVolume* pVolume)
+	{
+		auto elem = m_slotMap.find(pVolume->GetVObject()->GetHash());
+		if(elem == m_slotMap.end()) { return false; }
+
+		const u32 slot = elem->second;
+		const u32 last = Size() - 1;
+		m_slotMap.erase(elem);
+
+		if(slot != last)
+		{ // Move the last volume into the hole.
+			m_volumeList[slot] = m_volumeList[last];
+			m_handleList[slot] = m_handleList[last];
+			m_positionList[slot] = m_positionList[last];
+			m_rotationList[slot] = m_rotationList[last];
+			m_minExtentsList[slot] = m_minExtentsList[last];
+			m_maxExtentsList[slot] = m_maxExtentsList[last];
+			m_velocityList[slot] = m_velocityList[last];
+			m_proxyList[slot] = m_proxyList[last];
+
+			m_slotMap[m_handleList[slot]] = slot;
+		}
+
+		m_volumeList.pop_back();
+		m_handleList.pop_back();
+		m_positionList.pop_back();
+		m_rotationList.pop_back();
+		m_minExtentsList.pop_back();
+		m_maxExtentsList.pop_back();
+		m_velocityList.pop_back();
+		m_proxyList.pop_back();
+
+		return true;
+	}
+
+	void CVolumeArray::Clear()
+	{
+		m_slotMap.clear();
+		m_volumeList.clear();
+		m_handleList.clear();
+		m_positionList.clear();
+		m_rotationList.clear();
+		m_minExtentsList.clear();
+		m_maxExtentsList.clear();
+		m_velocityList.clear();
+		m_proxyList.clear();
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// State methods.
+	//-----------------------------------------------------------------------------------------------
+
+	// Method for refreshing the cached state of every volume from its solver transform.
+	void CVolumeArray::Gather()
+	{
+		for(u32 slot = 0; slot < Size(); ++slot)
+		{
+			Gather(slot);
+		}
+	}
+
+	void CVolumeArray::Gather(u32 slot)
+	{
+		const CVolume* pVolume = m_volumeList[slot];
+
+		m_positionList[slot] = *reinterpret_cast<const Math::Vector3*>(pVolume->GetSolverPosition().ToFloat());
+		m_rotationList[slot] = *reinterpret_cast<const Math::Vector4*>(pVolume->GetSolverRotation().ToFloat());
+		m_minExtentsList[slot] = pVolume->GetMinExtents();
+		m_maxExtentsList[slot] = pVolume->GetMaxExtents();
+		m_velocityList[slot] = *reinterpret_cast<const Math::Vector3*>(pVolume->GetVelocity().ToFloat());
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// Query methods.
+	//-----------------------------------------------------------------------------------------------
+
+	u32 CVolumeArray::Find(u64 handle) const
+	{
+		auto elem = m_slotMap.find(handle);
+		return elem == m_slotMap.end() ? INVALID_SLOT : elem->second;
+	}
+
+	// Method for getting the world space bounds of a volume from its cached state.
+	CAABBTree::AABB CVolumeArray::GetBounds(u32 slot) const
+	{
+		CAABBTree::AABB aabb;
+		aabb.mn = m_positionList[slot] + m_minExtentsList[slot];
+		aabb.mx = m_positionList[slot] + m_maxExtentsList[slot];
+		return aabb;
+	}
+};
@@ -0,0 +1,80 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Copyright (c) Ryan Alasandro
+//
+// Static Library: Core Engine
+//
+// File: Physics/CVolumeArray.h
+//
+//-------------------------------------------------------------------------------------------------
+
+#ifndef CVOLUMEARRAY_H
+#define CVOLUMEARRAY_H
+
+#include "CAABBTree.h"
+#include "../Globals/CGlobals.h"
+#include "../Math/CMathVector3.h"
+#include "../Math/CMathVector4.h"
+#include <unordered_map>
+#include <vector>
+
+namespace Physics
+{
+	// Dense storage for a set of volumes. Per-volume state is kept as parallel arrays so the solver can scan it linearly.
+	//  Removal swaps the last volume into the freed slot, and the handle map tracks where each volume lives.
+	class CVolumeArray
+	{
+	public:
+		static const u32 INVALID_SLOT = ~0U;
+
+	public:
+		CVolumeArray();
+		~CVolumeArray();
+		CVolumeArray(const CVolumeArray&) = delete;
+		CVolumeArray(CVolumeArray&&) = delete;
+		CVolumeArray& operator = (const CVolumeArray&) = delete;
+		CVolumeArray& operator = (CVolumeArray&&) = delete;
+
+		u32 Add(class CVolume* pVolume);
+		bool Remove(const class CVolume* pVolume);
+		void Clear();
+
+		void Gather();
+		void Gather(u32 slot);
+
+		u32 Find(u64 handle) const;
+		CAABBTree::AABB GetBounds(u32 slot) const;
+
+		// Accessors.
+		inline u32 Size() const { return static_cast<u32>(m_volumeList.size()); }
+		inline class CVolume* operator [] (u32 slot) const { return m_volumeList[slot]; }
+
+		inline std::vector<class CVolume*>::const_iterator begin() const { return m_volumeList.begin(); }
+		inline std::vector<class CVolume*>::const_iterator end() const { return m_volumeList.end(); }
+
+		inline const Math::Vector3& GetPosition(u32 slot) const { return m_positionList[slot]; }
+		inline const Math::Vector4& GetRotation(u32 slot) const { return m_rotationList[slot]; }
+		inline const Math::Vector3& GetMinExtents(u32 slot) const { return m_minExtentsList[slot]; }
+		inline const Math::Vector3& GetMaxExtents(u32 slot) const { return m_maxExtentsList[slot]; }
+		inline const Math::Vector3& GetVelocity(u32 slot) const { return m_velocityList[slot]; }
+		inline u32 GetProxy(u32 slot) const { return m_proxyList[slot]; }
+
+		// Modifiers.
+		inline void SetProxy(u32 slot, u32 proxy) { m_proxyList[slot] = proxy; }
+
+	private:
+		std::unordered_map<u64, u32> m_slotMap;
+
+		std::vector<class CVolume*> m_volumeList;
+		std::vector<u64> m_handleList;
+
+		std::vector<Math::Vector3> m_positionList;
+		std::vector<Math::Vector4> m_rotationList;
+		std::vector<Math::Vector3> m_minExtentsList;
+		std::vector<Math::Vector3> m_maxExtentsList;
+		std::vector<Math::Vector3> m_velocityList;
+		std::vector<u32> m_proxyList;
+	};
+};
+
+#endif
@@ -17,6 +17,18 @@ namespace Physics
 	CVolumeCapsule::CVolumeCapsule(const CVObject* pObject) : CVolume(pObject) { }
 	CVolumeCapsule::~CVolumeCapsule() { }
 
+	CVolume* CVolumeCapsule::CopyShape(CVolume* pCopy) const
+	{
+		CVolumeCapsule* pCapsule = dynamic_cast<CVolumeCapsule*>(pCopy);
+		if(pCapsule == nullptr) { pCapsule = new CVolumeCapsule(nullptr); }
+
+		Data data = m_data;
+		ClearLinks(data);
+		pCapsule->SetData(data);
+		pCapsule->Place(GetSolverPosition(), GetSolverRotation());
+		return pCapsule;
+	}
+
 	void CVolumeCapsule::UpdateBounds()
 	{
 		Math::SIMDVector d1 = GetRotation() * Math::SIMD_VEC_UP;
@@ -37,6 +37,8 @@ namespace Physics
 		void UpdateBounds() final;
 		bool RayTest(const QueryRay& query, RaycastInfo& info) const final;
 		Math::SIMDVector SupportPoint(const Math::SIMDVector& dir, const CVolume* pVolumeA, float inset = 0.0f) const final;
+		bool AllowsBoundsSolver() const final { return true; }
+		CVolume* CopyShape(CVolume* pCopy) const final;
 
 		// Modifiers.
 		inline void SetData(const Data& data) { m_data = data; }
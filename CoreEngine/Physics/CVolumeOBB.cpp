@@ -14,6 +14,18 @@ namespace Physics
 {
 	CVolumeOBB::CVolumeOBB(const CVObject* pObject) : CVolume(pObject) { }
 	CVolumeOBB::~CVolumeOBB() { }
+
+	CVolume* CVolumeOBB::CopyShape(CVolume* pCopy) const
+	{
+		CVolumeOBB* pOBB = dynamic_cast<CVolumeOBB*>(pCopy);
+		if(pOBB == nullptr) { pOBB = new CVolumeOBB(nullptr); }
+
+		Data data = m_data;
+		ClearLinks(data);
+		pOBB->SetData(data);
+		pOBB->Place(GetSolverPosition(), GetSolverRotation());
+		return pOBB;
+	}
 	
 	void CVolumeOBB::UpdateBounds()
 	{
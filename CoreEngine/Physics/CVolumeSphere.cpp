@@ -15,6 +15,18 @@ namespace Physics
 {
 	CVolumeSphere::CVolumeSphere(const CVObject* pObject) : CVolume(pObject) { }
 	CVolumeSphere::~CVolumeSphere() { }
+
+	CVolume* CVolumeSphere::CopyShape(CVolume* pCopy) const
+	{
+		CVolumeSphere* pSphere = dynamic_cast<CVolumeSphere*>(pCopy);
+		if(pSphere == nullptr) { pSphere = new CVolumeSphere(nullptr); }
+
+		Data data = m_data;
+		ClearLinks(data);
+		pSphere->SetData(data);
+		pSphere->Place(GetSolverPosition(), GetSolverRotation());
+		return pSphere;
+	}
 	
 	void CVolumeSphere::UpdateBounds()
 	{
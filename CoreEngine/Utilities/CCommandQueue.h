@@ -0,0 +1,229 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Copyright (c) Ryan Alasandro
+//
+// Static Library: Core Engine
+//
+// File: Utilities/CCommandQueue.h
+//
+//-------------------------------------------------------------------------------------------------
+
+#ifndef CCOMMANDQUEUE_H
+#define CCOMMANDQUEUE_H
+
+#include "../Globals/CGlobals.h"
+#include <atomic>
+#include <new>
+#include <utility>
+
+namespace Util
+{
+	// This creates a lock-free queue for many producer threads and a single consumer thread. Producers push with one
+	//  compare-exchange, and the consumer takes everything pushed so far with one exchange and runs it in push order.
+	//  Nodes come from blocks owned by the queue and are recycled through a free list once consumed, so pushing only
+	//  allocates when every node handed out so far is still queued.
+	template<typename T>
+	class CCommandQueue
+	{
+	private:
+		static const u32 BLOCK_SIZE = 256;
+		static const u32 MAX_BLOCKS = 1024;
+		static const u32 MAX_NODES = BLOCK_SIZE * MAX_BLOCKS;
+
+		// Index of a node made on the heap once the blocks ran out. It's deleted after use instead of recycled.
+		static const u32 HEAP_INDEX = ~0U;
+
+		struct Node
+		{
+			alignas(T) u8 data[sizeof(T)];
+			Node* pNext;
+
+			// Free list link, as an index plus one so zero ends the list.
+			Au32 freeNext;
+			u32 index;
+
+			inline T& Get() { return *reinterpret_cast<T*>(data); }
+		};
+
+	public:
+		CCommandQueue() : m_pHead(nullptr), m_freeHead(0), m_nodeCount(0)
+		{
+			for(u32 i = 0; i < MAX_BLOCKS; ++i)
+			{
+				m_blockList[i].store(nullptr, std::memory_order_relaxed);
+			}
+		}
+
+		~CCommandQueue()
+		{
+			Clear();
+
+			for(u32 i = 0; i < MAX_BLOCKS; ++i)
+			{
+				delete[] m_blockList[i].load(std::memory_order_relaxed);
+			}
+		}
+
+		CCommandQueue(const CCommandQueue&) = delete;
+		CCommandQueue(CCommandQueue&&) = delete;
+		CCommandQueue& operator = (const CCommandQueue&) = delete;
+		CCommandQueue& operator = (CCommandQueue&&) = delete;
+
+		// Push methods.
+		void Push(const T& data)
+		{
+			Node* pNode = Acquire();
+			new(pNode->data) T(data);
+			Link(pNode);
+		}
+
+		void Push(T&& data)
+		{
+			Node* pNode = Acquire();
+			new(pNode->data) T(std::move(data));
+			Link(pNode);
+		}
+
+		// Method for running func on every queued command, oldest first. Returns the number of commands consumed.
+		//  Only the consumer thread may call this.
+		template<typename F>
+		size_t Consume(F func)
+		{
+			Node* pNode = m_pHead.exchange(nullptr, std::memory_order_acquire);
+
+			// The list is newest first, so reverse it to restore push order.
+			Node* pFirst = nullptr;
+			while(pNode)
+			{
+				Node* pNext = pNode->pNext;
+				pNode->pNext = pFirst;
+				pFirst = pNode;
+				pNode = pNext;
+			}
+
+			if(pFirst == nullptr) { return 0; }
+
+			// Consumed nodes are chained through their free links and handed back together.
+			Node* pFreeFirst = nullptr;
+			Node* pFreeLast = nullptr;
+
+			size_t count = 0;
+			while(pFirst)
+			{
+				Node* pNext = pFirst->pNext;
+				func(pFirst->Get());
+				pFirst->Get().~T();
+
+				if(pFirst->index == HEAP_INDEX)
+				{
+					delete pFirst;
+				}
+				else
+				{
+					if(pFreeLast) { pFreeLast->freeNext.store(pFirst->index + 1, std::memory_order_relaxed); }
+					else { pFreeFirst = pFirst; }
+					pFreeLast = pFirst;
+				}
+
+				pFirst = pNext;
+				++count;
+			}
+
+			if(pFreeFirst) { Release(pFreeFirst, pFreeLast); }
+			return count;
+		}
+
+		// Method for dropping every queued command. Returns the number of commands dropped.
+		size_t Clear()
+		{
+			return Consume([](T&){ });
+		}
+
+		// Empty?
+		bool Empty() const
+		{
+			return m_pHead.load(std::memory_order_acquire) == nullptr;
+		}
+
+	private:
+		void Link(Node* pNode)
+		{
+			pNode->pNext = m_pHead.load(std::memory_order_relaxed);
+			while(!m_pHead.compare_exchange_weak(pNode->pNext, pNode, std::memory_order_release, std::memory_order_relaxed)) { }
+		}
+
+		// Method for taking a node off the free list, or carving a new one from the blocks if the list is empty. The
+		//  free list head is tagged with a count of every change made to it, so a stale pop can't succeed. Once every
+		//  block is handed out, nodes come from the heap until the consumer catches up.
+		Node* Acquire()
+		{
+			u64 head = m_freeHead.load(std::memory_order_acquire);
+			while(static_cast<u32>(head) != 0)
+			{
+				Node* pNode = GetNode(static_cast<u32>(head) - 1);
+				const u64 next = ((head >> 32) + 1) << 32 | pNode->freeNext.load(std::memory_order_relaxed);
+				if(m_freeHead.compare_exchange_weak(head, next, std::memory_order_acquire, std::memory_order_acquire))
+				{
+					return pNode;
+				}
+			}
+
+			// The count is checked first so producers stuck on the heap don't keep adding to it.
+			const u32 index = m_nodeCount.load(std::memory_order_relaxed) < MAX_NODES ? m_nodeCount.fetch_add(1, std::memory_order_relaxed) : MAX_NODES;
+			if(index >= MAX_NODES)
+			{
+				Node* pNode = new Node;
+				pNode->index = HEAP_INDEX;
+				return pNode;
+			}
+
+			const u32 block = index / BLOCK_SIZE;
+
+			Node* pBlock = m_blockList[block].load(std::memory_order_acquire);
+			if(pBlock == nullptr)
+			{ // First node of a block, or a producer raced ahead of it. Whoever loses the race drops their block.
+				Node* pNew = new Node[BLOCK_SIZE];
+				for(u32 i = 0; i < BLOCK_SIZE; ++i)
+				{
+					pNew[i].index = block * BLOCK_SIZE + i;
+				}
+
+				if(m_blockList[block].compare_exchange_strong(pBlock, pNew, std::memory_order_acq_rel, std::memory_order_acquire))
+				{
+					pBlock = pNew;
+				}
+				else
+				{
+					delete[] pNew;
+				}
+			}
+
+			return &pBlock[index % BLOCK_SIZE];
+		}
+
+		// Method for handing a chain of consumed nodes back to the free list. Consumer only.
+		void Release(Node* pFirst, Node* pLast)
+		{
+			u64 head = m_freeHead.load(std::memory_order_relaxed);
+			u64 next;
+			do
+			{
+				pLast->freeNext.store(static_cast<u32>(head), std::memory_order_relaxed);
+				next = ((head >> 32) + 1) << 32 | (pFirst->index + 1);
+			} while(!m_freeHead.compare_exchange_weak(head, next, std::memory_order_release, std::memory_order_relaxed));
+		}
+
+		inline Node* GetNode(u32 index) const
+		{
+			return &m_blockList[index / BLOCK_SIZE].load(std::memory_order_acquire)[index % BLOCK_SIZE];
+		}
+
+	private:
+		std::atomic<Node*> m_pHead;
+		Au64 m_freeHead;
+		Au32 m_nodeCount;
+		std::atomic<Node*> m_blockList[MAX_BLOCKS];
+	};
+};
+
+#endif
@@ -106,4 +106,15 @@ namespace Util
 			m_timeElapsed = 0.0f;
 		}
 	}
+
+	// Method for advancing by a fixed delta without reading the clock, such as when replaying recorded ticks.
+	void CTimer::Step(float delta)
+	{
+		m_lastTime = std::chrono::steady_clock::now();
+
+		m_delta = delta;
+		m_time += delta;
+		m_smoothDelta = delta;
+		m_smoothTime += delta;
+	}
 };
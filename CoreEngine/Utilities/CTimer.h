@@ -35,6 +35,7 @@ namespace Util
 		}
 
 		void Tick();
+		void Step(float delta);
 
 		//
 		// Inline methods.
@@ -0,0 +1,145 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Copyright (c) Ryan Alasandro
+//
+// Static Library: Core Engine
+//
+// File: Utilities/CWSDeque.h
+//
+//-------------------------------------------------------------------------------------------------
+
+#ifndef CWSDEQUE_H
+#define CWSDEQUE_H
+
+#include "../Globals/CGlobals.h"
+#include <atomic>
+#include <vector>
+
+namespace Util
+{
+	// Lock-free work-stealing deque (Chase-Lev). Only the owning thread may push and pop, at the bottom,
+	//  while any other thread may steal from the top. The buffer grows when full, and outgrown buffers are
+	//  kept until the deque is destroyed since a thief may still be reading one. T must be trivially copyable.
+	template<typename T>
+	class CWSDeque
+	{
+	private:
+		struct Buffer
+		{
+			s64 capacity;
+			std::atomic<T>* pData;
+
+			explicit Buffer(s64 cap) : capacity(cap), pData(new std::atomic<T>[cap]) { }
+			~Buffer() { delete[] pData; }
+
+			inline T Get(s64 index) const { return pData[index & (capacity - 1)].load(std::memory_order_relaxed); }
+			inline void Put(s64 index, T data) { pData[index & (capacity - 1)].store(data, std::memory_order_relaxed); }
+		};
+
+	public:
+		// The capacity should be a power of two.
+		explicit CWSDeque(s64 capacity = 256) :
+			m_top(0),
+			m_bottom(0),
+			m_buffer(new Buffer(capacity)) { }
+
+		~CWSDeque()
+		{
+			delete m_buffer.load(std::memory_order_relaxed);
+			for(Buffer* pBuffer : m_retiredList)
+			{
+				delete pBuffer;
+			}
+		}
+
+		CWSDeque(const CWSDeque&) = delete;
+		CWSDeque(CWSDeque&&) = delete;
+		CWSDeque& operator = (const CWSDeque&) = delete;
+		CWSDeque& operator = (CWSDeque&&) = delete;
+
+		// Owner only.
+		void Push(T data)
+		{
+			const s64 b = m_bottom.load(std::memory_order_relaxed);
+			const s64 t = m_top.load(std::memory_order_acquire);
+			Buffer* pBuffer = m_buffer.load(std::memory_order_relaxed);
+
+			if(b - t > pBuffer->capacity - 1)
+			{
+				pBuffer = Grow(pBuffer, b, t);
+			}
+
+			pBuffer->Put(b, data);
+			std::atomic_thread_fence(std::memory_order_release);
+			m_bottom.store(b + 1, std::memory_order_relaxed);
+		}
+
+		// Owner only. Pops the newest entry.
+		bool TryPop(T& data)
+		{
+			const s64 b = m_bottom.load(std::memory_order_relaxed) - 1;
+			Buffer* pBuffer = m_buffer.load(std::memory_order_relaxed);
+			m_bottom.store(b, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			s64 t = m_top.load(std::memory_order_relaxed);
+
+			if(t > b)
+			{ // Empty.
+				m_bottom.store(b + 1, std::memory_order_relaxed);
+				return false;
+			}
+
+			data = pBuffer->Get(b);
+			if(t == b)
+			{ // Last entry, so race any thieves for it.
+				const bool bWon = m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+				m_bottom.store(b + 1, std::memory_order_relaxed);
+				return bWon;
+			}
+
+			return true;
+		}
+
+		// Any thread. Steals the oldest entry. Fails if empty or if another thread won the entry.
+		bool TrySteal(T& data)
+		{
+			s64 t = m_top.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const s64 b = m_bottom.load(std::memory_order_acquire);
+
+			if(t >= b) { return false; }
+
+			Buffer* pBuffer = m_buffer.load(std::memory_order_acquire);
+			data = pBuffer->Get(t);
+			return m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+		}
+
+		// Approximate when other threads are pushing or stealing.
+		bool Empty() const
+		{
+			return m_bottom.load(std::memory_order_relaxed) <= m_top.load(std::memory_order_relaxed);
+		}
+
+	private:
+		Buffer* Grow(Buffer* pBuffer, s64 b, s64 t)
+		{
+			Buffer* pGrown = new Buffer(pBuffer->capacity * 2);
+			for(s64 i = t; i < b; ++i)
+			{
+				pGrown->Put(i, pBuffer->Get(i));
+			}
+
+			m_retiredList.push_back(pBuffer);
+			m_buffer.store(pGrown, std::memory_order_release);
+			return pGrown;
+		}
+
+	private:
+		alignas(64) std::atomic<s64> m_top;
+		alignas(64) std::atomic<s64> m_bottom;
+		std::atomic<Buffer*> m_buffer;
+		std::vector<Buffer*> m_retiredList;
+	};
+};
+
+#endif
@@ -14,6 +14,7 @@
 #include "../Resources/CResourceManager.h"
 #include "../Factory/CFactory.h"
 #include "../Graphics/CGraphicsAPI.h"
+#include "../Graphics/CMeshAllocator.h"
 #include <Application/CCoreManager.h>
 #include <Physics/CPhysics.h>
 
@@ -151,6 +152,7 @@ namespace App
 		
 		m_garbage.Release();
 		Util::CJobSystem::Instance().Release();
+		Graphics::CMeshAllocator::Instance().Release();
 
 		m_audioMixer.Release();
 		Physics::CPhysics::Instance().Release();
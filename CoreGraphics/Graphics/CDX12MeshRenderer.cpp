@@ -28,6 +28,8 @@ namespace Graphics
 		m_pVertexBufferUpload(nullptr),
 		m_pIndexBuffer(nullptr),
 		m_pIndexBufferUpload(nullptr),
+		m_vertexCapacity(0),
+		m_indexCapacity(0),
 		m_pBundle(nullptr),
 		m_pDX12Graphics(nullptr) {
 	}
@@ -45,98 +47,24 @@ namespace Graphics
 
 		if(m_data.pMeshData->GetVertexSize())
 		{
-			{ // Create the vertex buffer.
-				CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_DEFAULT);
-				CD3DX12_RESOURCE_DESC resDesc = CD3DX12_RESOURCE_DESC::Buffer(m_data.pMeshData->GetVertexSize());
-				ASSERT_HR_R(m_pDX12Graphics->GetDevice()->CreateCommittedResource(
-					&heapProps,
-					D3D12_HEAP_FLAG_NONE,
-					&resDesc,
-					D3D12_RESOURCE_STATE_COPY_DEST,
-					nullptr,
-					IID_PPV_ARGS(&m_pVertexBuffer)
-				));
-
-				NAME_D3D12_OBJECT(m_pVertexBuffer);
-			}
-
-			{ // Create the vertex upload buffer.
-				const u64 uploadBufferSize = GetRequiredIntermediateSize(m_pVertexBuffer, 0, 1);
-				CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_UPLOAD);
-				CD3DX12_RESOURCE_DESC resDesc = CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize);
-				ASSERT_HR_R(m_pDX12Graphics->GetDevice()->CreateCommittedResource(
-					&heapProps,
-					D3D12_HEAP_FLAG_NONE,
-					&resDesc,
-					D3D12_RESOURCE_STATE_GENERIC_READ,
-					nullptr,
-					IID_PPV_ARGS(&m_pVertexBufferUpload)
-				));
-			}
-
-			// Prepare for the upload of vertex data.
-			D3D12_SUBRESOURCE_DATA vertexData { };
-			vertexData.pData = m_data.pMeshData->GetVertexList();
-			vertexData.RowPitch = static_cast<LONG_PTR>(m_data.pMeshData->GetVertexSize());
-			vertexData.SlicePitch = vertexData.RowPitch;
-
-			UpdateSubresources<1>(m_pDX12Graphics->GetAssetCommandList(), m_pVertexBuffer, m_pVertexBufferUpload, 0, 0, 1, &vertexData);
+			UploadBuffer(&m_pVertexBuffer, &m_pVertexBufferUpload, m_vertexCapacity, L"m_pVertexBuffer",
+				m_data.pMeshData->GetVertexList(), m_data.pMeshData->GetVertexSize(), D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER, barrierList[barrierCount++]);
 
 			// Create the vertex buffer's view.
 			m_vertexBufferView.BufferLocation = m_pVertexBuffer->GetGPUVirtualAddress();
 			m_vertexBufferView.StrideInBytes = m_data.pMeshData->GetVertexStride();
 			m_vertexBufferView.SizeInBytes = m_data.pMeshData->GetVertexSize();
-
-			// Make sure to transition the vertex buffer to a state that can be feed through the pipeline for rendering.
-			barrierList[barrierCount++] = CD3DX12_RESOURCE_BARRIER::Transition(m_pVertexBuffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
 		}
 
 		if(m_data.pMeshData->GetIndexSize())
 		{
-			{ // Create the index buffer.
-				CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_DEFAULT);
-				CD3DX12_RESOURCE_DESC resDesc = CD3DX12_RESOURCE_DESC::Buffer(m_data.pMeshData->GetIndexSize());
-				ASSERT_HR_R(m_pDX12Graphics->GetDevice()->CreateCommittedResource(
-					&heapProps,
-					D3D12_HEAP_FLAG_NONE,
-					&resDesc,
-					D3D12_RESOURCE_STATE_COPY_DEST,
-					nullptr,
-					IID_PPV_ARGS(&m_pIndexBuffer)
-				));
-
-				NAME_D3D12_OBJECT(m_pIndexBuffer);
-			}
-
-			{ // Create the index upload buffer.
-				const u64 uploadBufferSize = GetRequiredIntermediateSize(m_pIndexBuffer, 0, 1);
-				CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_UPLOAD);
-				CD3DX12_RESOURCE_DESC resDesc = CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize);
-				ASSERT_HR_R(m_pDX12Graphics->GetDevice()->CreateCommittedResource(
-					&heapProps,
-					D3D12_HEAP_FLAG_NONE,
-					&resDesc,
-					D3D12_RESOURCE_STATE_GENERIC_READ,
-					nullptr,
-					IID_PPV_ARGS(&m_pIndexBufferUpload)
-				));
-			}
-
-			// Prepare for the upload of index data.
-			D3D12_SUBRESOURCE_DATA indexData { };
-			indexData.pData = m_data.pMeshData->GetIndexList();
-			indexData.RowPitch = static_cast<LONG_PTR>(m_data.pMeshData->GetIndexSize());
-			indexData.SlicePitch = indexData.RowPitch;
-
-			UpdateSubresources<1>(m_pDX12Graphics->GetAssetCommandList(), m_pIndexBuffer, m_pIndexBufferUpload, 0, 0, 1, &indexData);
+			UploadBuffer(&m_pIndexBuffer, &m_pIndexBufferUpload, m_indexCapacity, L"m_pIndexBuffer",
+				m_data.pMeshData->GetIndexList(), m_data.pMeshData->GetIndexSize(), D3D12_RESOURCE_STATE_INDEX_BUFFER, barrierList[barrierCount++]);
 
 			// Create the index buffer's view.
 			m_indexBufferView.BufferLocation = m_pIndexBuffer->GetGPUVirtualAddress();
 			m_indexBufferView.Format = m_data.pMeshData->GetIndexStride() == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
 			m_indexBufferView.SizeInBytes = m_data.pMeshData->GetIndexSize();
-
-			// Make sure to transition the vertex buffer to a state that can be feed through the pipeline for rendering.
-			barrierList[barrierCount++] = CD3DX12_RESOURCE_BARRIER::Transition(m_pIndexBuffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_INDEX_BUFFER);
 		}
 
 		if(barrierCount)
@@ -195,5 +123,81 @@ namespace Graphics
 
 		SAFE_RELEASE(m_pIndexBufferUpload);
 		SAFE_RELEASE(m_pVertexBufferUpload);
+
+		m_indexCapacity = m_vertexCapacity = 0;
+	}
+
+	// Method for releasing the bundle but keeping the buffers, so the next initialize only has to copy new data into them.
+	// The caller must make sure the GPU is done with the previous mesh.
+	void CDX12MeshRenderer::Recycle()
+	{
+		CMeshRenderer::Release();
+
+		SAFE_RELEASE(m_pBundle);
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// Utility methods.
+	//-----------------------------------------------------------------------------------------------
+
+	// Method for copying data into a default heap buffer through an upload heap.
+	// Both are reused when they can hold the data, otherwise they're recreated with some headroom for growth.
+	void CDX12MeshRenderer::UploadBuffer(ID3D12Resource** ppBuffer, ID3D12Resource** ppUpload, u64& capacity, LPCWSTR pName,
+		const u8* pData, u64 size, D3D12_RESOURCE_STATES state, D3D12_RESOURCE_BARRIER& barrier)
+	{
+		ID3D12GraphicsCommandList* pCommandList = m_pDX12Graphics->GetAssetCommandList();
+
+		if(*ppBuffer && capacity >= size)
+		{ // Move the existing buffer back to a copy destination.
+			CD3DX12_RESOURCE_BARRIER copyBarrier = CD3DX12_RESOURCE_BARRIER::Transition(*ppBuffer, state, D3D12_RESOURCE_STATE_COPY_DEST);
+			pCommandList->ResourceBarrier(1, &copyBarrier);
+		}
+		else
+		{ // Create the buffer.
+			SAFE_RELEASE(*ppUpload);
+			SAFE_RELEASE(*ppBuffer);
+
+			capacity = size + (size >> 2);
+
+			CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_DEFAULT);
+			CD3DX12_RESOURCE_DESC resDesc = CD3DX12_RESOURCE_DESC::Buffer(capacity);
+			ASSERT_HR_R(m_pDX12Graphics->GetDevice()->CreateCommittedResource(
+				&heapProps,
+				D3D12_HEAP_FLAG_NONE,
+				&resDesc,
+				D3D12_RESOURCE_STATE_COPY_DEST,
+				nullptr,
+				IID_PPV_ARGS(ppBuffer)
+			));
+
+			SetName(*ppBuffer, pName);
+		}
+
+		if(*ppUpload == nullptr)
+		{ // Create the upload buffer.
+			CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_UPLOAD);
+			CD3DX12_RESOURCE_DESC resDesc = CD3DX12_RESOURCE_DESC::Buffer(capacity);
+			ASSERT_HR_R(m_pDX12Graphics->GetDevice()->CreateCommittedResource(
+				&heapProps,
+				D3D12_HEAP_FLAG_NONE,
+				&resDesc,
+				D3D12_RESOURCE_STATE_GENERIC_READ,
+				nullptr,
+				IID_PPV_ARGS(ppUpload)
+			));
+		}
+
+		{ // Copy the data. Only the used range is written, the rest of the buffer is left as is.
+			void* pMapped = nullptr;
+			CD3DX12_RANGE readRange(0, 0);
+			ASSERT_HR_R((*ppUpload)->Map(0, &readRange, &pMapped));
+			memcpy(pMapped, pData, size);
+			(*ppUpload)->Unmap(0, nullptr);
+
+			pCommandList->CopyBufferRegion(*ppBuffer, 0, *ppUpload, 0, size);
+		}
+
+		// Make sure to transition the buffer to a state that can be feed through the pipeline for rendering.
+		barrier = CD3DX12_RESOURCE_BARRIER::Transition(*ppBuffer, D3D12_RESOURCE_STATE_COPY_DEST, state);
 	}
 };
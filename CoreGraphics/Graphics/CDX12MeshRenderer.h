@@ -31,6 +31,10 @@ namespace Graphics
 		void PostInitialize() final;
 		void Render() final;
 		void Release() final;
+		void Recycle() final;
+
+		void UploadBuffer(ID3D12Resource** ppBuffer, ID3D12Resource** ppUpload, u64& capacity, LPCWSTR pName,
+			const u8* pData, u64 size, D3D12_RESOURCE_STATES state, D3D12_RESOURCE_BARRIER& barrier);
 
 	private:
 		D3D12_VERTEX_BUFFER_VIEW m_vertexBufferView;
@@ -41,6 +45,10 @@ namespace Graphics
 		ID3D12Resource* m_pIndexBuffer;
 		ID3D12Resource* m_pIndexBufferUpload;
 
+		// Buffers are created with some headroom and reused across recycles while the mesh still fits.
+		u64 m_vertexCapacity;
+		u64 m_indexCapacity;
+
 		ID3D12GraphicsCommandList* m_pBundle;
 
 		class CDX12Graphics* m_pDX12Graphics;
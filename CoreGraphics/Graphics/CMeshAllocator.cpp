@@ -0,0 +1,172 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Copyright (c) Ryan Alasandro
+//
+// Static Library: Core Graphics
+//
+// File: Graphics/CMeshAllocator.cpp
+//
+//-------------------------------------------------------------------------------------------------
+
+#include "CMeshAllocator.h"
+#include <algorithm>
+
+namespace Graphics
+{
+	static const size_t BLOCK_ALIGNMENT = 16;
+
+	CMeshAllocator::CMeshAllocator() :
+		m_reservedBytes(0),
+		m_usedBytes(0),
+		m_requestedBytes(0),
+		m_largeCount(0),
+		m_allocationCount(0)
+	{
+		// Size classes step a quarter of a power of two at a time, keeping the rounding waste of any block under 25%.
+		for(size_t base = MIN_BLOCK_SIZE; base < SLAB_SIZE; base <<= 1)
+		{
+			for(u32 i = 0; i < SUB_CLASS_COUNT; ++i)
+			{
+				m_classList.push_back({ base + i * (base / SUB_CLASS_COUNT), nullptr, nullptr, nullptr });
+			}
+		}
+
+		m_classList.push_back({ SLAB_SIZE, nullptr, nullptr, nullptr });
+	}
+
+	CMeshAllocator::~CMeshAllocator() { }
+
+	// Method for allocating a block of at least the requested size. Capacity receives the real size of the block.
+	u8* CMeshAllocator::Allocate(size_t size, size_t& capacity)
+	{
+		if(size == 0)
+		{
+			capacity = 0;
+			return nullptr;
+		}
+
+		std::lock_guard<std::mutex> lk(m_mutex);
+
+		++m_allocationCount;
+		m_requestedBytes += size;
+
+		if(size > SLAB_SIZE)
+		{ // Large meshes get their own allocation.
+			capacity = size;
+			m_reservedBytes += capacity;
+			m_usedBytes += capacity;
+			++m_largeCount;
+			return reinterpret_cast<u8*>(_mm_malloc(capacity, BLOCK_ALIGNMENT));
+		}
+
+		SizeClass& sizeClass = m_classList[FindClass(size)];
+		capacity = sizeClass.size;
+		m_usedBytes += capacity;
+
+		if(sizeClass.pFreeList)
+		{
+			FreeBlock* pBlock = sizeClass.pFreeList;
+			sizeClass.pFreeList = pBlock->pNext;
+			return reinterpret_cast<u8*>(pBlock);
+		}
+
+		if(sizeClass.pCarve == nullptr || sizeClass.pCarve + capacity > sizeClass.pCarveEnd)
+		{ // Carve the class a new slab. Whatever is left of the old one stays reserved and shows up as fragmentation.
+			u8* pSlab = reinterpret_cast<u8*>(_mm_malloc(SLAB_SIZE, BLOCK_ALIGNMENT));
+			m_slabList.push_back(pSlab);
+			m_reservedBytes += SLAB_SIZE;
+
+			sizeClass.pCarve = pSlab;
+			sizeClass.pCarveEnd = pSlab + SLAB_SIZE;
+		}
+
+		u8* pBuffer = sizeClass.pCarve;
+		sizeClass.pCarve += capacity;
+		return pBuffer;
+	}
+
+	void CMeshAllocator::Free(u8* pBuffer, size_t capacity, size_t size)
+	{
+		if(pBuffer == nullptr) { return; }
+
+		std::lock_guard<std::mutex> lk(m_mutex);
+
+		--m_allocationCount;
+		m_requestedBytes -= size;
+		m_usedBytes -= capacity;
+
+		if(capacity > SLAB_SIZE)
+		{
+			m_reservedBytes -= capacity;
+			--m_largeCount;
+			_mm_free(pBuffer);
+			return;
+		}
+
+		SizeClass& sizeClass = m_classList[FindClass(capacity)];
+		FreeBlock* pBlock = reinterpret_cast<FreeBlock*>(pBuffer);
+		pBlock->pNext = sizeClass.pFreeList;
+		sizeClass.pFreeList = pBlock;
+	}
+
+	// Method for returning every slab to the system. Any block still handed out is invalid afterwards.
+	void CMeshAllocator::Release()
+	{
+		std::lock_guard<std::mutex> lk(m_mutex);
+
+		for(u8* pSlab : m_slabList)
+		{
+			_mm_free(pSlab);
+		}
+
+		m_slabList.clear();
+
+		for(SizeClass& sizeClass : m_classList)
+		{
+			sizeClass.pFreeList = nullptr;
+			sizeClass.pCarve = sizeClass.pCarveEnd = nullptr;
+		}
+
+		m_reservedBytes = m_usedBytes = m_requestedBytes = 0;
+		m_largeCount = m_allocationCount = 0;
+	}
+
+	CMeshAllocator::Stats CMeshAllocator::GetStats() const
+	{
+		std::lock_guard<std::mutex> lk(m_mutex);
+
+		Stats stats { };
+		stats.reservedBytes = m_reservedBytes;
+		stats.usedBytes = m_usedBytes;
+		stats.requestedBytes = m_requestedBytes;
+		stats.slabCount = static_cast<u32>(m_slabList.size());
+		stats.largeCount = m_largeCount;
+		stats.allocationCount = m_allocationCount;
+
+		for(const SizeClass& sizeClass : m_classList)
+		{
+			for(const FreeBlock* pBlock = sizeClass.pFreeList; pBlock; pBlock = pBlock->pNext)
+			{
+				stats.freeBytes += sizeClass.size;
+			}
+		}
+
+		stats.internalFragmentation = m_usedBytes ? 1.0f - static_cast<float>(m_requestedBytes) / m_usedBytes : 0.0f;
+		stats.externalFragmentation = m_reservedBytes ? 1.0f - static_cast<float>(m_usedBytes) / m_reservedBytes : 0.0f;
+
+		return stats;
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// Utility methods.
+	//-----------------------------------------------------------------------------------------------
+
+	u32 CMeshAllocator::FindClass(size_t size) const
+	{
+		auto it = std::lower_bound(m_classList.begin(), m_classList.end(), size, [](const SizeClass& sizeClass, size_t size){
+			return sizeClass.size < size;
+		});
+
+		return static_cast<u32>(it - m_classList.begin());
+	}
+};
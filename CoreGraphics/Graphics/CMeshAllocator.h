@@ -0,0 +1,97 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Copyright (c) Ryan Alasandro
+//
+// Static Library: Core Graphics
+//
+// File: Graphics/CMeshAllocator.h
+//
+//-------------------------------------------------------------------------------------------------
+
+#ifndef CMESHALLOCATOR_H
+#define CMESHALLOCATOR_H
+
+#include <Globals/CGlobals.h>
+#include <mutex>
+#include <vector>
+
+namespace Graphics
+{
+	class CMeshAllocator
+	{
+	public:
+		static const size_t MIN_BLOCK_SIZE = 256;
+		static const size_t SLAB_SIZE = 4 << 20;
+		static const u32 SUB_CLASS_COUNT = 4;
+
+		struct Stats
+		{
+			size_t reservedBytes; // Bytes held by slabs and large blocks.
+			size_t usedBytes; // Bytes handed out, rounded up to their size class.
+			size_t requestedBytes; // Bytes callers asked for.
+			size_t freeBytes; // Bytes sitting on free lists.
+
+			u32 slabCount;
+			u32 largeCount;
+			u32 allocationCount;
+
+			// Internal fragmentation is the rounding waste inside live blocks.
+			// External fragmentation is reserved memory that isn't handed out.
+			float internalFragmentation;
+			float externalFragmentation;
+		};
+
+	private:
+		struct FreeBlock
+		{
+			FreeBlock* pNext;
+		};
+
+		struct SizeClass
+		{
+			size_t size;
+			FreeBlock* pFreeList;
+			u8* pCarve;
+			u8* pCarveEnd;
+		};
+
+	public:
+		static CMeshAllocator& Instance()
+		{
+			static CMeshAllocator instance;
+			return instance;
+		}
+
+	private:
+		CMeshAllocator();
+		~CMeshAllocator();
+		CMeshAllocator(const CMeshAllocator&) = delete;
+		CMeshAllocator(CMeshAllocator&&) = delete;
+		CMeshAllocator& operator = (const CMeshAllocator&) = delete;
+		CMeshAllocator& operator = (CMeshAllocator&&) = delete;
+
+	public:
+		u8* Allocate(size_t size, size_t& capacity);
+		void Free(u8* pBuffer, size_t capacity, size_t size);
+		void Release();
+
+		Stats GetStats() const;
+
+	private:
+		u32 FindClass(size_t size) const;
+
+	private:
+		mutable std::mutex m_mutex;
+
+		std::vector<SizeClass> m_classList;
+		std::vector<u8*> m_slabList;
+
+		size_t m_reservedBytes;
+		size_t m_usedBytes;
+		size_t m_requestedBytes;
+		u32 m_largeCount;
+		u32 m_allocationCount;
+	};
+};
+
+#endif
@@ -9,6 +9,7 @@
 //-------------------------------------------------------------------------------------------------
 
 #include "CMeshData.h"
+#include "CMeshAllocator.h"
 
 namespace Graphics
 {
@@ -16,7 +17,8 @@ namespace Graphics
 		CVComponent(pObject),
 		m_pVertexList(nullptr),
 		m_pIndexList(nullptr),
-		m_pBuffer(nullptr) {
+		m_pBuffer(nullptr),
+		m_bufferCapacity(0) {
 	}
 
 	CMeshData::~CMeshData() { }
@@ -27,15 +29,16 @@ namespace Graphics
 		m_indexSize = m_data.indexCount * m_data.indexStride;
 		const u32 totalSize = m_vertexSize + m_indexSize;
 
-		m_pBuffer = new u8[totalSize];
+		m_pBuffer = CMeshAllocator::Instance().Allocate(totalSize, m_bufferCapacity);
 		m_pVertexList = m_pBuffer;
 		m_pIndexList = m_pVertexList + m_vertexSize;
 	}
 
 	void CMeshData::Release()
 	{
-		delete[] m_pBuffer;
+		CMeshAllocator::Instance().Free(m_pBuffer, m_bufferCapacity, m_vertexSize + m_indexSize);
 		m_pIndexList = m_pVertexList = m_pBuffer = nullptr;
+		m_bufferCapacity = 0;
 	}
 
 	//-----------------------------------------------------------------------------------------------
@@ -75,6 +75,7 @@ namespace Graphics
 		u8* m_pVertexList;
 		u8* m_pIndexList;
 		u8* m_pBuffer;
+		size_t m_bufferCapacity;
 	};
 };
 
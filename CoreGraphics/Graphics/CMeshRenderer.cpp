@@ -41,4 +41,11 @@ namespace Graphics
 			CRenderer::Release();
 		}
 	}
+
+	// Method for releasing everything tied to the current mesh so the renderer can be initialized again with new data.
+	// Implementations may hold on to their buffers for reuse.
+	void CMeshRenderer::Recycle()
+	{
+		Release();
+	}
 };
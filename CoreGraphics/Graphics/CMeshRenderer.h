@@ -43,6 +43,7 @@ namespace Graphics
 
 		void Initialize() override;
 		void Release() override;
+		virtual void Recycle();
 
 		// Accessors.
 		inline class CMaterial* GetMaterial() const final { return m_data.pMaterial; }
@@ -0,0 +1,118 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Copyright (c) Ryan Alasandro
+//
+// Static Library: Core Graphics
+//
+// File: Utilities/CJob.h
+//
+//-------------------------------------------------------------------------------------------------
+
+#ifndef CJOB_H
+#define CJOB_H
+
+#include <Globals/CGlobals.h>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Util
+{
+	// Count of outstanding jobs. Each job submitted with the counter is added to it, and taken off once it has run.
+	class CJobCounter
+	{
+	public:
+		CJobCounter() : m_count(0) { }
+		~CJobCounter() { }
+		CJobCounter(const CJobCounter&) = delete;
+		CJobCounter(CJobCounter&&) = delete;
+		CJobCounter& operator = (const CJobCounter&) = delete;
+		CJobCounter& operator = (CJobCounter&&) = delete;
+
+		inline void Add(u32 count) { m_count.fetch_add(count, std::memory_order_relaxed); }
+		inline void Done() { m_count.fetch_sub(1, std::memory_order_release); }
+
+		// Accessors.
+		inline bool IsDone() const { return m_count.load(std::memory_order_acquire) == 0; }
+
+	private:
+		Au32 m_count;
+	};
+
+	// One cache line holding a job's closure, its counter and the pool link. Closures up to the inline size live in the
+	//  job itself, larger ones fall back to the heap. Jobs are handed out by the job system's pools, never made directly.
+	class alignas(64) CJob
+	{
+	public:
+		static const size_t INLINE_SIZE = 40;
+
+	public:
+		CJob() : m_pInvoke(nullptr), m_pCounter(nullptr), m_pNext(nullptr) { }
+		~CJob() { }
+		CJob(const CJob&) = delete;
+		CJob(CJob&&) = delete;
+		CJob& operator = (const CJob&) = delete;
+		CJob& operator = (CJob&&) = delete;
+
+		template<typename F>
+		void Set(F&& func, CJobCounter* pCounter)
+		{
+			typedef typename std::decay<F>::type Func;
+			Store<Func>(std::forward<F>(func), std::integral_constant<bool, sizeof(Func) <= INLINE_SIZE && alignof(Func) <= 16>());
+			m_pCounter = pCounter;
+		}
+
+		inline void Run() { m_pInvoke(this, true); Finish(); }
+
+		// Method for dropping a job that will never run. Its counter is still released so nothing waits forever.
+		inline void Discard() { m_pInvoke(this, false); Finish(); }
+
+		// Accessors.
+		inline CJob* GetNext() const { return m_pNext; }
+
+		// Modifiers.
+		inline void SetNext(CJob* pNext) { m_pNext = pNext; }
+
+	private:
+		// Method for placing a closure that fits in the job itself.
+		template<typename Func, typename F>
+		void Store(F&& func, std::true_type)
+		{
+			new(m_storage) Func(std::forward<F>(func));
+			m_pInvoke = [](CJob* pJob, bool bRun){
+				Func* pFunc = reinterpret_cast<Func*>(pJob->m_storage);
+				if(bRun) { (*pFunc)(); }
+				pFunc->~Func();
+			};
+		}
+
+		// Method for placing a closure too large for the job on the heap, keeping only its pointer inline.
+		template<typename Func, typename F>
+		void Store(F&& func, std::false_type)
+		{
+			Func* pFunc = new Func(std::forward<F>(func));
+			memcpy(m_storage, &pFunc, sizeof(pFunc));
+			m_pInvoke = [](CJob* pJob, bool bRun){
+				Func* pFunc = nullptr;
+				memcpy(&pFunc, pJob->m_storage, sizeof(pFunc));
+				if(bRun) { (*pFunc)(); }
+				delete pFunc;
+			};
+		}
+
+		inline void Finish()
+		{
+			if(m_pCounter) { m_pCounter->Done(); }
+			m_pCounter = nullptr;
+		}
+
+	private:
+		alignas(16) u8 m_storage[INLINE_SIZE];
+		void (*m_pInvoke)(CJob* pJob, bool bRun);
+		CJobCounter* m_pCounter;
+		CJob* m_pNext;
+	};
+};
+
+#endif
@@ -0,0 +1,154 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Copyright (c) Ryan Alasandro
+//
+// Static Library: Core Graphics
+//
+// File: Utilities/CJobGraph.cpp
+//
+//-------------------------------------------------------------------------------------------------
+
+#include "CJobGraph.h"
+#include "CJobSystem.h"
+#include <cassert>
+
+namespace Util
+{
+	CJobGraph::CJobGraph() :
+		m_pState(std::make_shared<State>())
+	{
+		m_pState->remaining = 0;
+	}
+
+	CJobGraph::~CJobGraph() { }
+
+	//-----------------------------------------------------------------------------------------------
+	// Build methods.
+	//-----------------------------------------------------------------------------------------------
+
+	CJobGraph::Node CJobGraph::Add(std::function<void()> func, JobType type)
+	{
+		assert(m_pState);
+
+		Job& job = m_pState->jobList.emplace_back();
+		job.func = std::move(func);
+		job.type = type;
+		job.dependencyCount = 0;
+		job.pending = 0;
+
+		return static_cast<Node>(m_pState->jobList.size() - 1);
+	}
+
+	// Method for adding a job that runs once the node finishes.
+	CJobGraph::Node CJobGraph::Then(Node node, std::function<void()> func, JobType type)
+	{
+		const Node next = Add(std::move(func), type);
+		Depend(next, node);
+		return next;
+	}
+
+	// Method for adding a job that runs once every node in the list finishes.
+	CJobGraph::Node CJobGraph::Join(const Node* pNodeList, u32 count, std::function<void()> func, JobType type)
+	{
+		const Node next = Add(std::move(func), type);
+		for(u32 i = 0; i < count; ++i)
+		{
+			Depend(next, pNodeList[i]);
+		}
+
+		return next;
+	}
+
+	// Method for making the node wait on the dependency. Dependencies have to be added before their dependents,
+	//  which keeps the graph free of cycles.
+	void CJobGraph::Depend(Node node, Node dependency)
+	{
+		assert(m_pState && dependency < node && node < m_pState->jobList.size());
+
+		m_pState->jobList[dependency].successorList.push_back(node);
+		++m_pState->jobList[node].dependencyCount;
+	}
+
+	// Method for queuing every job without dependencies. The rest follow as their dependencies finish. The future,
+	//  and the completion callback if there is one, are signaled from the job thread that finishes the last job.
+	std::future<void> CJobGraph::Submit(std::function<void()> onComplete)
+	{
+		assert(m_pState);
+
+		std::shared_ptr<State> pState = std::move(m_pState);
+		std::future<void> f = pState->promise.get_future();
+
+		pState->onComplete = std::move(onComplete);
+		pState->remaining = static_cast<u32>(pState->jobList.size());
+
+		for(Job& job : pState->jobList)
+		{
+			job.pending = job.dependencyCount;
+		}
+
+		if(pState->jobList.empty())
+		{
+			if(pState->onComplete) { pState->onComplete(); }
+			pState->promise.set_value();
+			return f;
+		}
+
+		// Roots are found before any are queued, since a fast job could start releasing its successors.
+		std::vector<Node> rootList;
+		for(Node node = 0; node < static_cast<Node>(pState->jobList.size()); ++node)
+		{
+			if(pState->jobList[node].dependencyCount == 0) { rootList.push_back(node); }
+		}
+
+		for(Node node : rootList)
+		{
+			Queue(pState, node);
+		}
+
+		return f;
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// Run methods.
+	//-----------------------------------------------------------------------------------------------
+
+	void CJobGraph::Queue(const std::shared_ptr<State>& pState, Node node)
+	{
+		// Small enough to fit in a pooled job, so CPU jobs queue without allocating.
+		auto run = [pState, node](){
+			pState->jobList[node].func();
+			Finish(pState, node);
+		};
+
+		switch(pState->jobList[node].type)
+		{
+			case JobType::CPU:
+				CJobSystem::Instance().JobCPU(run);
+				break;
+			case JobType::Graphics:
+				CJobSystem::Instance().JobGraphics(run, true);
+				break;
+			case JobType::Compute:
+				CJobSystem::Instance().JobCompute(run, true);
+				break;
+		}
+	}
+
+	// Method for releasing the successors of a finished job. Whichever dependency finishes last queues the successor.
+	void CJobGraph::Finish(const std::shared_ptr<State>& pState, Node node)
+	{
+		for(Node next : pState->jobList[node].successorList)
+		{
+			if(pState->jobList[next].pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				Queue(pState, next);
+			}
+		}
+
+		if(pState->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			if(pState->onComplete) { pState->onComplete(); }
+			pState->promise.set_value();
+		}
+	}
+};
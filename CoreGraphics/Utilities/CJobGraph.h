@@ -0,0 +1,82 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Copyright (c) Ryan Alasandro
+//
+// Static Library: Core Graphics
+//
+// File: Utilities/CJobGraph.h
+//
+//-------------------------------------------------------------------------------------------------
+
+#ifndef CJOBGRAPH_H
+#define CJOBGRAPH_H
+
+#include <Globals/CGlobals.h>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <vector>
+
+namespace Util
+{
+	// Set of async jobs with dependencies between them, submitted to the job system as a whole. Each job is queued
+	//  the moment the last job it depends on finishes, so a pipeline runs through without polling or blocking a job
+	//  thread. Jobs are added and linked before Submit, and the graph can be let go of as soon as it's submitted.
+	class CJobGraph
+	{
+	public:
+		enum class JobType
+		{
+			CPU,
+			Graphics,
+			Compute,
+		};
+
+		typedef u32 Node;
+
+	public:
+		CJobGraph();
+		~CJobGraph();
+		CJobGraph(const CJobGraph&) = delete;
+		CJobGraph(CJobGraph&&) = delete;
+		CJobGraph& operator = (const CJobGraph&) = delete;
+		CJobGraph& operator = (CJobGraph&&) = delete;
+
+		Node Add(std::function<void()> func, JobType type = JobType::CPU);
+		Node Then(Node node, std::function<void()> func, JobType type = JobType::CPU);
+		Node Join(const Node* pNodeList, u32 count, std::function<void()> func, JobType type = JobType::CPU);
+		void Depend(Node node, Node dependency);
+
+		std::future<void> Submit(std::function<void()> onComplete = nullptr);
+
+	private:
+		struct Job
+		{
+			std::function<void()> func;
+			JobType type;
+			std::vector<Node> successorList;
+
+			// Jobs that have to finish first. The pending count is what's left of it once submitted.
+			u32 dependencyCount;
+			Au32 pending;
+		};
+
+		// Shared with the queued jobs, so it outlives the graph.
+		struct State
+		{
+			std::deque<Job> jobList;
+			Au32 remaining;
+			std::function<void()> onComplete;
+			std::promise<void> promise;
+		};
+
+		static void Queue(const std::shared_ptr<State>& pState, Node node);
+		static void Finish(const std::shared_ptr<State>& pState, Node node);
+
+	private:
+		std::shared_ptr<State> m_pState;
+	};
+};
+
+#endif
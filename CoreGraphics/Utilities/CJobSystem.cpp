@@ -13,14 +13,23 @@
 #include "../Graphics/CGraphicsWorker.h"
 #include "../Graphics/CGraphicsAPI.h"
 #include "../Factory/CFactory.h"
+#include <Windows.h>
+#include <thread>
 
 namespace Util
 {
+	// Times an idle job thread looks for work again before parking.
+	static const u32 SPIN_COUNT = 64;
+
 	thread_local CWorker CJobSystem::m_worker;
+	thread_local s32 CJobSystem::m_threadIndex = -1;
+	thread_local CJobSystem::JobFreeList CJobSystem::m_jobFreeList;
 
 	CJobSystem::CJobSystem() : 
 		m_exitFlag(false),
-		m_threadCount(4)
+		m_threadCount(0),
+		m_parkedCount(0),
+		m_signal(0)
 	{
 	}
 
@@ -33,12 +42,24 @@ namespace Util
 	
 	void CJobSystem::Open()
 	{
+		m_threadCount = m_data.threadCount;
+		if(m_threadCount == 0)
+		{
+			m_threadCount = max(std::thread::hardware_concurrency(), 2U) - 1;
+		}
+
+		// Every deque has to exist before any thread can steal from it.
+		for(u32 i = 0; i < m_threadCount; ++i)
+		{
+			m_jobDequeList.push_back(std::make_unique<Util::CWSDeque<CJob*>>());
+		}
+
 		for(u32 i = 0; i < m_threadCount; ++i)
 		{
 			std::promise<void> p;
 			std::future<void> f = p.get_future();
 			m_threadDeque.PushBack(f);
-			std::thread t(&CJobSystem::JobThread, this, std::move(p));
+			std::thread t(&CJobSystem::JobThread, this, i, std::move(p));
 			t.detach();
 		}
 	}
@@ -64,7 +85,12 @@ namespace Util
 	
 	void CJobSystem::Close()
 	{
-		m_exitFlag = true;
+		{
+			std::lock_guard<std::mutex> lk(m_parkMutex);
+			m_exitFlag = true;
+			m_parkCondition.notify_all();
+		}
+
 		for(u32 i = 0; i < m_threadCount; ++i)
 		{
 			std::future<void> f;
@@ -73,11 +99,20 @@ namespace Util
 				f.wait();
 			}
 		}
+
+		// Jobs that never ran are dropped, which breaks their futures and releases their counters.
+		CJob* pJob = nullptr;
+		while(FindJob(pJob))
+		{
+			pJob->Discard();
+			FreeJob(pJob);
+		}
 	}
 	
 	void CJobSystem::Release()
 	{
 		m_worker.Release();
+		ReleaseJobs();
 	}
 
 	//-----------------------------------------------------------------------------------------------
@@ -94,7 +129,7 @@ namespace Util
 
 		if(bAsync)
 		{
-			m_asyncDeque.PushBack(task);
+			Submit(task);
 		}
 		else
 		{
@@ -114,7 +149,7 @@ namespace Util
 		
 		if(bAsync)
 		{
-			m_asyncDeque.PushBack(task);
+			Submit(task);
 		}
 		else
 		{
@@ -134,7 +169,7 @@ namespace Util
 		
 		if(bAsync)
 		{
-			m_asyncDeque.PushBack(task);
+			Submit(task);
 		}
 		else
 		{
@@ -144,27 +179,278 @@ namespace Util
 		return f;
 	}
 	
+	//-----------------------------------------------------------------------------------------------
+	// Data parallel methods.
+	//-----------------------------------------------------------------------------------------------
+
+	// Method for running func over sub-ranges of [begin, end), no smaller than the grain, across the job threads.
+	//  The calling thread works on the range too, and returns once all of it is done. Safe to nest inside jobs.
+	void CJobSystem::ParallelFor(u32 begin, u32 end, u32 grain, const std::function<void(u32, u32)>& func)
+	{
+		if(end <= begin) { return; }
+
+		ParallelChunks(begin, end, GetChunkSize(end - begin, grain), [&func](u32 chunk, u32 first, u32 last){
+			func(first, last);
+		});
+	}
+
+	// Method for picking a chunk size. Ranges are cut into a few chunks per thread so uneven chunks even out,
+	//  rounded up to a whole number of grains.
+	u32 CJobSystem::GetChunkSize(u32 count, u32 grain) const
+	{
+		grain = max(grain, 1U);
+
+		const u32 targetCount = (m_threadCount + 1) * 4;
+		const u32 chunkSize = max((count + targetCount - 1) / targetCount, grain);
+		return (chunkSize + grain - 1) / grain * grain;
+	}
+
+	// Method for splitting the range into chunks and running them. Helper jobs are only queued for chunks the caller
+	//  can't get to itself, and the caller never waits on a chunk nobody has claimed. A late helper finds nothing
+	//  left and exits, which is why the range is shared with the helpers rather than living on the stack.
+	void CJobSystem::ParallelChunks(u32 begin, u32 end, u32 chunkSize, const std::function<void(u32, u32, u32)>& func)
+	{
+		std::shared_ptr<ParallelRange> pRange = std::make_shared<ParallelRange>();
+		pRange->begin = begin;
+		pRange->end = end;
+		pRange->chunkSize = chunkSize;
+		pRange->chunkCount = (end - begin + chunkSize - 1) / chunkSize;
+		pRange->next = 0;
+		pRange->counter.Add(pRange->chunkCount);
+		pRange->pFunc = &func;
+
+		const u32 helperCount = min(pRange->chunkCount - 1, m_threadCount);
+		for(u32 i = 0; i < helperCount; ++i)
+		{
+			JobCPU([pRange](){ RunChunks(*pRange); });
+		}
+
+		RunChunks(*pRange);
+		Wait(pRange->counter);
+	}
+
+	void CJobSystem::RunChunks(ParallelRange& range)
+	{
+		while(true)
+		{
+			const u32 chunk = range.next.fetch_add(1, std::memory_order_relaxed);
+			if(chunk >= range.chunkCount) { break; }
+
+			const u32 first = range.begin + chunk * range.chunkSize;
+			const u32 last = min(first + range.chunkSize, range.end);
+			(*range.pFunc)(chunk, first, last);
+
+			range.counter.Done();
+		}
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// Scheduling methods.
+	//-----------------------------------------------------------------------------------------------
+
+	// Method for waiting until every job added to the counter has run. Job threads keep running other jobs meanwhile,
+	//  everyone else yields since they may not have a worker set up for them.
+	void CJobSystem::Wait(const CJobCounter& counter)
+	{
+		while(!counter.IsDone())
+		{
+			CJob* pJob = nullptr;
+			if(m_threadIndex >= 0 && FindJob(pJob))
+			{
+				pJob->Run();
+				FreeJob(pJob);
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	// Method for queuing an async job. Job threads push onto their own deque, everyone else onto the injection deque.
+	void CJobSystem::Submit(CJob* pJob)
+	{
+		if(m_threadIndex >= 0)
+		{
+			m_jobDequeList[m_threadIndex]->Push(pJob);
+		}
+		else
+		{
+			m_injectDeque.PushBack(pJob);
+		}
+
+		Wake();
+	}
+
+	// Method for queuing a job that reports through a future. The task only holds its shared state, so it fits in the job.
+	void CJobSystem::Submit(std::packaged_task<void()>& task)
+	{
+		CJob* pJob = AllocateJob();
+		pJob->Set([task = std::move(task)]() mutable { task(); }, nullptr);
+		Submit(pJob);
+	}
+
+	// Method for finding the next job for this thread: its own newest job, then injected jobs, then the oldest job
+	//  of another thread. Thieves start at a random deque so they don't all contend on the same one.
+	bool CJobSystem::FindJob(CJob*& pJob)
+	{
+		if(m_threadIndex >= 0 && m_jobDequeList[m_threadIndex]->TryPop(pJob)) { return true; }
+		if(m_injectDeque.TryPopFront(pJob)) { return true; }
+
+		thread_local u32 seed = 0x9E3779B9U ^ static_cast<u32>(m_threadIndex + 1);
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+
+		const u32 count = static_cast<u32>(m_jobDequeList.size());
+		for(u32 i = 0; i < count; ++i)
+		{
+			const u32 victim = (seed + i) % count;
+			if(static_cast<s32>(victim) == m_threadIndex) { continue; }
+			if(m_jobDequeList[victim]->TrySteal(pJob)) { return true; }
+		}
+
+		return false;
+	}
+
+	// Method for waking a parked job thread after new work was queued.
+	void CJobSystem::Wake()
+	{
+		m_signal.fetch_add(1);
+		if(m_parkedCount.load() > 0)
+		{
+			std::lock_guard<std::mutex> lk(m_parkMutex);
+			m_parkCondition.notify_one();
+		}
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// Job pool methods.
+	//-----------------------------------------------------------------------------------------------
+
+	CJob* CJobSystem::AllocateJob()
+	{
+		JobFreeList& freeList = m_jobFreeList;
+
+		if(freeList.pHead == nullptr)
+		{
+			std::lock_guard<std::mutex> lk(m_jobPoolMutex);
+			if(!m_jobBatchList.empty())
+			{
+				freeList.pHead = m_jobBatchList.back();
+				freeList.count = JOB_BATCH_SIZE;
+				m_jobBatchList.pop_back();
+			}
+			else
+			{ // Link a new block into the free list.
+				CJob* pBlock = new CJob[JOB_BATCH_SIZE];
+				m_jobBlockList.push_back(pBlock);
+
+				for(u32 i = 0; i < JOB_BATCH_SIZE - 1; ++i)
+				{
+					pBlock[i].SetNext(&pBlock[i + 1]);
+				}
+
+				pBlock[JOB_BATCH_SIZE - 1].SetNext(nullptr);
+				freeList.pHead = pBlock;
+				freeList.count = JOB_BATCH_SIZE;
+			}
+		}
+
+		CJob* pJob = freeList.pHead;
+		freeList.pHead = pJob->GetNext();
+		--freeList.count;
+
+		return pJob;
+	}
+
+	// Method for returning a job to this thread's free list. Threads that only run jobs would otherwise collect
+	//  every job the submitting threads allocate, so past two batches one batch goes back to the shared list.
+	void CJobSystem::FreeJob(CJob* pJob)
+	{
+		JobFreeList& freeList = m_jobFreeList;
+
+		pJob->SetNext(freeList.pHead);
+		freeList.pHead = pJob;
+		++freeList.count;
+
+		if(freeList.count >= JOB_BATCH_SIZE * 2)
+		{
+			CJob* pBatch = freeList.pHead;
+			CJob* pTail = pBatch;
+			for(u32 i = 1; i < JOB_BATCH_SIZE; ++i)
+			{
+				pTail = pTail->GetNext();
+			}
+
+			freeList.pHead = pTail->GetNext();
+			freeList.count -= JOB_BATCH_SIZE;
+			pTail->SetNext(nullptr);
+
+			std::lock_guard<std::mutex> lk(m_jobPoolMutex);
+			m_jobBatchList.push_back(pBatch);
+		}
+	}
+
+	// Method for freeing every job block. Only once the job threads have closed.
+	void CJobSystem::ReleaseJobs()
+	{
+		std::lock_guard<std::mutex> lk(m_jobPoolMutex);
+		for(CJob* pBlock : m_jobBlockList)
+		{
+			delete[] pBlock;
+		}
+
+		m_jobBlockList.clear();
+		m_jobBatchList.clear();
+		m_jobFreeList = { };
+	}
+
 	//-----------------------------------------------------------------------------------------------
 	// Jobs thread, each with a separate worker.
 	//-----------------------------------------------------------------------------------------------
 
-	void CJobSystem::JobThread(std::promise<void> p)
+	void CJobSystem::JobThread(u32 index, std::promise<void> p)
 	{
+		m_threadIndex = static_cast<s32>(index);
+
+		if(m_data.bPinThreads)
+		{ // Core zero is left to the main thread.
+			const u32 coreCount = max(std::thread::hardware_concurrency(), 1U);
+			SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << ((index + 1) % coreCount));
+		}
+
 		// Initialize per thread worker.
 		m_worker.Initialize(false);
-		std::packaged_task<void()> task;
+		CJob* pJob = nullptr;
 
 		while(!m_exitFlag)
 		{
-			if(m_asyncDeque.TryPopFront(task))
+			bool bFound = FindJob(pJob);
+			for(u32 spin = 0; !bFound && spin < SPIN_COUNT; ++spin)
 			{
-				task();
 				std::this_thread::yield();
+				bFound = FindJob(pJob);
 			}
-			else
-			{
-				std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+			if(!bFound)
+			{ // Park. The signal is read before the last look for work, so a job queued after it always wakes this thread.
+				std::unique_lock<std::mutex> lk(m_parkMutex);
+				const u64 signal = m_signal.load();
+				if(m_exitFlag) { break; }
+
+				bFound = FindJob(pJob);
+				if(!bFound)
+				{
+					++m_parkedCount;
+					m_parkCondition.wait(lk, [&](){ return m_signal.load() != signal || m_exitFlag; });
+					--m_parkedCount;
+					continue;
+				}
 			}
+
+			pJob->Run();
+			FreeJob(pJob);
 		}
 
 		m_worker.Release();
@@ -11,12 +11,18 @@
 #ifndef CJOBSYSTEM_H
 #define CJOBSYSTEM_H
 
+#include "CJob.h"
 #include "CWorker.h"
 #include <Globals/CGlobals.h>
 #include <Utilities/CTSDeque.h>
 #include <Utilities/CDeque.h>
+#include <Utilities/CWSDeque.h>
+#include <condition_variable>
 #include <functional>
 #include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace Util
 {
@@ -30,6 +36,38 @@ namespace Util
 			Compute,
 		};
 
+	public:
+		struct Data
+		{
+			// Number of job threads. Zero uses every hardware thread but the one left for the main thread.
+			u32 threadCount = 0;
+
+			// Pins each job thread to its own core, skipping the first.
+			bool bPinThreads = false;
+		};
+
+	private:
+		// Free jobs are kept per thread and traded through the shared pool in batches of this size.
+		static const u32 JOB_BATCH_SIZE = 64;
+
+		struct JobFreeList
+		{
+			CJob* pHead = nullptr;
+			u32 count = 0;
+		};
+
+		// Range split into equal chunks that the caller and helper jobs claim one at a time until none are left.
+		struct ParallelRange
+		{
+			u32 begin;
+			u32 end;
+			u32 chunkSize;
+			u32 chunkCount;
+			Au32 next;
+			CJobCounter counter;
+			const std::function<void(u32, u32, u32)>* pFunc;
+		};
+
 	public:
 		static CJobSystem& Instance()
 		{
@@ -60,21 +98,105 @@ namespace Util
 		std::future<void> JobGraphics(std::function<void()> func, bool bAsync);
 		std::future<void> JobCompute(std::function<void()> func, bool bAsync);
 
+		// Method for queuing a CPU job without a future. Closures small enough to fit in a job need no allocations.
+		template<typename F>
+		void JobCPU(F&& func)
+		{
+			CJob* pJob = AllocateJob();
+			pJob->Set(std::forward<F>(func), nullptr);
+			Submit(pJob);
+		}
+
+		// Method for queuing a CPU job that is added to the counter until it has run.
+		template<typename F>
+		void JobCPU(F&& func, CJobCounter& counter)
+		{
+			counter.Add(1);
+
+			CJob* pJob = AllocateJob();
+			pJob->Set(std::forward<F>(func), &counter);
+			Submit(pJob);
+		}
+
+		void Wait(const CJobCounter& counter);
+
+		void ParallelFor(u32 begin, u32 end, u32 grain, const std::function<void(u32, u32)>& func);
+
+		// Method for reducing [begin, end) in parallel. Func maps a sub-range to a partial result and join combines two of them.
+		//  Partials are joined in range order, so the result doesn't depend on how the work was scheduled.
+		template<typename T, typename Func, typename Join>
+		T ParallelReduce(u32 begin, u32 end, u32 grain, const T& identity, Func func, Join join)
+		{
+			if(end <= begin) { return identity; }
+
+			const u32 chunkSize = GetChunkSize(end - begin, grain);
+			std::vector<T> partialList((end - begin + chunkSize - 1) / chunkSize, identity);
+
+			ParallelChunks(begin, end, chunkSize, [&](u32 chunk, u32 first, u32 last){
+				partialList[chunk] = func(first, last);
+			});
+
+			T result = identity;
+			for(const T& partial : partialList)
+			{
+				result = join(result, partial);
+			}
+
+			return result;
+		}
+
 		// Accessors.
 		static CWorker& GetWorker() { return m_worker; }
+		inline u32 GetThreadCount() const { return m_threadCount; }
+
+		// Modifiers. Only takes effect when set before the job threads are opened.
+		inline void SetData(const Data& data) { m_data = data; }
 
 	private:
-		void JobThread(std::promise<void> p);
+		void JobThread(u32 index, std::promise<void> p);
+
+		u32 GetChunkSize(u32 count, u32 grain) const;
+		void ParallelChunks(u32 begin, u32 end, u32 chunkSize, const std::function<void(u32, u32, u32)>& func);
+		static void RunChunks(ParallelRange& range);
+
+		CJob* AllocateJob();
+		void FreeJob(CJob* pJob);
+		void ReleaseJobs();
+
+		void Submit(CJob* pJob);
+		void Submit(std::packaged_task<void()>& task);
+		bool FindJob(CJob*& pJob);
+		void Wake();
 
 	private:
+		Data m_data;
+
 		Abool m_exitFlag;
 		u32 m_threadCount;
 
 		Util::CDeque<std::packaged_task<void()>> m_syncDeque;
-		Util::CTSDeque<std::packaged_task<void()>> m_asyncDeque;
 		Util::CDeque<std::future<void>> m_threadDeque;
 
+		// Each job thread pushes and pops its own deque, and steals from the others when it runs dry.
+		//  Threads outside the pool hand their jobs in through the injection deque.
+		std::vector<std::unique_ptr<Util::CWSDeque<CJob*>>> m_jobDequeList;
+		Util::CTSDeque<CJob*> m_injectDeque;
+
+		// Job pool. Jobs are allocated in blocks that live until release, and free jobs go back to whichever thread
+		//  ran them. Threads with too many hand a batch to the shared list, and threads that run out take one back.
+		std::mutex m_jobPoolMutex;
+		std::vector<CJob*> m_jobBlockList;
+		std::vector<CJob*> m_jobBatchList;
+
+		// Idle job threads park on the condition until the signal changes.
+		std::mutex m_parkMutex;
+		std::condition_variable m_parkCondition;
+		Au32 m_parkedCount;
+		Au64 m_signal;
+
 		static thread_local CWorker m_worker;
+		static thread_local s32 m_threadIndex;
+		static thread_local JobFreeList m_jobFreeList;
 	};
 };
 
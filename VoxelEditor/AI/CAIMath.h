@@ -11,6 +11,7 @@
 #ifndef CAIMATH_H
 #define CAIMATH_H
 
+#include <Globals/CGlobals.h>
 #include <cmath>
 #include <cfloat>
 #include <minmax.h>
@@ -58,6 +59,88 @@ namespace Math
 
 		return (x - mx) - log(sum);
 	}
+
+	//-----------------------------------------------------------------------------------------------
+	// SIMD approximations, four lanes at a time.
+	//-----------------------------------------------------------------------------------------------
+
+	// Exponential with a degree 5 polynomial over a Cody-Waite reduced range. Relative error is around 2e-7.
+	inline vf32 ExpSIMD(vf32 x)
+	{
+		x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-87.3f)), _mm_set1_ps(88.3f));
+
+		// Split x into n * ln2 + r with |r| <= ln2 / 2.
+		const vf32 n = _mm_round_ps(_mm_mul_ps(x, _mm_set1_ps(1.44269504f)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+		vf32 r = _mm_sub_ps(x, _mm_mul_ps(n, _mm_set1_ps(0.693359375f)));
+		r = _mm_sub_ps(r, _mm_mul_ps(n, _mm_set1_ps(-2.12194440e-4f)));
+
+		vf32 p = _mm_set1_ps(1.9875691500e-4f);
+		p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(1.3981999507e-3f));
+		p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(8.3334519073e-3f));
+		p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(4.1665795894e-2f));
+		p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(1.6666665459e-1f));
+		p = _mm_add_ps(_mm_mul_ps(p, r), _mm_set1_ps(5.0000001201e-1f));
+		p = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(p, r), r), _mm_add_ps(r, _mm_set1_ps(1.0f)));
+
+		// Scale by 2^n by building the exponent bits directly.
+		const __m128i e = _mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(n), _mm_set1_epi32(127)), 23);
+		return _mm_mul_ps(p, _mm_castsi128_ps(e));
+	}
+
+	// Natural log for positive inputs with a degree 8 polynomial over the mantissa. Non-positive inputs return a large negative value.
+	inline vf32 LogSIMD(vf32 x)
+	{
+		x = _mm_max_ps(x, _mm_castsi128_ps(_mm_set1_epi32(0x00800000)));
+
+		// Split x into m * 2^e with m in [0.5, 1).
+		const __m128i bits = _mm_castps_si128(x);
+		vf32 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(126)));
+		vf32 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F000000)));
+
+		// Shift m into [sqrt(0.5), sqrt(2)) to keep the polynomial centered on 1.
+		const vf32 mask = _mm_cmplt_ps(m, _mm_set1_ps(0.707106781f));
+		e = _mm_sub_ps(e, _mm_and_ps(mask, _mm_set1_ps(1.0f)));
+		m = _mm_sub_ps(_mm_add_ps(m, _mm_and_ps(mask, m)), _mm_set1_ps(1.0f));
+
+		const vf32 z = _mm_mul_ps(m, m);
+		vf32 p = _mm_set1_ps(7.0376836292e-2f);
+		p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(-1.1514610310e-1f));
+		p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(1.1676998740e-1f));
+		p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(-1.2420140846e-1f));
+		p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(1.4249322787e-1f));
+		p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(-1.6668057665e-1f));
+		p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(2.0000714765e-1f));
+		p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(-2.4999993993e-1f));
+		p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(3.3333331174e-1f));
+		p = _mm_mul_ps(_mm_mul_ps(p, m), z);
+
+		p = _mm_add_ps(p, _mm_mul_ps(e, _mm_set1_ps(-2.12194440e-4f)));
+		p = _mm_sub_ps(p, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+		return _mm_add_ps(_mm_add_ps(m, p), _mm_mul_ps(e, _mm_set1_ps(0.693359375f)));
+	}
+
+	inline vf32 SigmoidSIMD(vf32 x)
+	{
+		const vf32 one = _mm_set1_ps(1.0f);
+		return _mm_div_ps(one, _mm_add_ps(one, ExpSIMD(_mm_sub_ps(_mm_setzero_ps(), x))));
+	}
+
+	inline vf32 TanhSIMD(vf32 x)
+	{
+		const vf32 two = _mm_set1_ps(2.0f);
+		return _mm_sub_ps(_mm_mul_ps(two, SigmoidSIMD(_mm_mul_ps(two, x))), _mm_set1_ps(1.0f));
+	}
+
+	// Softplus written as max(x, 0) + log(1 + exp(-|x|)) so large inputs don't overflow. Small tails use a series instead of the log, where 1 + e loses precision.
+	inline vf32 SoftplusSIMD(vf32 x)
+	{
+		const vf32 absX = _mm_and_ps(x, _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF)));
+		const vf32 e = ExpSIMD(_mm_sub_ps(_mm_setzero_ps(), absX));
+		const vf32 series = _mm_mul_ps(e, _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(e, _mm_add_ps(_mm_set1_ps(-0.5f), _mm_mul_ps(e, _mm_set1_ps(1.0f / 3.0f))))));
+		const vf32 mask = _mm_cmplt_ps(e, _mm_set1_ps(1e-2f));
+		const vf32 tail = _mm_blendv_ps(LogSIMD(_mm_add_ps(_mm_set1_ps(1.0f), e)), series, mask);
+		return _mm_add_ps(_mm_max_ps(x, _mm_setzero_ps()), tail);
+	}
 };
 
 #endif
@@ -0,0 +1,182 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Copyright (c) Ryan Alasandro
+//
+// Application: Voxel Editor
+//
+// File: AI/CNeuralNet.cpp
+//
+//-------------------------------------------------------------------------------------------------
+
+#include "CNeuralNet.h"
+#include "CAIMath.h"
+#include <Utilities/CJobSystem.h>
+#include <cstring>
+#include <minmax.h>
+
+namespace AI
+{
+	static const u32 ROW_BLOCK = 4;
+	static const u32 OUTPUT_BLOCK = 4;
+
+	// Per thread ping-pong buffers for the layer outputs.
+	static thread_local std::vector<float> g_scratchList[2];
+
+	static inline vf32 Activate(vf32 x, CNeuralNet::Activation activation)
+	{
+		switch(activation)
+		{
+			case CNeuralNet::Activation::ReLU: return _mm_max_ps(x, _mm_setzero_ps());
+			case CNeuralNet::Activation::Sigmoid: return Math::SigmoidSIMD(x);
+			case CNeuralNet::Activation::Tanh: return Math::TanhSIMD(x);
+			case CNeuralNet::Activation::Softplus: return Math::SoftplusSIMD(x);
+			default: return x;
+		}
+	}
+
+	CNeuralNet::CNeuralNet() :
+		m_maxPaddedCount(0) {
+	}
+
+	CNeuralNet::~CNeuralNet() { }
+
+	// Method for appending a dense layer. Weights are row major with one row of inputs per output.
+	void CNeuralNet::AddLayer(u32 outputCount, Activation activation, const float* pWeightList, const float* pBiasList)
+	{
+		Layer layer;
+		layer.inputCount = GetOutputCount();
+		layer.outputCount = outputCount;
+		layer.paddedCount = (outputCount + OUTPUT_BLOCK - 1) & ~(OUTPUT_BLOCK - 1);
+		layer.activation = activation;
+
+		// Padding outputs get zero weights, and the next layer ignores them since its inputs only cover the real outputs.
+		layer.weightList.assign(layer.paddedCount * layer.inputCount, 0.0f);
+		layer.biasList.assign(layer.paddedCount, 0.0f);
+
+		for(u32 o = 0; o < outputCount; ++o)
+		{
+			const u32 block = o / OUTPUT_BLOCK;
+			const u32 lane = o % OUTPUT_BLOCK;
+			for(u32 i = 0; i < layer.inputCount; ++i)
+			{
+				layer.weightList[(block * layer.inputCount + i) * OUTPUT_BLOCK + lane] = pWeightList[o * layer.inputCount + i];
+			}
+
+			layer.biasList[o] = pBiasList ? pBiasList[o] : 0.0f;
+		}
+
+		m_maxPaddedCount = max(m_maxPaddedCount, layer.paddedCount);
+		m_layerList.push_back(std::move(layer));
+	}
+
+	void CNeuralNet::Release()
+	{
+		m_layerList.clear();
+		m_maxPaddedCount = 0;
+	}
+
+	// Method for evaluating many rows at once, one row per agent. Rows are split across the job system.
+	void CNeuralNet::Evaluate(const float* pInputList, u32 rowCount, float* pOutputList) const
+	{
+		if(rowCount == 0) { return; }
+
+		const u32 rowsPerJob = max(m_data.rowsPerJob, ROW_BLOCK);
+		const u32 inputCount = GetInputCount();
+		const u32 outputCount = GetOutputCount();
+
+		Util::CJobSystem::Instance().ParallelFor(0, rowCount, rowsPerJob, [=](u32 begin, u32 end){
+			EvaluateRows(pInputList + begin * inputCount, end - begin, pOutputList + begin * outputCount);
+		});
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// Kernel methods.
+	//-----------------------------------------------------------------------------------------------
+
+	void CNeuralNet::EvaluateRows(const float* pInputList, u32 rowCount, float* pOutputList) const
+	{
+		const float* pSrc = pInputList;
+		u32 stride = m_data.inputCount;
+
+		for(size_t l = 0; l < m_layerList.size(); ++l)
+		{
+			std::vector<float>& scratch = g_scratchList[l & 0x1];
+			if(scratch.size() < static_cast<size_t>(rowCount) * m_maxPaddedCount)
+			{
+				scratch.resize(static_cast<size_t>(rowCount) * m_maxPaddedCount);
+			}
+
+			EvaluateLayer(m_layerList[l], pSrc, stride, rowCount, scratch.data());
+			pSrc = scratch.data();
+			stride = m_layerList[l].paddedCount;
+		}
+
+		// Strip the padding.
+		const u32 outputCount = GetOutputCount();
+		for(u32 r = 0; r < rowCount; ++r)
+		{
+			memcpy(pOutputList + r * outputCount, pSrc + r * stride, sizeof(float) * outputCount);
+		}
+	}
+
+	// Method for computing activation(input * weights + bias) for a block of rows.
+	// Four rows share every weight vector load, and each accumulator holds four outputs of one row.
+	void CNeuralNet::EvaluateLayer(const Layer& layer, const float* pInputList, u32 inputStride, u32 rowCount, float* pOutputList)
+	{
+		const u32 blockCount = layer.paddedCount / OUTPUT_BLOCK;
+		const u32 inputCount = layer.inputCount;
+		const u32 outputStride = layer.paddedCount;
+
+		u32 r = 0;
+		for(; r + ROW_BLOCK <= rowCount; r += ROW_BLOCK)
+		{
+			const float* pRow0 = pInputList + (r + 0) * inputStride;
+			const float* pRow1 = pInputList + (r + 1) * inputStride;
+			const float* pRow2 = pInputList + (r + 2) * inputStride;
+			const float* pRow3 = pInputList + (r + 3) * inputStride;
+
+			for(u32 b = 0; b < blockCount; ++b)
+			{
+				const vf32 bias = _mm_loadu_ps(&layer.biasList[b * OUTPUT_BLOCK]);
+				vf32 acc0 = bias;
+				vf32 acc1 = bias;
+				vf32 acc2 = bias;
+				vf32 acc3 = bias;
+
+				const float* pWeight = layer.weightList.data() + b * inputCount * OUTPUT_BLOCK;
+				for(u32 i = 0; i < inputCount; ++i, pWeight += OUTPUT_BLOCK)
+				{
+					const vf32 w = _mm_loadu_ps(pWeight);
+					acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_set1_ps(pRow0[i]), w));
+					acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_set1_ps(pRow1[i]), w));
+					acc2 = _mm_add_ps(acc2, _mm_mul_ps(_mm_set1_ps(pRow2[i]), w));
+					acc3 = _mm_add_ps(acc3, _mm_mul_ps(_mm_set1_ps(pRow3[i]), w));
+				}
+
+				float* pOut = pOutputList + r * outputStride + b * OUTPUT_BLOCK;
+				_mm_storeu_ps(pOut, Activate(acc0, layer.activation));
+				_mm_storeu_ps(pOut + outputStride, Activate(acc1, layer.activation));
+				_mm_storeu_ps(pOut + outputStride * 2, Activate(acc2, layer.activation));
+				_mm_storeu_ps(pOut + outputStride * 3, Activate(acc3, layer.activation));
+			}
+		}
+
+		// Leftover rows.
+		for(; r < rowCount; ++r)
+		{
+			const float* pRow = pInputList + r * inputStride;
+			for(u32 b = 0; b < blockCount; ++b)
+			{
+				vf32 acc = _mm_loadu_ps(&layer.biasList[b * OUTPUT_BLOCK]);
+
+				const float* pWeight = layer.weightList.data() + b * inputCount * OUTPUT_BLOCK;
+				for(u32 i = 0; i < inputCount; ++i, pWeight += OUTPUT_BLOCK)
+				{
+					acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(pRow[i]), _mm_loadu_ps(pWeight)));
+				}
+
+				_mm_storeu_ps(pOutputList + r * outputStride + b * OUTPUT_BLOCK, Activate(acc, layer.activation));
+			}
+		}
+	}
+};
@@ -0,0 +1,84 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Copyright (c) Ryan Alasandro
+//
+// Application: Voxel Editor
+//
+// File: AI/CNeuralNet.h
+//
+//-------------------------------------------------------------------------------------------------
+
+#ifndef CNEURALNET_H
+#define CNEURALNET_H
+
+#include <Globals/CGlobals.h>
+#include <vector>
+
+namespace AI
+{
+	class CNeuralNet
+	{
+	public:
+		enum class Activation : u8
+		{
+			Linear,
+			ReLU,
+			Sigmoid,
+			Tanh,
+			Softplus,
+		};
+
+		struct Data
+		{
+			u32 inputCount = 0;
+
+			// Number of rows (agents) handed to each job.
+			u32 rowsPerJob = 256;
+		};
+
+	private:
+		// Weights are packed in blocks of four outputs, so the kernel reads one vector per input for each block.
+		struct Layer
+		{
+			u32 inputCount;
+			u32 outputCount;
+			u32 paddedCount;
+			Activation activation;
+
+			std::vector<float> weightList;
+			std::vector<float> biasList;
+		};
+
+	public:
+		CNeuralNet();
+		~CNeuralNet();
+		CNeuralNet(const CNeuralNet&) = delete;
+		CNeuralNet(CNeuralNet&&) = delete;
+		CNeuralNet& operator = (const CNeuralNet&) = delete;
+		CNeuralNet& operator = (CNeuralNet&&) = delete;
+
+		void AddLayer(u32 outputCount, Activation activation, const float* pWeightList, const float* pBiasList);
+		void Release();
+
+		void Evaluate(const float* pInputList, u32 rowCount, float* pOutputList) const;
+
+		// Accessors.
+		inline u32 GetInputCount() const { return m_data.inputCount; }
+		inline u32 GetOutputCount() const { return m_layerList.empty() ? m_data.inputCount : m_layerList.back().outputCount; }
+
+		// Modifiers.
+		inline void SetData(const Data& data) { m_data = data; }
+
+	private:
+		void EvaluateRows(const float* pInputList, u32 rowCount, float* pOutputList) const;
+		static void EvaluateLayer(const Layer& layer, const float* pInputList, u32 inputStride, u32 rowCount, float* pOutputList);
+
+	private:
+		Data m_data;
+		u32 m_maxPaddedCount;
+
+		std::vector<Layer> m_layerList;
+	};
+};
+
+#endif
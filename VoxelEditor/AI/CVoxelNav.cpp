@@ -0,0 +1,811 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Copyright (c) Ryan Alasandro
+//
+// Application: Voxel Editor
+//
+// File: AI/CVoxelNav.cpp
+//
+//-------------------------------------------------------------------------------------------------
+
+#include "CVoxelNav.h"
+#include "../Universe/CNodeChunk.h"
+#include <Utilities/CJobSystem.h>
+#include <algorithm>
+#include <queue>
+#include <minmax.h>
+
+namespace AI
+{
+	static const u32 MAX_STEP = 4;
+	static const u32 MAX_NEIGHBORS = 4 * (1 + 2 * MAX_STEP) + 4;
+	static const float DIAGONAL_COST = 1.41421356f;
+	static const float STEP_COST = 0.5f;
+	static const u32 START_KEY = CVoxelNav::INVALID_CELL - 1;
+	static const u32 GOAL_KEY = CVoxelNav::INVALID_CELL - 2;
+
+	// Per thread scratch for the cell searches. Generation stamps avoid clearing the lists between searches.
+	struct SearchContext
+	{
+		struct Node
+		{
+			float f;
+			u32 cell;
+
+			inline bool operator > (const Node& node) const { return f > node.f; }
+		};
+
+		std::vector<float> gList;
+		std::vector<u32> parentList;
+		std::vector<u32> openList;
+		std::vector<u32> closedList;
+		std::vector<Node> heap;
+		u32 generation = 0;
+
+		u32 Begin(size_t cellCount)
+		{
+			if(gList.size() != cellCount || ++generation == 0)
+			{
+				gList.assign(cellCount, 0.0f);
+				parentList.assign(cellCount, CVoxelNav::INVALID_CELL);
+				openList.assign(cellCount, 0);
+				closedList.assign(cellCount, 0);
+				generation = 1;
+			}
+
+			heap.clear();
+			return generation;
+		}
+
+		inline bool IsClosed(u32 cell) const { return closedList[cell] == generation; }
+	};
+
+	static thread_local SearchContext g_searchContext;
+
+	// Method for running a function over a range split into batches of at least the batch size across the job system.
+	static void RunBatches(size_t count, size_t batchSize, const std::function<void(size_t, size_t)>& func)
+	{
+		Util::CJobSystem::Instance().ParallelFor(0, static_cast<u32>(count), static_cast<u32>(batchSize), [&func](u32 begin, u32 end){
+			func(begin, end);
+		});
+	}
+
+	CVoxelNav::CVoxelNav() :
+		m_width(0),
+		m_height(0),
+		m_length(0),
+		m_clusterWidth(0),
+		m_clusterLength(0),
+		m_origin(0.0f),
+		m_bDirty(false) {
+	}
+
+	CVoxelNav::~CVoxelNav() { }
+
+	void CVoxelNav::Initialize()
+	{
+		m_width = m_data.pChunk->GetWidth();
+		m_height = m_data.pChunk->GetHeight();
+		m_length = m_data.pChunk->GetLength();
+
+		m_data.clusterSize = max(m_data.clusterSize, 1U);
+		m_data.agentHeight = max(m_data.agentHeight, 1U);
+		m_data.maxStep = min(m_data.maxStep, MAX_STEP);
+
+		m_clusterWidth = (m_width + m_data.clusterSize - 1) / m_data.clusterSize;
+		m_clusterLength = (m_length + m_data.clusterSize - 1) / m_data.clusterSize;
+		const u32 clusterCount = m_clusterWidth * m_clusterLength;
+
+		m_walkList.assign(m_width * m_height * m_length, 0);
+		m_borderList.assign(clusterCount * 2, std::vector<Transition>());
+		m_clusterList.clear();
+		m_clusterList.resize(clusterCount);
+
+		InvalidateAll();
+		Rebuild();
+	}
+
+	// Method for rebuilding dirty clusters and answering queued path queries in batches on the job system.
+	void CVoxelNav::Process()
+	{
+		Rebuild();
+
+		std::vector<PathQuery> queryList;
+		PathQuery query;
+		while(m_queryDeque.TryPopFront(query))
+		{
+			queryList.push_back(query);
+		}
+
+		if(queryList.empty()) { return; }
+
+		RunBatches(queryList.size(), max(m_data.batchSize, 1U), [this, &queryList](size_t begin, size_t end){
+			std::vector<Math::Vector3> path;
+			for(size_t i = begin; i < end; ++i)
+			{
+				FindPath(queryList[i].start, queryList[i].goal, path);
+				if(queryList[i].callback)
+				{
+					queryList[i].callback(path);
+				}
+			}
+		});
+	}
+
+	void CVoxelNav::Release()
+	{
+		m_idList.clear();
+		m_walkList.clear();
+		m_borderList.clear();
+		m_clusterList.clear();
+		m_portalMap.clear();
+		m_dirtyList.clear();
+
+		PathQuery query;
+		while(m_queryDeque.TryPopFront(query)) { }
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// Query methods.
+	//-----------------------------------------------------------------------------------------------
+
+	// Method for queuing a path query. The callback is called from a job thread during the next Process.
+	void CVoxelNav::RequestPath(PathQuery& query)
+	{
+		m_queryDeque.PushBack(query);
+	}
+
+	// Method for finding a path over the cluster graph. Safe to call from several threads as long as no rebuild is running.
+	bool CVoxelNav::FindPath(const Math::Vector3& start, const Math::Vector3& goal, std::vector<Math::Vector3>& path) const
+	{
+		path.clear();
+
+		const u32 startCell = Locate(start);
+		const u32 goalCell = Locate(goal);
+		if(startCell == INVALID_CELL || goalCell == INVALID_CELL) { return false; }
+
+		int si, sj, sk, gi, gj, gk;
+		GetCoords(startCell, si, sj, sk);
+		GetCoords(goalCell, gi, gj, gk);
+		const u32 startCluster = GetCluster(si, sk);
+		const u32 goalCluster = GetCluster(gi, gk);
+
+		std::vector<u32> cellPath;
+		auto Emit = [&](){
+			path.reserve(cellPath.size() + 1);
+			path.push_back(m_origin + Math::Vector3(static_cast<float>(si), static_cast<float>(sj), static_cast<float>(sk)));
+			for(u32 cell : cellPath)
+			{
+				int i, j, k;
+				GetCoords(cell, i, j, k);
+				path.push_back(m_origin + Math::Vector3(static_cast<float>(i), static_cast<float>(j), static_cast<float>(k)));
+			}
+		};
+
+		float cost;
+		if(startCluster == goalCluster && Search(startCell, goalCell, startCluster, cost))
+		{ // Both ends share a cluster and are connected inside it.
+			Trace(goalCell, cellPath);
+			Emit();
+			return true;
+		}
+
+		{ // Connect the start and goal to the portals of their clusters.
+			struct Link
+			{
+				u32 portal;
+				float cost;
+				std::vector<u32> path;
+			};
+
+			std::vector<Link> startLinkList;
+			std::vector<Link> goalLinkList;
+			const SearchContext& ctx = g_searchContext;
+
+			Search(startCell, INVALID_CELL, startCluster, cost);
+			for(u32 portal : m_clusterList[startCluster].portalList)
+			{
+				if(ctx.IsClosed(portal))
+				{
+					startLinkList.push_back({ portal, ctx.gList[portal], std::vector<u32>() });
+					Trace(portal, startLinkList.back().path);
+				}
+			}
+
+			Search(goalCell, INVALID_CELL, goalCluster, cost);
+			for(u32 portal : m_clusterList[goalCluster].portalList)
+			{
+				if(ctx.IsClosed(portal))
+				{ // Moves are symmetric, so the flood from the goal is walked backwards.
+					goalLinkList.push_back({ portal, ctx.gList[portal], std::vector<u32>() });
+					std::vector<u32>& linkPath = goalLinkList.back().path;
+					Trace(portal, linkPath);
+					std::reverse(linkPath.begin(), linkPath.end());
+					if(!linkPath.empty()) { linkPath.erase(linkPath.begin()); }
+					if(portal != goalCell) { linkPath.push_back(goalCell); }
+				}
+			}
+
+			if(startLinkList.empty() || goalLinkList.empty()) { return false; }
+
+			// Search the abstract graph.
+			struct AbstractNode
+			{
+				float g;
+				u32 parent;
+				bool bClosed;
+			};
+
+			auto Heuristic = [&](u32 key) {
+				if(key == START_KEY || key == GOAL_KEY) { return 0.0f; }
+				int i, j, k;
+				GetCoords(key, i, j, k);
+				return Math::Vector3(static_cast<float>(i - gi), static_cast<float>(j - gj), static_cast<float>(k - gk)).Length();
+			};
+
+			std::unordered_map<u32, AbstractNode> nodeMap;
+			std::priority_queue<SearchContext::Node, std::vector<SearchContext::Node>, std::greater<SearchContext::Node>> openQueue;
+
+			auto Relax = [&](u32 from, u32 to, float edgeCost) {
+				const float g = nodeMap[from].g + edgeCost;
+				auto it = nodeMap.find(to);
+				if(it == nodeMap.end())
+				{
+					nodeMap.insert({ to, { g, from, false } });
+				}
+				else if(it->second.bClosed || g >= it->second.g)
+				{
+					return;
+				}
+				else
+				{
+					it->second = { g, from, false };
+				}
+
+				openQueue.push({ g + Heuristic(to), to });
+			};
+
+			nodeMap.insert({ START_KEY, { 0.0f, INVALID_CELL, false } });
+			openQueue.push({ 0.0f, START_KEY });
+
+			bool bFound = false;
+			while(!openQueue.empty())
+			{
+				const u32 key = openQueue.top().cell;
+				openQueue.pop();
+
+				AbstractNode& node = nodeMap[key];
+				if(node.bClosed) { continue; }
+				node.bClosed = true;
+
+				if(key == GOAL_KEY)
+				{
+					bFound = true;
+					break;
+				}
+
+				if(key == START_KEY)
+				{
+					for(const Link& link : startLinkList)
+					{
+						Relax(key, link.portal, link.cost);
+					}
+
+					continue;
+				}
+
+				auto portalIt = m_portalMap.find(key);
+				if(portalIt == m_portalMap.end()) { continue; }
+				const Portal& portal = portalIt->second;
+
+				auto edgeIt = m_clusterList[portal.cluster].edgeMap.find(key);
+				if(edgeIt != m_clusterList[portal.cluster].edgeMap.end())
+				{
+					for(const Edge& edge : edgeIt->second)
+					{
+						Relax(key, edge.to, edge.cost);
+					}
+				}
+
+				int pi, pj, pk;
+				GetCoords(key, pi, pj, pk);
+				for(u32 partner : portal.partnerList)
+				{
+					int i, j, k;
+					GetCoords(partner, i, j, k);
+					Relax(key, partner, 1.0f + STEP_COST * abs(j - pj));
+				}
+
+				if(portal.cluster == goalCluster)
+				{
+					for(const Link& link : goalLinkList)
+					{
+						if(link.portal == key)
+						{
+							Relax(key, GOAL_KEY, link.cost);
+						}
+					}
+				}
+			}
+
+			if(!bFound) { return false; }
+
+			// Walk the abstract path back and stitch together the cached cell paths.
+			std::vector<u32> keyList;
+			for(u32 key = GOAL_KEY; key != INVALID_CELL; key = nodeMap[key].parent)
+			{
+				keyList.push_back(key);
+			}
+
+			std::reverse(keyList.begin(), keyList.end());
+
+			for(size_t n = 1; n < keyList.size(); ++n)
+			{
+				const u32 from = keyList[n - 1];
+				const u32 to = keyList[n];
+
+				if(from == START_KEY)
+				{
+					for(const Link& link : startLinkList)
+					{
+						if(link.portal == to) { cellPath.insert(cellPath.end(), link.path.begin(), link.path.end()); break; }
+					}
+				}
+				else if(to == GOAL_KEY)
+				{
+					for(const Link& link : goalLinkList)
+					{
+						if(link.portal == from) { cellPath.insert(cellPath.end(), link.path.begin(), link.path.end()); break; }
+					}
+				}
+				else
+				{
+					const Portal& portal = m_portalMap.at(from);
+					int i, j, k;
+					GetCoords(to, i, j, k);
+
+					if(GetCluster(i, k) != portal.cluster)
+					{ // Border crossing.
+						cellPath.push_back(to);
+					}
+					else
+					{
+						for(const Edge& edge : m_clusterList[portal.cluster].edgeMap.at(from))
+						{
+							if(edge.to == to) { cellPath.insert(cellPath.end(), edge.path.begin(), edge.path.end()); break; }
+						}
+					}
+				}
+			}
+		}
+
+		Emit();
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// Invalidation methods.
+	//-----------------------------------------------------------------------------------------------
+
+	// Method for marking the cluster holding a block as dirty. It's rebuilt on the next Process.
+	void CVoxelNav::Invalidate(u32 blockIndex)
+	{
+		if(m_dirtyList.empty()) { return; }
+
+		int i, j, k;
+		GetCoords(blockIndex, i, j, k);
+
+		std::lock_guard<std::mutex> lk(m_dirtyMutex);
+		m_dirtyList[GetCluster(i, k)] = 1;
+		m_bDirty = true;
+	}
+
+	void CVoxelNav::InvalidateAll()
+	{
+		std::lock_guard<std::mutex> lk(m_dirtyMutex);
+		m_dirtyList.assign(m_clusterWidth * m_clusterLength, 1);
+		m_bDirty = true;
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// Build methods.
+	//-----------------------------------------------------------------------------------------------
+
+	void CVoxelNav::Rebuild()
+	{
+		const u32 clusterCount = m_clusterWidth * m_clusterLength;
+		std::vector<u8> dirtyList(clusterCount, 0);
+
+		{
+			std::lock_guard<std::mutex> lk(m_dirtyMutex);
+			if(!m_bDirty) { return; }
+
+			dirtyList.swap(m_dirtyList);
+			m_dirtyList.assign(clusterCount, 0);
+			m_bDirty = false;
+		}
+
+		{ // Snapshot the chunk.
+			Universe::CNodeChunk::Data chunkData;
+			m_data.pChunk->CopyBlockIds(m_idList, chunkData);
+
+			const Math::SIMDVector origin = m_data.pChunk->GetPositionFromIndex(0, 0, 0);
+			m_origin = Math::Vector3(origin[0], origin[1], origin[2]);
+		}
+
+		std::vector<u8> borderDirtyList(clusterCount * 2, 0);
+		for(u32 c = 0; c < clusterCount; ++c)
+		{
+			if(!dirtyList[c]) { continue; }
+
+			const int ci = static_cast<int>(c / m_clusterLength);
+			const int ck = static_cast<int>(c % m_clusterLength);
+
+			{ // Update the walkable surface of the cluster's columns.
+				const int i0 = ci * m_data.clusterSize;
+				const int i1 = min(i0 + static_cast<int>(m_data.clusterSize), static_cast<int>(m_width));
+				const int k0 = ck * m_data.clusterSize;
+				const int k1 = min(k0 + static_cast<int>(m_data.clusterSize), static_cast<int>(m_length));
+
+				for(int i = i0; i < i1; ++i)
+				{
+					for(int k = k0; k < k1; ++k)
+					{
+						m_walkList[GetIndex(i, 0, k)] = 0;
+						for(int j = 1; j < static_cast<int>(m_height); ++j)
+						{
+							bool bWalkable = !IsAir(i, j - 1, k);
+							for(u32 h = 0; h < m_data.agentHeight && bWalkable; ++h)
+							{
+								bWalkable = IsAir(i, j + h, k);
+							}
+
+							m_walkList[GetIndex(i, j, k)] = bWalkable;
+						}
+					}
+				}
+			}
+
+			// Every border of a dirty cluster has to be rebuilt, including those owned by the neighbors behind it.
+			borderDirtyList[c * 2] = borderDirtyList[c * 2 + 1] = 1;
+			if(ci > 0) { borderDirtyList[(c - m_clusterLength) * 2] = 1; }
+			if(ck > 0) { borderDirtyList[(c - 1) * 2 + 1] = 1; }
+		}
+
+		for(u32 border = 0; border < clusterCount * 2; ++border)
+		{
+			if(borderDirtyList[border]) { BuildBorder(border); }
+		}
+
+		{ // Gather the portals.
+			m_portalMap.clear();
+
+			auto AddPortal = [this](u32 from, u32 to) {
+				int i, j, k;
+				GetCoords(from, i, j, k);
+				Portal& portal = m_portalMap[from];
+				portal.cluster = GetCluster(i, k);
+				portal.partnerList.push_back(to);
+			};
+
+			for(const std::vector<Transition>& transitionList : m_borderList)
+			{
+				for(const Transition& transition : transitionList)
+				{
+					AddPortal(transition.from, transition.to);
+					AddPortal(transition.to, transition.from);
+				}
+			}
+		}
+
+		// Only clusters that are dirty or whose portals moved need their edges rebuilt.
+		std::vector<std::vector<u32>> portalList(clusterCount);
+		for(const auto& portalPair : m_portalMap)
+		{
+			portalList[portalPair.second.cluster].push_back(portalPair.first);
+		}
+
+		std::vector<u32> rebuildList;
+		for(u32 c = 0; c < clusterCount; ++c)
+		{
+			std::sort(portalList[c].begin(), portalList[c].end());
+			if(dirtyList[c] || portalList[c] != m_clusterList[c].portalList)
+			{
+				m_clusterList[c].portalList.swap(portalList[c]);
+				rebuildList.push_back(c);
+			}
+		}
+
+		if(!rebuildList.empty())
+		{
+			RunBatches(rebuildList.size(), 1, [this, &rebuildList](size_t begin, size_t end){
+				for(size_t i = begin; i < end; ++i)
+				{
+					BuildCluster(rebuildList[i]);
+				}
+			});
+		}
+	}
+
+	// Method for finding the entrances along a border. Each run of adjacent transitions at the same height becomes one entrance at its middle.
+	void CVoxelNav::BuildBorder(u32 border)
+	{
+		std::vector<Transition>& transitionList = m_borderList[border];
+		transitionList.clear();
+
+		const u32 c = border >> 1;
+		const u32 axis = border & 0x1;
+		const int ci = static_cast<int>(c / m_clusterLength);
+		const int ck = static_cast<int>(c % m_clusterLength);
+		const int size = static_cast<int>(m_data.clusterSize);
+
+		int i0, k0, runLength;
+		if(axis == 0)
+		{
+			if((ci + 1) * size >= static_cast<int>(m_width)) { return; }
+			i0 = (ci + 1) * size - 1;
+			k0 = ck * size;
+			runLength = min(size, static_cast<int>(m_length) - k0);
+		}
+		else
+		{
+			if((ck + 1) * size >= static_cast<int>(m_length)) { return; }
+			i0 = ci * size;
+			k0 = (ck + 1) * size - 1;
+			runLength = min(size, static_cast<int>(m_width) - i0);
+		}
+
+		struct Candidate
+		{
+			int j;
+			int dy;
+			int t;
+			Transition transition;
+
+			inline bool operator < (const Candidate& other) const
+			{
+				if(j != other.j) return j < other.j;
+				if(dy != other.dy) return dy < other.dy;
+				return t < other.t;
+			}
+		};
+
+		std::vector<Candidate> candidateList;
+		u32 cellList[MAX_NEIGHBORS];
+		float costList[MAX_NEIGHBORS];
+
+		for(int t = 0; t < runLength; ++t)
+		{
+			const int i = axis == 0 ? i0 : i0 + t;
+			const int k = axis == 0 ? k0 + t : k0;
+			const int ni = axis == 0 ? i + 1 : i;
+			const int nk = axis == 0 ? k : k + 1;
+
+			for(int j = 1; j < static_cast<int>(m_height); ++j)
+			{
+				if(!IsWalkable(i, j, k)) { continue; }
+
+				const u32 cell = GetIndex(i, j, k);
+				const u32 count = Neighbors(cell, cellList, costList);
+				for(u32 n = 0; n < count; ++n)
+				{
+					int ti, tj, tk;
+					GetCoords(cellList[n], ti, tj, tk);
+					if(ti == ni && tk == nk)
+					{
+						candidateList.push_back({ j, tj - j, t, { cell, cellList[n] } });
+					}
+				}
+			}
+		}
+
+		std::sort(candidateList.begin(), candidateList.end());
+
+		size_t runStart = 0;
+		for(size_t n = 1; n <= candidateList.size(); ++n)
+		{
+			const bool bRunEnd = n == candidateList.size() ||
+				candidateList[n].j != candidateList[n - 1].j ||
+				candidateList[n].dy != candidateList[n - 1].dy ||
+				candidateList[n].t != candidateList[n - 1].t + 1;
+
+			if(bRunEnd)
+			{
+				transitionList.push_back(candidateList[(runStart + n - 1) >> 1].transition);
+				runStart = n;
+			}
+		}
+	}
+
+	// Method for caching the shortest path between every pair of portals in a cluster.
+	void CVoxelNav::BuildCluster(u32 cluster)
+	{
+		Cluster& c = m_clusterList[cluster];
+		c.edgeMap.clear();
+
+		const SearchContext& ctx = g_searchContext;
+		for(u32 from : c.portalList)
+		{
+			float cost;
+			Search(from, INVALID_CELL, cluster, cost);
+
+			std::vector<Edge>& edgeList = c.edgeMap[from];
+			for(u32 to : c.portalList)
+			{
+				if(to != from && ctx.IsClosed(to))
+				{
+					edgeList.push_back({ to, ctx.gList[to], std::vector<u32>() });
+					Trace(to, edgeList.back().path);
+				}
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// Cell methods.
+	//-----------------------------------------------------------------------------------------------
+
+	// Method for running A* from a cell, limited to a cluster unless the cluster is invalid.
+	// An invalid goal floods the whole cluster, leaving the costs and parents in the thread's search context.
+	bool CVoxelNav::Search(u32 start, u32 goal, u32 cluster, float& cost) const
+	{
+		SearchContext& ctx = g_searchContext;
+		const u32 generation = ctx.Begin(m_walkList.size());
+
+		int gi = 0, gj = 0, gk = 0;
+		if(goal != INVALID_CELL) { GetCoords(goal, gi, gj, gk); }
+
+		auto Heuristic = [&](u32 cell) {
+			if(goal == INVALID_CELL) { return 0.0f; }
+			int i, j, k;
+			GetCoords(cell, i, j, k);
+			return Math::Vector3(static_cast<float>(i - gi), static_cast<float>(j - gj), static_cast<float>(k - gk)).Length();
+		};
+
+		ctx.gList[start] = 0.0f;
+		ctx.parentList[start] = INVALID_CELL;
+		ctx.openList[start] = generation;
+		ctx.heap.push_back({ Heuristic(start), start });
+
+		u32 cellList[MAX_NEIGHBORS];
+		float costList[MAX_NEIGHBORS];
+
+		while(!ctx.heap.empty())
+		{
+			std::pop_heap(ctx.heap.begin(), ctx.heap.end(), std::greater<SearchContext::Node>());
+			const u32 cell = ctx.heap.back().cell;
+			ctx.heap.pop_back();
+
+			if(ctx.closedList[cell] == generation) { continue; }
+			ctx.closedList[cell] = generation;
+
+			if(cell == goal)
+			{
+				cost = ctx.gList[cell];
+				return true;
+			}
+
+			const u32 count = Neighbors(cell, cellList, costList);
+			for(u32 n = 0; n < count; ++n)
+			{
+				const u32 next = cellList[n];
+				if(ctx.closedList[next] == generation) { continue; }
+
+				if(cluster != INVALID_CELL)
+				{
+					int i, j, k;
+					GetCoords(next, i, j, k);
+					if(GetCluster(i, k) != cluster) { continue; }
+				}
+
+				const float g = ctx.gList[cell] + costList[n];
+				if(ctx.openList[next] != generation || g < ctx.gList[next])
+				{
+					ctx.gList[next] = g;
+					ctx.parentList[next] = cell;
+					ctx.openList[next] = generation;
+					ctx.heap.push_back({ g + Heuristic(next), next });
+					std::push_heap(ctx.heap.begin(), ctx.heap.end(), std::greater<SearchContext::Node>());
+				}
+			}
+		}
+
+		cost = 0.0f;
+		return goal == INVALID_CELL;
+	}
+
+	// Method for reading a path out of the last search. The path excludes the start cell.
+	void CVoxelNav::Trace(u32 goal, std::vector<u32>& path) const
+	{
+		const SearchContext& ctx = g_searchContext;
+		const size_t offset = path.size();
+
+		for(u32 cell = goal; ctx.parentList[cell] != INVALID_CELL; cell = ctx.parentList[cell])
+		{
+			path.push_back(cell);
+		}
+
+		std::reverse(path.begin() + offset, path.end());
+	}
+
+	// Method for gathering the cells an agent can move to from a cell. Diagonals are only allowed on flat ground without cutting corners.
+	u32 CVoxelNav::Neighbors(u32 cell, u32* pCellList, float* pCostList) const
+	{
+		static const int dirList[8][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 }, { 1, 1 }, { 1, -1 }, { -1, 1 }, { -1, -1 } };
+
+		int i, j, k;
+		GetCoords(cell, i, j, k);
+
+		const int height = static_cast<int>(m_data.agentHeight);
+		const int maxStep = static_cast<int>(m_data.maxStep);
+
+		u32 count = 0;
+		for(int d = 0; d < 4; ++d)
+		{
+			const int ni = i + dirList[d][0];
+			const int nk = k + dirList[d][1];
+			if(ni < 0 || ni >= static_cast<int>(m_width) || nk < 0 || nk >= static_cast<int>(m_length)) { continue; }
+
+			if(IsWalkable(ni, j, nk))
+			{
+				pCellList[count] = GetIndex(ni, j, nk);
+				pCostList[count++] = 1.0f;
+				continue;
+			}
+
+			for(int s = 1; s <= maxStep; ++s)
+			{ // Stepping up needs headroom above the agent.
+				if(!IsAir(i, j + height + s - 1, k)) { break; }
+				if(IsWalkable(ni, j + s, nk))
+				{
+					pCellList[count] = GetIndex(ni, j + s, nk);
+					pCostList[count++] = 1.0f + STEP_COST * s;
+					break;
+				}
+			}
+
+			for(int s = 1; s <= maxStep && j - s > 0; ++s)
+			{ // Stepping down needs headroom above the target.
+				if(!IsAir(ni, j - s + height, nk)) { break; }
+				if(IsWalkable(ni, j - s, nk))
+				{
+					pCellList[count] = GetIndex(ni, j - s, nk);
+					pCostList[count++] = 1.0f + STEP_COST * s;
+					break;
+				}
+			}
+		}
+
+		for(int d = 4; d < 8; ++d)
+		{
+			const int ni = i + dirList[d][0];
+			const int nk = k + dirList[d][1];
+			if(IsWalkable(ni, j, nk) && IsWalkable(ni, j, k) && IsWalkable(i, j, nk))
+			{
+				pCellList[count] = GetIndex(ni, j, nk);
+				pCostList[count++] = DIAGONAL_COST;
+			}
+		}
+
+		return count;
+	}
+
+	// Method for finding the walkable cell closest to a world position's column. Returns an invalid cell when there is none nearby.
+	u32 CVoxelNav::Locate(const Math::Vector3& position) const
+	{
+		const Math::Vector3 local = position - m_origin;
+		const int i = static_cast<int>(floorf(local.x + 0.5f));
+		const int j = static_cast<int>(floorf(local.y + 0.5f));
+		const int k = static_cast<int>(floorf(local.z + 0.5f));
+		if(i < 0 || i >= static_cast<int>(m_width) || k < 0 || k >= static_cast<int>(m_length)) { return INVALID_CELL; }
+
+		const int range = static_cast<int>(m_data.agentHeight + m_data.maxStep);
+		for(int offset = 0; offset <= range; ++offset)
+		{
+			if(IsWalkable(i, j - offset, k)) { return GetIndex(i, j - offset, k); }
+			if(offset && IsWalkable(i, j + offset, k)) { return GetIndex(i, j + offset, k); }
+		}
+
+		return INVALID_CELL;
+	}
+};
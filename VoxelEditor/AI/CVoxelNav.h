@@ -0,0 +1,172 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Copyright (c) Ryan Alasandro
+//
+// Application: Voxel Editor
+//
+// File: AI/CVoxelNav.h
+//
+//-------------------------------------------------------------------------------------------------
+
+#ifndef CVOXELNAV_H
+#define CVOXELNAV_H
+
+#include <Globals/CGlobals.h>
+#include <Math/CMathVector3.h>
+#include <Utilities/CTSDeque.h>
+#include <unordered_map>
+#include <functional>
+#include <vector>
+#include <mutex>
+
+namespace Universe
+{
+	class CNodeChunk;
+};
+
+namespace AI
+{
+	class CVoxelNav
+	{
+	public:
+		static const u32 INVALID_CELL = ~0U;
+
+		struct Data
+		{
+			const Universe::CNodeChunk* pChunk = nullptr;
+
+			// Width and length of a cluster in blocks. Clusters span the full height of the chunk.
+			u32 clusterSize = 8;
+
+			// Blocks of clearance an agent needs above the surface, and how many blocks it can step up or down.
+			u32 agentHeight = 2;
+			u32 maxStep = 1;
+
+			// Number of path queries handed to each job.
+			u32 batchSize = 16;
+		};
+
+		struct PathQuery
+		{
+			Math::Vector3 start;
+			Math::Vector3 goal;
+			std::function<void(const std::vector<Math::Vector3>&)> callback;
+		};
+
+	private:
+		// Intra-cluster edge between two portals. The cached path excludes the starting cell.
+		struct Edge
+		{
+			u32 to;
+			float cost;
+			std::vector<u32> path;
+		};
+
+		struct Cluster
+		{
+			std::vector<u32> portalList;
+			std::unordered_map<u32, std::vector<Edge>> edgeMap;
+		};
+
+		// A walkable cell on a cluster border, with the cells it steps to across the border.
+		struct Portal
+		{
+			u32 cluster;
+			std::vector<u32> partnerList;
+		};
+
+		// Transition across a cluster border.
+		struct Transition
+		{
+			u32 from;
+			u32 to;
+		};
+
+	public:
+		CVoxelNav();
+		~CVoxelNav();
+		CVoxelNav(const CVoxelNav&) = delete;
+		CVoxelNav(CVoxelNav&&) = delete;
+		CVoxelNav& operator = (const CVoxelNav&) = delete;
+		CVoxelNav& operator = (CVoxelNav&&) = delete;
+
+		void Initialize();
+		void Process();
+		void Release();
+
+		void RequestPath(PathQuery& query);
+		bool FindPath(const Math::Vector3& start, const Math::Vector3& goal, std::vector<Math::Vector3>& path) const;
+
+		void Invalidate(u32 blockIndex);
+		void InvalidateAll();
+
+		// Modifiers.
+		inline void SetData(const Data& data) { m_data = data; }
+
+	private:
+		void Rebuild();
+		void BuildBorder(u32 border);
+		void BuildCluster(u32 cluster);
+
+		bool Search(u32 start, u32 goal, u32 cluster, float& cost) const;
+		void Trace(u32 goal, std::vector<u32>& path) const;
+		u32 Neighbors(u32 cell, u32* pCellList, float* pCostList) const;
+		u32 Locate(const Math::Vector3& position) const;
+
+		// Cell methods.
+		inline u32 GetIndex(int i, int j, int k) const
+		{
+			return static_cast<u32>(i * m_length * m_height + k * m_height + (m_height - 1 - j));
+		}
+
+		inline void GetCoords(u32 cell, int& i, int& j, int& k) const
+		{
+			i = static_cast<int>(cell / (m_length * m_height));
+			const u32 rem = cell % (m_length * m_height);
+			k = static_cast<int>(rem / m_height);
+			j = static_cast<int>(m_height - 1 - rem % m_height);
+		}
+
+		inline bool IsAir(int i, int j, int k) const
+		{
+			return j >= static_cast<int>(m_height) || m_idList[GetIndex(i, j, k)] == 0;
+		}
+
+		inline bool IsWalkable(int i, int j, int k) const
+		{
+			return i >= 0 && i < static_cast<int>(m_width) && k >= 0 && k < static_cast<int>(m_length) &&
+				j > 0 && j < static_cast<int>(m_height) && m_walkList[GetIndex(i, j, k)];
+		}
+
+		inline u32 GetCluster(int i, int k) const
+		{
+			return (i / m_data.clusterSize) * m_clusterLength + (k / m_data.clusterSize);
+		}
+
+	private:
+		Data m_data;
+
+		u32 m_width;
+		u32 m_height;
+		u32 m_length;
+		u32 m_clusterWidth;
+		u32 m_clusterLength;
+		Math::Vector3 m_origin;
+
+		std::vector<u16> m_idList;
+		std::vector<u8> m_walkList;
+
+		// Borders are indexed by cluster * 2 + axis, where axis 0 faces +i and axis 1 faces +k.
+		std::vector<std::vector<Transition>> m_borderList;
+		std::vector<Cluster> m_clusterList;
+		std::unordered_map<u32, Portal> m_portalMap;
+
+		std::mutex m_dirtyMutex;
+		bool m_bDirty;
+		std::vector<u8> m_dirtyList;
+
+		Util::CTSDeque<PathQuery> m_queryDeque;
+	};
+};
+
+#endif
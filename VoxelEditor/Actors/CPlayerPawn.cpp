@@ -34,7 +34,7 @@ namespace Actor
 		m_euler(0.0f),
 		m_panDelta(0.0f),
 		m_zoomDelta(0.0f),
-		m_rigidbody(this),
+		m_controller(this),
 		m_volume(this),
 		m_selector(L"Player Selector", sceneHash),
 		m_transformBody(this),
@@ -118,6 +118,16 @@ namespace Actor
 			App::InputBindingSet(App::INPUT_KEY_MODE, std::bind(&CPlayerPawn::Mode, this, std::placeholders::_1),
 			App::InputBinding(App::INPUT_DEVICE_KEYBOARD, App::VK_KB_R), App::InputBinding(App::INPUT_DEVICE_NONE, 0))
 		);
+
+		App::CInput::Instance().RegisterBinding(&App::INPUT_HASH_LAYOUT_EDITOR, 1,
+			App::InputBindingSet(App::INPUT_KEY_BRUSH, std::bind(&CPlayerPawn::Brush, this, std::placeholders::_1),
+			App::InputBinding(App::INPUT_DEVICE_KEYBOARD, App::VK_KB_B), App::InputBinding(App::INPUT_DEVICE_NONE, 0))
+		);
+
+		App::CInput::Instance().RegisterBinding(&App::INPUT_HASH_LAYOUT_EDITOR, 1,
+			App::InputBindingSet(App::INPUT_KEY_CLEANUP, std::bind(&CPlayerPawn::Cleanup, this, std::placeholders::_1),
+			App::InputBinding(App::INPUT_DEVICE_KEYBOARD, App::VK_KB_F), App::InputBinding(App::INPUT_DEVICE_NONE, 0))
+		);
 		
 		App::CInput::Instance().RegisterBinding(allLayouts, 2,
 			App::InputBindingSet(App::INPUT_KEY_PLAY, std::bind(&CPlayerPawn::Play, this, std::placeholders::_1),
@@ -150,24 +160,25 @@ namespace Actor
 		m_transformBody.SetPosition(Math::SIMDVector(0.0f, 18.0f, -32.0f));
 		m_transformHead.SetLocalEuler(Math::SIMDVector(m_euler.x = Math::g_PiOver180 * 35.0f, 0.0f, m_euler.z));
 
-		{ // Setup play mode rigid body.
-			Physics::CRigidbody::Data data { };
-			data.SetMass(1.0f);
-			data.damping = 0.95f;
-			data.pVolume = &m_volume;
-			m_rigidbody.SetData(data);
-		}
-
 		{ // Setup play mode collider.
 			Physics::CVolumeCapsule::Data data { };
 			data.radius = 0.4f;
 			data.height = max(0.0f, 1.85f - data.radius * 2.0f);
 			data.offset = -0.75f;
 			data.colliderType = Physics::ColliderType::Collider;
-			data.pRigidbody = &m_rigidbody;
 			m_volume.SetData(data);
 		}
 
+		{ // Setup play mode character controller. It sweeps the same capsule as the collider.
+			Physics::CCharacterController::Data data { };
+			data.radius = 0.4f;
+			data.height = max(0.0f, 1.85f - data.radius * 2.0f);
+			data.offset = -0.75f;
+			data.stepHeight = 1.0f;
+			data.pVolume = &m_volume;
+			m_controller.SetData(data);
+		}
+
 		{ // Create a physic updater. This is called from the physics thread.
 			Physics::CPhysics::Instance().CreatePhysicsUpdate(&m_physicsUpdate, this);
 			Physics::CPhysicsUpdate::Data data { };
@@ -195,6 +206,10 @@ namespace Actor
 		{
 			EditUpdate();
 		}
+
+		// Physics regions are throttled around the player.
+		const Math::SIMDVector& position = m_transformBody.GetPosition();
+		Physics::CPhysics::Instance().SetFocus(Math::Vector3(position[0], position[1], position[2]));
 	}
 
 	void CPlayerPawn::LateUpdate()
@@ -253,7 +268,7 @@ namespace Actor
 	// Method for updating the player in play mode.
 	void CPlayerPawn::PlayUpdate()
 	{
-		m_rigidbody.UpdateTransform(m_transformBody);
+		m_controller.UpdateTransform(m_transformBody);
 		
 		m_transformPivot.SetEuler(Math::SIMDVector(0.0f, m_euler.y, 0.0f));
 		m_transformHead.SetLocalEuler(Math::SIMDVector(m_euler.x, 0.0f, m_euler.z));
@@ -288,23 +303,19 @@ namespace Actor
 			Math::Vector3 forward(sinf(eulerY), 0.0f, cosf(eulerY));
 			targetVelocity = (right * targetVelocity.x + forward * targetVelocity.z) * m_data.speed;
 			
-			if(!m_rigidbody.OnGround())
+			if(!m_controller.OnGround())
 			{
-				targetVelocity = Math::Vector3::Lerp(Math::Vector3(m_rigidbody.GetVelocity()[0], 0.0f, m_rigidbody.GetVelocity()[2]), 
+				targetVelocity = Math::Vector3::Lerp(Math::Vector3(m_controller.GetVelocity()[0], 0.0f, m_controller.GetVelocity()[2]), 
 					targetVelocity, min(1.0f, Util::CTimer::Instance().GetDelta() * 2.0f));
 			}
 
-			m_rigidbody.SetVelocity(Math::SIMD_VEC_UP * m_rigidbody.GetVelocity()[1] + targetVelocity);
-
 			if(m_bJump)
 			{
-				if(m_rigidbody.OnGround())
-				{
-					m_rigidbody.AddForce(Math::SIMD_VEC_UP * m_data.jumpPower);
-				}
-
+				m_controller.Jump(m_data.jumpPower);
 				m_bJump = false;
 			}
+
+			m_controller.Move(Math::SIMDVector(targetVelocity.x, 0.0f, targetVelocity.z));
 		}
 		else
 		{
@@ -451,6 +462,22 @@ namespace Actor
 			m_selector.ToggleSelectionType();
 		}
 	}
+
+	void CPlayerPawn::Brush(const App::InputCallbackData& callback)
+	{
+		if(callback.bPressed)
+		{
+			m_selector.ToggleBrush();
+		}
+	}
+
+	void CPlayerPawn::Cleanup(const App::InputCallbackData& callback)
+	{
+		if(callback.bPressed)
+		{
+			m_selector.RemoveFloating();
+		}
+	}
 	
 	void CPlayerPawn::Play(const App::InputCallbackData& callback)
 	{
@@ -517,6 +544,7 @@ namespace Actor
 			m_velocityAxes[1] = 0.0f;
 			m_mouseDeltaFunc = std::bind(&CPlayerPawn::AxisLook, this, std::placeholders::_1, std::placeholders::_2);
 
+			m_controller.Teleport(m_transformBody.GetPosition());
 			m_volume.Register(m_transformBody.GetWorldMatrix());
 		}
 		else
@@ -21,7 +21,7 @@
 #include <Physics/CVolumeCapsule.h>
 #include <Physics/CVolumeSphere.h>
 #include <Physics/CVolumeOBB.h>
-#include <Physics/CRigidbody.h>
+#include <Physics/CCharacterController.h>
 #include <Math/CMathVector2.h>
 #include <Math/CSIMDRay.h>
 #include <Application/CInputData.h>
@@ -96,6 +96,8 @@ namespace Actor
 		void Pan(const App::InputCallbackData& callback);
 		void Zoom(const App::InputCallbackData& callback);
 		void Mode(const App::InputCallbackData& callback);
+		void Brush(const App::InputCallbackData& callback);
+		void Cleanup(const App::InputCallbackData& callback);
 		void Play(const App::InputCallbackData& callback);
 		void Jump(const App::InputCallbackData& callback);
 		void Quit(const App::InputCallbackData& callback);
@@ -124,7 +126,7 @@ namespace Actor
 
 		Data m_data;
 		
-		Physics::CRigidbody m_rigidbody;
+		Physics::CCharacterController m_controller;
 		Physics::CVolumeCapsule m_volume;
 
 		Logic::CTransform m_transformBody;
@@ -23,6 +23,7 @@ namespace Actor
 	CPlayerSelector::CPlayerSelector(const wchar_t* pName, u32 sceneHash) :
 		CVObject(pName, sceneHash),
 		m_selectionType(SelectionType::Place),
+		m_bBrush(false),
 		m_pickedInfo{},
 		m_pPickedCallback(nullptr),
 		m_quadPlacement(L"Player Selector (Placement)", sceneHash),
@@ -99,6 +100,20 @@ namespace Actor
 		}
 
 		UpdateSelectionQuadState(bValidState && bValidScene);
+
+		if(m_bBrush && !bPlaying && bValidScene)
+		{ // Keep feeding the brush stroke while the selection is held.
+			std::lock_guard<std::mutex> lk(m_pickingMutex);
+			if(m_pPickedCallback && m_pickedInfo.info.pVolume)
+			{
+				Logic::CCallback* pCallback = m_pickedInfo.info.pVolume->GetVObject()->FindComponent<Logic::CCallback>();
+				if(pCallback)
+				{
+					m_pickedInfo.val = 3;
+					pCallback->CallCallback(Logic::CALLBACK_INTERACT, &m_pickedInfo);
+				}
+			}
+		}
 	}
 
 	// Physics thread update.
@@ -181,6 +196,11 @@ namespace Actor
 			m_pPickedCallback->CallCallback(Logic::CALLBACK_INTERACT, &m_pickedInfo);
 			m_pPickedCallback = nullptr;
 		}
+
+		if(!callback.bPressed)
+		{
+			m_brush.End();
+		}
 	}
 
 	void CPlayerSelector::ToggleSelectionType()
@@ -188,6 +208,41 @@ namespace Actor
 		m_selectionType = static_cast<SelectionType>((static_cast<u32>(m_selectionType) + 1) % static_cast<u32>(SelectionType::COUNT));
 	}
 
+	void CPlayerSelector::ToggleBrush()
+	{
+		std::lock_guard<std::mutex> lk(m_pickingMutex);
+		m_bBrush = !m_bBrush;
+		m_brush.End();
+	}
+
+	// Method for clearing every block in the picked chunk that isn't connected to the chunk's bottom layer.
+	void CPlayerSelector::RemoveFloating()
+	{
+		Universe::CNodeChunk* pChunk = nullptr;
+
+		{
+			std::lock_guard<std::mutex> lk(m_pickingMutex);
+			if(m_pickedInfo.info.pVolume)
+			{
+				pChunk = dynamic_cast<Universe::CNodeChunk*>(const_cast<CVObject*>(m_pickedInfo.info.pVolume->GetVObject()));
+			}
+		}
+
+		if(pChunk)
+		{
+			Universe::CVoxelRegion::Data data { };
+			data.connectivity = Universe::CVoxelRegion::Connectivity::Solid;
+			m_region.SetData(data);
+			m_region.Build(*pChunk);
+
+			std::vector<u32> blockIndexList;
+			if(m_region.FindFloating(blockIndexList))
+			{
+				pChunk->QueueBlockEdits(blockIndexList, 0);
+			}
+		}
+	}
+
 	void CPlayerSelector::UpdateSelectionQuadState(bool bEnabled)
 	{
 		m_quadPlacement.SetActive(m_selectionType == SelectionType::Place && bEnabled);
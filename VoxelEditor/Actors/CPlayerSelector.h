@@ -11,6 +11,8 @@
 #ifndef CPLAYERSELECTOR_H
 #define CPLAYERSELECTOR_H
 
+#include "../Universe/CVoxelBrush.h"
+#include "../Universe/CVoxelRegion.h"
 #include <Objects/CVObject.h>
 #include <Graphics/CPrimQuad.h>
 #include <Physics/CPhysicsData.h>
@@ -69,9 +71,13 @@ namespace Actor
 		void SetRay(const Math::SIMDVector& origin, const Math::SIMDVector& direction);
 		void OnSelect(const App::InputCallbackData& callback);
 		void ToggleSelectionType();
+		void ToggleBrush();
+		void RemoveFloating();
 
 		// Accessors.
 		inline SelectionType GetSelectionType() const { return m_selectionType; }
+		inline bool IsBrushEnabled() const { return m_bBrush; }
+		inline Universe::CVoxelBrush& Brush() { return m_brush; }
 
 		// Modifiers.
 		inline void SetData(const Data& data) { m_data = data; }
@@ -86,12 +92,16 @@ namespace Actor
 		Data m_data;
 		
 		SelectionType m_selectionType;
+		bool m_bBrush;
 		Math::CSIMDRay m_ray;
 		Logic::CCallback* m_pPickedCallback;
 
 		Graphics::CPrimQuad m_quadPlacement;
 		Graphics::CPrimQuad m_quadDeletion;
 		PickedInfo m_pickedInfo;
+
+		Universe::CVoxelBrush m_brush;
+		Universe::CVoxelRegion m_region;
 	};
 };
 
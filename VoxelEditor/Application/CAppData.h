@@ -47,6 +47,8 @@ namespace App
 	const char INPUT_KEY_PAN[] = "Pan";
 	const char INPUT_KEY_ZOOM[] = "Zoom";
 	const char INPUT_KEY_MODE[] = "Mode";
+	const char INPUT_KEY_BRUSH[] = "Brush";
+	const char INPUT_KEY_CLEANUP[] = "Cleanup";
 	const char INPUT_KEY_PLAY[] = "Play";
 	const char INPUT_KEY_JUMP[] = "Jump";
 	const char INPUT_KEY_QUIT[] = "Quit";
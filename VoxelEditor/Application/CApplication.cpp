@@ -16,6 +16,7 @@
 #include <Resources/CResourceManager.h>
 #include <Physics/CPhysics.h>
 #include <Utilities/CTimer.h>
+#include <Utilities/CJobSystem.h>
 #include <Utilities/CFileSystem.h>
 
 namespace App
@@ -47,6 +48,17 @@ namespace App
 			data.idleIterations = 4;
 			data.rayCastIterations = 2;
 			data.gravity = Math::SIMD_VEC_DOWN * 20.0f;
+			data.parallelFor = [](u32 count, const std::function<void(u32)>& task) {
+				Util::CJobSystem::Instance().ParallelFor(0, count, 1, [&task](u32 begin, u32 end){
+					for(u32 i = begin; i < end; ++i)
+					{
+						task(i);
+					}
+				});
+			};
+			data.runAsync = [](const std::shared_ptr<Physics::AsyncTask>& pTask) {
+				Util::CJobSystem::Instance().JobCPU([pTask](){ pTask->Run(); });
+			};
 			Physics::CPhysics::Instance().SetData(data);
 		}
 
@@ -10,15 +10,21 @@
 
 #include "CVolumeChunk.h"
 #include "../Universe/CNodeChunk.h"
+#include <Math/CMathFloat.h>
+#include <Physics/CGJK.h>
+#include <Physics/CPhysics.h>
+#include <Physics/CRigidbody.h>
 #include <Windows.h>
 #include <string>
 
 namespace Physics
 {
+	thread_local Math::Vector3 CVolumeChunk::m_blockOffset = 0.0f;
+	thread_local CVolumeChunk::SolidMask CVolumeChunk::m_solidMask;
+
 	CVolumeChunk::CVolumeChunk(const CVObject* pObject) :
 		CVolume(pObject),
-		m_blockHalfSize(0.52f),
-		m_blockOffset(0.0f)
+		m_blockHalfSize(0.52f)
 	{
 	}
 
@@ -63,6 +69,8 @@ namespace Physics
 		
 	bool CVolumeChunk::MotionSolver(CVolume* pOther)
 	{
+		if(UsesBoundsSolver(pOther)) { return BoundsMotionSolver(pOther); }
+
 		bool bAdjusted = false;
 
 		Math::Vector3 center = *(Math::Vector3*)GetPosition().ToFloat();
@@ -72,13 +80,7 @@ namespace Physics
 		Math::Vector3 mx = center + m_halfSize;
 		RaycastInfo info { };
 
-		struct HitInfo
-		{
-			RaycastInfo info;
-			Math::Vector3 pt;
-		};
-
-		std::vector<HitInfo> infoList;
+		std::vector<BlockInfo> infoList;
 		float dialation = 1.0f;
 
 		info.distance = dir.Length();
@@ -92,14 +94,10 @@ namespace Physics
 					infoList.clear(); 
 				}*/
 				
-				infoList.push_back({ i, pt });
+				infoList.push_back({ i.index, pt });
 			}))
 		{
-			for(size_t i = 0; i < infoList.size(); ++i)
-			{
-				m_blockOffset = infoList[i].pt;
-				bAdjusted |= CVolume::MotionSolver(pOther);
-			}
+			bAdjusted |= SolveBlocks(pOther, infoList, true);
 		}
 
 		return bAdjusted;
@@ -107,6 +105,8 @@ namespace Physics
 
 	bool CVolumeChunk::IdleSolver(CVolume* pOther)
 	{
+		if(UsesBoundsSolver(pOther)) { return BoundsIdleSolver(pOther); }
+
 		bool bAdjusted = false;
 
 		Math::Vector3 center = *(Math::Vector3*)GetPosition().ToFloat();
@@ -114,30 +114,399 @@ namespace Physics
 		Math::Vector3 mn = center - m_halfSize;
 		Math::Vector3 mx = center + m_halfSize;
 
-		struct HitInfo
-		{
-			u32 index;
-			Math::Vector3 pt;
-		};
-
-		std::vector<HitInfo> infoList;
+		std::vector<BlockInfo> infoList;
 		float dialation = 2.0f;//GetSkinDepth() + pOther->GetSkinDepth();
 
 		if(OctreeIntersectionTest(center, origin, mn, mx, -pOther->GetMaxExtents() - dialation, -pOther->GetMinExtents() + dialation,
 			[&infoList](u32 i, const Math::Vector3& pt) {
-				infoList.push_back({ i, pt });
+				infoList.push_back({ static_cast<int>(i), pt });
 			}))
 		{
-			for(size_t i = 0; i < infoList.size(); ++i)
+			bAdjusted |= SolveBlocks(pOther, infoList, false);
+		}
+
+		return bAdjusted;
+	}
+	
+	// Method for running GJK against candidate blocks. Blocks go through a batched test on their cached separating
+	//  axes four at a time, and only the ones it can't separate reach GJK, which warm starts from the same axes.
+	bool CVolumeChunk::SolveBlocks(CVolume* pOther, const std::vector<BlockInfo>& blockList, bool bMotion)
+	{
+		CRigidbody* pRigidbody = pOther->GetRigidbody();
+		const Math::SIMDVector displacement = bMotion ? pOther->GetSolverVelocity() - GetSolverVelocity() : Math::SIMD_VEC_ZERO;
+		const Math::SIMDVector offset = GetSolverPosition() - pOther->GetSolverPosition();
+		const float margin = GetSkinDepth() + pOther->GetSkinDepth();
+
+		Physics::CPhysics::Instance().GetStats().Count(Physics::CPhysicsStats::Metric::VoxelCandidates, static_cast<u32>(blockList.size()));
+
+		bool bAdjusted = false;
+
+		for(size_t first = 0; first < blockList.size(); first += 4)
+		{
+			const u32 count = static_cast<u32>(min(blockList.size() - first, size_t(4)));
+
+			Math::SIMDVector centerList[4];
+			Math::SIMDVector axisList[4];
+			for(u32 lane = 0; lane < count; ++lane)
 			{
-				m_blockOffset = infoList[i].pt;
-				bAdjusted |= CVolume::IdleSolver(pOther);
+				const BlockInfo& block = blockList[first + lane];
+
+				// Same frame as SupportPoint, relative to the other volume. New pairs start on the axis between centers.
+				centerList[lane] = offset + Math::SIMDVector(block.pt.x, block.pt.y, block.pt.z);
+				axisList[lane] = pRigidbody->GetSeparatingAxis(this, block.index, -centerList[lane]);
+			}
+
+			const u32 separated = CGJK::SeparatedBoxes(pOther, centerList, axisList, count, m_blockHalfSize, GetSolverRotation(), displacement, margin);
+
+			for(u32 lane = 0; lane < count; ++lane)
+			{
+				if(separated & (1 << lane)) { continue; }
+
+				const BlockInfo& block = blockList[first + lane];
+				m_blockOffset = block.pt;
+				bAdjusted |= bMotion ? SolveMotion(pOther, block.index) : SolveIdle(pOther, block.index);
 			}
 		}
 
 		return bAdjusted;
 	}
 	
+	//-----------------------------------------------------------------------------------------------
+	// Bounds solver methods.
+	//-----------------------------------------------------------------------------------------------
+
+	// Slack for treating a resting volume as touching a cell, so ground contacts keep being reported.
+	static const float CONTACT_TOLERANCE = 1e-3f;
+
+	bool CVolumeChunk::UsesBoundsSolver(const CVolume* pOther) const
+	{
+		// Cells are only axis aligned in world space while the chunk is unrotated.
+		return pOther->AllowsBoundsSolver() && fabsf(GetRotation().ToFloat()[3]) > 0.9999f;
+	}
+
+	bool CVolumeChunk::BoundsMotionSolver(CVolume* pOther)
+	{
+		const Math::Vector3 origin = *reinterpret_cast<const Math::Vector3*>(pOther->GetSolverPosition().ToFloat());
+		const Math::Vector3 r = *reinterpret_cast<const Math::Vector3*>((pOther->GetSolverVelocity() - GetSolverVelocity()).ToFloat());
+
+		SweepInfo info;
+		if(!SweepCells(origin, pOther->GetMinExtents(), pOther->GetMaxExtents(), r, info)) { return false; }
+
+		// Volumes already overlapping a cell are stopped where they are.
+		ContactData contactData { };
+		contactData.interval = info.interval;
+		contactData.hitNormal = info.normal;
+		contactData.hitPoint = pOther->GetSolverPosition() + pOther->GetSolverVelocity() * contactData.interval;
+		contactData.pVolume = this;
+		contactData.index = info.index;
+
+		pOther->GetRigidbody()->TryToAddContact(contactData);
+		return true;
+	}
+
+	// Method for sweeping bounds through the grid. Every candidate cell is a slab test against the cell
+	//  grown by the bounds, and only the earliest hit on an exposed face is reported.
+	bool CVolumeChunk::SweepCells(const Math::Vector3& origin, const Math::Vector3& minExtents, const Math::Vector3& maxExtents, 
+		const Math::Vector3& r, SweepInfo& info) const
+	{
+		const Math::Vector3 center = *(Math::Vector3*)GetPosition().ToFloat();
+
+		// Chunk space, where cell (i, j, k) spans [i, i + 1] on each axis.
+		const Math::Vector3 local = origin - center + m_halfSize;
+		const Math::Vector3 pad = m_blockHalfSize - 0.5f;
+		const Math::Vector3 mn = local + minExtents - pad;
+		const Math::Vector3 mx = local + maxExtents + pad;
+
+		Math::Vector3 sweepMn = mn;
+		Math::Vector3 sweepMx = mx;
+		for(int a = 0; a < 3; ++a)
+		{
+			if(r[a] < 0.0f) { sweepMn[a] += r[a]; }
+			else { sweepMx[a] += r[a]; }
+		}
+
+		int lo[3];
+		int hi[3];
+		if(!GetCellRange(sweepMn, sweepMx, lo, hi)) { return false; }
+		LoadSolidMask(lo, hi);
+
+		float bestT = Math::g_MaxFlt;
+		int bestAxis = -1;
+		int bestCell[3] { };
+
+		int cell[3];
+		for(cell[0] = lo[0]; cell[0] <= hi[0]; ++cell[0])
+		{
+			for(cell[2] = lo[2]; cell[2] <= hi[2]; ++cell[2])
+			{
+				for(cell[1] = lo[1]; cell[1] <= hi[1]; ++cell[1])
+				{
+					if(!IsSolid(cell[0], cell[1], cell[2])) { continue; }
+
+					float tEnter = -Math::g_MaxFlt;
+					float tExit = Math::g_MaxFlt;
+					int axis = -1;
+
+					for(int a = 0; a < 3; ++a)
+					{
+						const float cellMn = static_cast<float>(cell[a]);
+						const float cellMx = cellMn + 1.0f;
+
+						if(fabsf(r[a]) < 1e-8f)
+						{ // Not moving on this axis, so it has to overlap the whole step.
+							if(mx[a] <= cellMn || mn[a] >= cellMx) { tExit = -Math::g_MaxFlt; break; }
+							continue;
+						}
+
+						const float invR = 1.0f / r[a];
+						float t0 = (cellMn - mx[a]) * invR;
+						float t1 = (cellMx - mn[a]) * invR;
+						if(t0 > t1) { std::swap(t0, t1); }
+
+						if(t0 > tEnter) { tEnter = t0; axis = a; }
+						if(t1 < tExit) { tExit = t1; }
+					}
+
+					if(axis < 0 || tEnter >= tExit || tExit <= 0.0f || tEnter > 1.0f || tEnter >= bestT) { continue; }
+
+					// Faces shared with another solid cell can't be hit, which keeps volumes from catching on seams.
+					int neighbor[3] = { cell[0], cell[1], cell[2] };
+					neighbor[axis] += r[axis] > 0.0f ? -1 : 1;
+					if(IsSolid(neighbor[0], neighbor[1], neighbor[2])) { continue; }
+
+					bestT = tEnter;
+					bestAxis = axis;
+					bestCell[0] = cell[0]; bestCell[1] = cell[1]; bestCell[2] = cell[2];
+				}
+			}
+		}
+
+		if(bestAxis < 0) { return false; }
+
+		float normal[3] = { 0.0f, 0.0f, 0.0f };
+		normal[bestAxis] = r[bestAxis] > 0.0f ? -1.0f : 1.0f;
+
+		info.index = static_cast<int>(m_data.pChunk->GetIndex(bestCell[0], bestCell[1], bestCell[2]));
+		info.interval = max(bestT, 0.0f);
+		info.pVolume = this;
+		const Math::Vector3 point = origin + r * info.interval;
+		info.point = Math::SIMDVector(point.x, point.y, point.z);
+		info.normal = Math::SIMDVector(normal[0], normal[1], normal[2]);
+		return true;
+	}
+
+	// Method for pushing a resting volume out of the cells it overlaps. Each cell pushes along its shallowest
+	//  exposed face, one axis at a time, out to the same separation the GJK resting contact would leave.
+	//  Every push is stored as a contact keyed by cell, so the final projection after Apply still sees the terrain.
+	bool CVolumeChunk::BoundsIdleSolver(CVolume* pOther)
+	{
+		const Math::Vector3 center = *(Math::Vector3*)GetPosition().ToFloat();
+		const Math::Vector3 origin = *reinterpret_cast<const Math::Vector3*>(pOther->GetSolverPosition().ToFloat());
+
+		const Math::Vector3 local = origin - center + m_halfSize;
+		const Math::Vector3 pad = m_blockHalfSize - 0.5f + GetSkinDepth() + pOther->GetSkinDepth();
+		Math::Vector3 mn = local + pOther->GetMinExtents() - pad;
+		Math::Vector3 mx = local + pOther->GetMaxExtents() + pad;
+
+		int lo[3];
+		int hi[3];
+		if(!GetCellRange(mn - CONTACT_TOLERANCE, mx + CONTACT_TOLERANCE, lo, hi)) { return false; }
+		LoadSolidMask(lo, hi);
+
+		CRigidbody* pRigidbody = pOther->GetRigidbody();
+		const float skin = GetSkinDepth() + pOther->GetSkinDepth();
+		Math::SIMDVector offset = pOther->GetSolverPosition() - GetSolverPosition();
+
+		bool bAdjusted = false;
+
+		int cell[3];
+		for(cell[0] = lo[0]; cell[0] <= hi[0]; ++cell[0])
+		{
+			for(cell[2] = lo[2]; cell[2] <= hi[2]; ++cell[2])
+			{
+				for(cell[1] = lo[1]; cell[1] <= hi[1]; ++cell[1])
+				{
+					if(!IsSolid(cell[0], cell[1], cell[2])) { continue; }
+
+					// Bounds move with every push, so test against where they are now.
+					bool bOverlap = true;
+					for(int a = 0; a < 3 && bOverlap; ++a)
+					{
+						bOverlap = mx[a] > cell[a] - CONTACT_TOLERANCE && mn[a] < cell[a] + 1.0f + CONTACT_TOLERANCE;
+					}
+
+					if(!bOverlap) { continue; }
+
+					float bestDepth = Math::g_MaxFlt;
+					int bestAxis = -1;
+					float bestSign = 0.0f;
+
+					for(int a = 0; a < 3; ++a)
+					{
+						for(int s = -1; s <= 1; s += 2)
+						{
+							int neighbor[3] = { cell[0], cell[1], cell[2] };
+							neighbor[a] += s;
+							if(IsSolid(neighbor[0], neighbor[1], neighbor[2])) { continue; }
+
+							const float depth = s > 0 ? (cell[a] + 1.0f) - mn[a] : mx[a] - cell[a];
+							if(depth < bestDepth)
+							{
+								bestDepth = depth;
+								bestAxis = a;
+								bestSign = static_cast<float>(s);
+							}
+						}
+					}
+
+					// Buried cells have no face to push out through.
+					if(bestAxis < 0) { continue; }
+
+					float normal[3] = { 0.0f, 0.0f, 0.0f };
+					normal[bestAxis] = bestSign;
+
+					const float depth = max(bestDepth, 0.0f);
+					const Math::SIMDVector normalVec(normal[0], normal[1], normal[2]);
+
+					// The stored distance leaves the same push when projected from where the bounds are now.
+					const int feature = static_cast<int>(m_data.pChunk->GetIndex(cell[0], cell[1], cell[2]));
+					pRigidbody->StoreContact(this, feature, offset, normalVec, skin - bestDepth);
+					bAdjusted |= pRigidbody->StepIdleSolver(normalVec * depth, normalVec);
+
+					mn[bestAxis] += bestSign * depth;
+					mx[bestAxis] += bestSign * depth;
+					offset += normalVec * depth;
+				}
+			}
+		}
+
+		return bAdjusted;
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// Query methods.
+	//-----------------------------------------------------------------------------------------------
+
+	// Method for sweeping a query shape through the grid. The shape's bounds are swept, the same as volumes using the bounds solver.
+	bool CVolumeChunk::SweepTest(const CVolume* pShape, const Math::SIMDVector& displacement, SweepInfo& info) const
+	{
+		const Math::Vector3 origin = *reinterpret_cast<const Math::Vector3*>(pShape->GetSolverPosition().ToFloat());
+		const Math::Vector3 r = *reinterpret_cast<const Math::Vector3*>(displacement.ToFloat());
+
+		return SweepCells(origin, pShape->GetMinExtents(), pShape->GetMaxExtents(), r, info);
+	}
+
+	// Method for listing the cells a query shape intersects. Cells under the shape's bounds are tested with GJK against the exact shape.
+	bool CVolumeChunk::OverlapTest(const CVolume* pShape, std::vector<OverlapInfo>& infoList) const
+	{
+		const Math::Vector3 center = *(Math::Vector3*)GetPosition().ToFloat();
+		const Math::Vector3 origin = *reinterpret_cast<const Math::Vector3*>(pShape->GetSolverPosition().ToFloat());
+		const Math::Vector3 local = origin - center + m_halfSize;
+		const Math::Vector3 pad = m_blockHalfSize - 0.5f;
+
+		int lo[3];
+		int hi[3];
+		if(!GetCellRange(local + pShape->GetMinExtents() - pad, local + pShape->GetMaxExtents() + pad, lo, hi)) { return false; }
+		LoadSolidMask(lo, hi);
+
+		std::vector<BlockInfo> blockList;
+
+		int cell[3];
+		for(cell[0] = lo[0]; cell[0] <= hi[0]; ++cell[0])
+		{
+			for(cell[2] = lo[2]; cell[2] <= hi[2]; ++cell[2])
+			{
+				for(cell[1] = lo[1]; cell[1] <= hi[1]; ++cell[1])
+				{
+					if(!IsSolid(cell[0], cell[1], cell[2])) { continue; }
+
+					blockList.push_back({ static_cast<int>(m_data.pChunk->GetIndex(cell[0], cell[1], cell[2])), 
+						center - m_halfSize + Math::Vector3(float(cell[0]), float(cell[1]), float(cell[2])) + 0.5f });
+				}
+			}
+		}
+
+		// Query shapes have no cached axes, so blocks are tested on the axis between centers before GJK runs.
+		const Math::SIMDVector offset = GetSolverPosition() - pShape->GetSolverPosition();
+		bool bFound = false;
+
+		for(size_t first = 0; first < blockList.size(); first += 4)
+		{
+			const u32 count = static_cast<u32>(min(blockList.size() - first, size_t(4)));
+
+			Math::SIMDVector centerList[4];
+			Math::SIMDVector axisList[4];
+			for(u32 lane = 0; lane < count; ++lane)
+			{
+				const Math::Vector3& pt = blockList[first + lane].pt;
+				centerList[lane] = offset + Math::SIMDVector(pt.x, pt.y, pt.z);
+				axisList[lane] = -centerList[lane];
+			}
+
+			const u32 separated = CGJK::SeparatedBoxes(pShape, centerList, axisList, count, m_blockHalfSize, GetSolverRotation(), Math::SIMD_VEC_ZERO, 0.0f);
+
+			for(u32 lane = 0; lane < count; ++lane)
+			{
+				if(separated & (1 << lane)) { continue; }
+
+				const BlockInfo& block = blockList[first + lane];
+				m_blockOffset = block.pt;
+				if(CGJK::Intersection(this, pShape))
+				{
+					infoList.push_back({ block.index, this });
+					bFound = true;
+				}
+			}
+		}
+
+		return bFound;
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// Cell methods.
+	//-----------------------------------------------------------------------------------------------
+
+	bool CVolumeChunk::GetCellRange(const Math::Vector3& mn, const Math::Vector3& mx, int* pLo, int* pHi) const
+	{
+		for(int a = 0; a < 3; ++a)
+		{
+			const int size = static_cast<int>(m_halfSize[a] * 2.0f + 0.5f);
+			pLo[a] = max(static_cast<int>(floorf(mn[a])), 0);
+			pHi[a] = min(static_cast<int>(ceilf(mx[a])) - 1, size - 1);
+
+			if(pLo[a] > pHi[a]) { return false; }
+		}
+
+		return true;
+	}
+
+	// Method for copying the solid cells over a range, plus the one cell border the exposed face tests look at.
+	void CVolumeChunk::LoadSolidMask(const int* pLo, const int* pHi) const
+	{
+		const int lo[3] = { pLo[0] - 1, pLo[1] - 1, pLo[2] - 1 };
+		const int hi[3] = { pHi[0] + 1, pHi[1] + 1, pHi[2] + 1 };
+
+		for(int a = 0; a < 3; ++a)
+		{
+			m_solidMask.lo[a] = lo[a];
+			m_solidMask.size[a] = hi[a] - lo[a] + 1;
+		}
+
+		m_data.pChunk->CopySolidMask(lo, hi, m_solidMask.solidList);
+	}
+
+	// Cells outside the loaded mask read as empty, the same as cells outside the chunk.
+	bool CVolumeChunk::IsSolid(int i, int j, int k) const
+	{
+		const int local[3] = { i - m_solidMask.lo[0], j - m_solidMask.lo[1], k - m_solidMask.lo[2] };
+		for(int a = 0; a < 3; ++a)
+		{
+			if(local[a] < 0 || local[a] >= m_solidMask.size[a]) { return false; }
+		}
+
+		return m_solidMask.solidList[(static_cast<size_t>(local[0]) * m_solidMask.size[2] + local[2]) * m_solidMask.size[1] + local[1]] != 0;
+	}
+	
 	//-----------------------------------------------------------------------------------------------
 	// Utility methods.
 	//-----------------------------------------------------------------------------------------------
@@ -147,6 +516,12 @@ namespace Physics
 		m_halfSize = Math::Vector3(float(m_data.pChunk->GetWidth()), float(m_data.pChunk->GetHeight()), float(m_data.pChunk->GetLength())) * 0.5f;
 	}
 
+	// Method for letting the chunk free its blocks now that no snapshot reaches the volume.
+	void CVolumeChunk::OnSnapshotsReleased() const
+	{
+		m_data.pChunk->ReleaseBlocks();
+	}
+
 	bool CVolumeChunk::RayTest(const QueryRay& query, RaycastInfo& info) const
 	{
 		Math::Vector3 center = *(Math::Vector3*)GetPosition().ToFloat();
@@ -42,6 +42,8 @@ namespace Physics
 		bool MotionSolver(CVolume* pOther) final;
 		bool IdleSolver(CVolume* pOther) final;
 		bool RayTest(const QueryRay& query, RaycastInfo& info) const final;
+		bool SweepTest(const CVolume* pShape, const Math::SIMDVector& displacement, SweepInfo& info) const final;
+		bool OverlapTest(const CVolume* pShape, std::vector<OverlapInfo>& infoList) const final;
 		Math::SIMDVector SupportPoint(const Math::SIMDVector& dir, const CVolume* pVolumeA, float inset = 0.0f) const final;
 
 		void SetData(const Data& data);
@@ -55,14 +57,51 @@ namespace Physics
 			const Math::Vector3& mn, const Math::Vector3& mx, const Math::Vector3& mnOffset, const Math::Vector3& mxOffset, 
 			std::function<void(u32, const Math::Vector3&)> onFound) const;
 
+		void OnSnapshotsReleased() const final;
+
 		// Accessors.
 		virtual inline const mData& GetData() const final { return m_data; }
 
+	private:
+		// Candidate block for the GJK solvers, with its center in the same space m_blockOffset uses.
+		struct BlockInfo
+		{
+			int index;
+			Math::Vector3 pt;
+		};
+
+		// Solid cells over the range a bounds solver is working in, copied out of the chunk in one go.
+		struct SolidMask
+		{
+			int lo[3];
+			int size[3];
+			std::vector<u8> solidList;
+		};
+
+	private:
+		bool SolveBlocks(CVolume* pOther, const std::vector<BlockInfo>& blockList, bool bMotion);
+
+		// Swept bounds solvers for volumes that allow it.
+		bool UsesBoundsSolver(const CVolume* pOther) const;
+		bool BoundsMotionSolver(CVolume* pOther);
+		bool BoundsIdleSolver(CVolume* pOther);
+		bool SweepCells(const Math::Vector3& origin, const Math::Vector3& minExtents, const Math::Vector3& maxExtents, 
+			const Math::Vector3& r, SweepInfo& info) const;
+
+		bool GetCellRange(const Math::Vector3& mn, const Math::Vector3& mx, int* pLo, int* pHi) const;
+		void LoadSolidMask(const int* pLo, const int* pHi) const;
+		bool IsSolid(int i, int j, int k) const;
+
 	private:
 		Math::Vector3 m_halfSize;
 		Math::Vector3 m_blockHalfSize;
-		Math::Vector3 m_blockOffset;
 		Data m_data;
+
+		// Offset of the block GJK is testing. Chunks are shared by every island being solved, so each thread keeps its own.
+		static thread_local Math::Vector3 m_blockOffset;
+
+		// Solid mask the bounds solvers test against, kept per thread for the same reason.
+		static thread_local SolidMask m_solidMask;
 	};
 };
 
@@ -9,6 +9,7 @@
 //-------------------------------------------------------------------------------------------------
 
 #include "CNodeChunk.h"
+#include "CVoxelBrush.h"
 #include "../Actors/CPlayer.h"
 #include <Graphics/CMeshRenderer.h>
 #include <Graphics/CMaterial.h>
@@ -17,7 +18,8 @@
 #include <Resources/CResourceManager.h>
 #include <Application/CSceneManager.h>
 #include <Utilities/CMemoryFree.h>
-#include <Utilities/CJobSystem.h>
+#include <Utilities/CJobGraph.h>
+#include <Physics/CPhysics.h>
 #include <Math/CMathVector2.h>
 #include <Math/CMathFNV.h>
 #include <Windows.h>
@@ -34,17 +36,26 @@ namespace Universe
 		m_meshData(this),
 		m_meshContainer(this),
 		m_pMeshRendererList{ nullptr, nullptr },
+		m_meshJobCount(0),
 		m_pMaterial(nullptr),
-		m_pBlockList(nullptr) {
+		m_pBlockList(nullptr),
+		m_bReleasePending(false) {
 	}
 	
-	CNodeChunk::~CNodeChunk() { }
+	CNodeChunk::~CNodeChunk()
+	{
+		SAFE_DELETE_ARRAY(m_pBlockList);
+	}
 	
 	void CNodeChunk::Initialize()
 	{
 		{ // Create ids.
 			std::lock_guard<std::shared_mutex> lk(m_mutex);
 
+			// Blocks from a release still waiting on snapshots are no longer reachable through the new registration.
+			SAFE_DELETE_ARRAY(m_pBlockList);
+			m_bReleasePending = false;
+
 			const u32 total = m_data.width * m_data.height * m_data.length;
 			m_pBlockList = new Block[total];
 
@@ -81,6 +92,13 @@ namespace Universe
 			m_volume.Register(m_transform.GetWorldMatrix());
 		}
 
+		{ // Create the navigation graph.
+			AI::CVoxelNav::Data data { };
+			data.pChunk = this;
+			m_nav.SetData(data);
+			m_nav.Initialize();
+		}
+
 		{ // Setup the logic callback(s).
 			Logic::CCallback::Data data { };
 			data.callbackMap.insert({ Logic::CALLBACK_INTERACT, std::bind(&CNodeChunk::InteractCallback, this, std::placeholders::_1) });
@@ -212,7 +230,14 @@ namespace Universe
 		}
 
 		{ // Create the mesh renderer.
-			m_pMeshRendererList[m_meshIndex] = CFactory::Instance().CreateMeshRenderer(this);
+			// Renderers retired by earlier rebuilds are reused, keeping their GPU buffers when the new mesh fits.
+			Graphics::CMeshRenderer* pMeshRenderer = nullptr;
+			if(!m_meshRendererPool.TryPopFront(pMeshRenderer))
+			{
+				pMeshRenderer = CFactory::Instance().CreateMeshRenderer(this);
+			}
+
+			m_pMeshRendererList[m_meshIndex] = pMeshRenderer;
 
 			Graphics::CMeshRenderer::Data data { };
 			data.bSkipRegistration = true;
@@ -233,6 +258,8 @@ namespace Universe
 		mtx *= App::CSceneManager::Instance().CameraManager().GetDefaultCamera()->GetProjectionMatrix();
 
 		m_pMaterial->SetFloat(frameBufferHash, vpHash, mtx.f32, 16);
+
+		m_nav.Process();
 	}
 	
 	void CNodeChunk::PreRender()
@@ -244,52 +271,189 @@ namespace Universe
 
 		m_pMaterial->SetFloat(maxtrixBufferHash, worldHash, mtx.f32, 16);
 
-		if(m_meshFuture[0].Ready() && m_meshFuture[1].Ready())
+		if(m_meshJobCount == 0)
 		{
 			if(m_bDirty)
 			{
-				App::CSceneManager::Instance().Garbage().Dispose([=](){ SAFE_RELEASE_DELETE(m_pMeshRendererList[(m_meshIndex + 1) & 0x1]); });
+				Graphics::CMeshRenderer* pRetired = m_pMeshRendererList[(m_meshIndex + 1) & 0x1];
+				m_pMeshRendererList[(m_meshIndex + 1) & 0x1] = nullptr;
+
+				if(pRetired)
+				{ // Hand the retired renderer back to the pool once the GPU can no longer be using it.
+					App::CSceneManager::Instance().Garbage().Dispose([=](){
+						Graphics::CMeshRenderer* pMeshRenderer = pRetired;
+						pMeshRenderer->Recycle();
+						m_meshRendererPool.PushBack(pMeshRenderer);
+					});
+				}
 				m_meshContainer.SetMeshRenderer(m_pMeshRendererList[m_meshIndex]);
 				m_bDirty = false;
 			}
 
-			if(!blockDeque.Empty())
+			bool bEdits = !blockDeque.Empty();
+
+			// The edit lock is held until the blocks are locked, so a brush never rasterizes against edits that have
+			//  left the edit list but haven't reached the blocks yet.
+			std::unique_lock<std::mutex> lkEdit(m_editMutex);
+			if(!m_editList.empty())
 			{
+				m_applyList.swap(m_editList);
+				bEdits = true;
+			}
+
+			if(bEdits)
+			{
+				bool bWake = false;
+				Math::Vector3 wakeMn;
+				Math::Vector3 wakeMx;
+
 				{
 					std::lock_guard<std::shared_mutex> lk(m_mutex);
+					lkEdit.unlock();
+
+					// Track the cells being edited, so bodies sleeping on or against them can be woken.
+					const u32 column = m_data.length * m_data.height;
+					int lo[3] = { INT_MAX, INT_MAX, INT_MAX };
+					int hi[3] = { INT_MIN, INT_MIN, INT_MIN };
+					const auto trackEdit = [&](u32 index) {
+						const int cell[3] = {
+							static_cast<int>(index / column),
+							static_cast<int>(m_data.height - 1 - (index % column) % m_data.height),
+							static_cast<int>((index % column) / m_data.height),
+						};
+
+						for(int a = 0; a < 3; ++a)
+						{
+							lo[a] = min(lo[a], cell[a]);
+							hi[a] = max(hi[a], cell[a]);
+						}
+					};
 
 					BlockUpdateData data;
 					while(blockDeque.TryPopFront(data))
 					{
 						m_pBlockList[data.index].id = data.id;
+						m_nav.Invalidate(data.index);
+						trackEdit(data.index);
 					}
+
+					for(const BlockUpdateData& edit : m_applyList)
+					{
+						m_pBlockList[edit.index].id = edit.id;
+						m_nav.Invalidate(edit.index);
+						trackEdit(edit.index);
+					}
+
+					m_applyList.clear();
+
+					// Cell positions are centers, so grow by half a cell plus a cell of slack for bodies resting on top.
+					bWake = lo[0] <= hi[0];
+					wakeMn = *reinterpret_cast<const Math::Vector3*>((internalGetPositionFromIndex(lo[0], lo[1], lo[2]) - 1.5f).ToFloat());
+					wakeMx = *reinterpret_cast<const Math::Vector3*>((internalGetPositionFromIndex(hi[0], hi[1], hi[2]) + 1.5f).ToFloat());
 				}
 
-				m_meshIndex = (m_meshIndex + 1) & 0x1;
-				m_bDirty = true;
-				m_meshFuture[m_meshIndex] = Util::CJobSystem::Instance().JobGraphics([=](){
-					m_meshData.Release();
-					BuildMesh();
-				}, true);
+				if(bWake) { Physics::CPhysics::Instance().WakeRegion(wakeMn, wakeMx); }
+
+				QueueMesh();
 			}
 		}
 	}
 
+	// Method for rebuilding the mesh on a job thread. PreRender swaps it in once no build is in flight.
+	void CNodeChunk::QueueMesh()
+	{
+		m_meshIndex = (m_meshIndex + 1) & 0x1;
+		m_bDirty = true;
+		++m_meshJobCount;
+
+		Util::CJobGraph graph;
+		graph.Add([=](){
+			m_meshData.Release();
+			BuildMesh();
+		}, Util::CJobGraph::JobType::Graphics);
+		graph.Submit([this](){ --m_meshJobCount; });
+	}
+
 	void CNodeChunk::Release()
 	{
+		m_nav.Release();
+
+		{ // Async queries may still read the blocks through older snapshots, so the volume frees them once they're done.
+			std::lock_guard<std::shared_mutex> lk(m_mutex);
+			m_bReleasePending = true;
+		}
+
 		m_volume.Deregister();
 		m_meshContainer.Release();
 		SAFE_RELEASE_DELETE(m_pMeshRendererList[1]);
 		SAFE_RELEASE_DELETE(m_pMeshRendererList[0]);
+
+		Graphics::CMeshRenderer* pMeshRenderer = nullptr;
+		while(m_meshRendererPool.TryPopFront(pMeshRenderer))
+		{
+			SAFE_RELEASE_DELETE(pMeshRenderer);
+		}
 		m_meshData.Release();
+	}
+
+	// Method for freeing the blocks of a released chunk. Called by the volume from whichever thread let go of it last.
+	void CNodeChunk::ReleaseBlocks()
+	{
+		std::lock_guard<std::shared_mutex> lk(m_mutex);
+		if(!m_bReleasePending) { return; }
 
 		SAFE_DELETE_ARRAY(m_pBlockList);
+		m_bReleasePending = false;
 	}
 
 	void CNodeChunk::InteractCallback(void* pVal)
 	{
 		Actor::CPlayerSelector::PickedInfo* pInfo = reinterpret_cast<Actor::CPlayerSelector::PickedInfo*>(pVal);
-		if(pInfo->val == 1)
+		if(pInfo->pPlayerSelector->IsBrushEnabled())
+		{
+			if(pInfo->val == 1 || pInfo->val == 3)
+			{
+				const bool bBreak = pInfo->pPlayerSelector->GetSelectionType() == Actor::CPlayerSelector::SelectionType::Break;
+				CVoxelBrush& brush = pInfo->pPlayerSelector->Brush();
+
+				Math::Vector3 point;
+				const Math::Vector3 normal(roundf(pInfo->info.normal[0]), roundf(pInfo->info.normal[1]), roundf(pInfo->info.normal[2]));
+				{ // Brush strokes follow the picked block, or the empty block in front of it when placing.
+					std::shared_lock<std::shared_mutex> lk(m_mutex);
+
+					int i, j, k;
+					internalGenerateIndicesFromRaycastInfo(pInfo->info, i, j, k);
+					if(!bBreak)
+					{
+						i += static_cast<int>(normal.x);
+						j += static_cast<int>(normal.y);
+						k += static_cast<int>(normal.z);
+					}
+
+					const Math::SIMDVector position = internalGetPositionFromIndex(i, j, k);
+					point = Math::Vector3(position[0], position[1], position[2]);
+				}
+
+				if(brush.GetData().mode != CVoxelBrush::Mode::Paint)
+				{
+					brush.SetMode(bBreak ? CVoxelBrush::Mode::Subtract : CVoxelBrush::Mode::Union);
+				}
+
+				// The stroke is locked to the plane of the face it started on.
+				if(pInfo->val == 1 || !brush.IsActive())
+				{
+					brush.Begin(point, normal);
+				}
+				else
+				{
+					brush.AddPoint(point);
+				}
+
+				CNodeChunk* pChunk = this;
+				brush.Apply(&pChunk, 1);
+			}
+		}
+		else if(pInfo->val == 1)
 		{
 			std::shared_lock<std::shared_mutex> lk(m_mutex);
 
@@ -328,6 +492,67 @@ namespace Universe
 		}
 	}
 	
+	// Method for rasterizing a brush's pending stroke into this chunk. The edits are applied on the next PreRender, and
+	//  the ones still queued are laid over the blocks first so the stroke diffs against what the chunk is about to hold.
+	void CNodeChunk::ApplyBrush(CVoxelBrush& brush)
+	{
+		std::lock_guard<std::mutex> lkEdit(m_editMutex);
+		std::shared_lock<std::shared_mutex> lk(m_mutex);
+
+		const Math::SIMDVector origin = internalGetPositionFromIndex(0, 0, 0);
+		brush.Rasterize(m_pBlockList, m_data, Math::Vector3(origin[0], origin[1], origin[2]), m_editList);
+	}
+	
+	// Method for queuing the same id into many blocks at once. The edits are applied on the next PreRender.
+	void CNodeChunk::QueueBlockEdits(const std::vector<u32>& blockIndexList, u16 id)
+	{
+		std::lock_guard<std::mutex> lk(m_editMutex);
+
+		m_editList.reserve(m_editList.size() + blockIndexList.size());
+		for(u32 index : blockIndexList)
+		{
+			m_editList.push_back({ index, id });
+		}
+	}
+
+	// Method for copying every block id under a single lock, for analysis passes that would otherwise lock per block.
+	void CNodeChunk::CopyBlockIds(std::vector<u16>& idList, Data& data) const
+	{
+		std::shared_lock<std::shared_mutex> lk(m_mutex);
+
+		data = m_data;
+
+		const u32 total = m_data.width * m_data.height * m_data.length;
+		idList.resize(total);
+		for(u32 i = 0; i < total; ++i)
+		{
+			idList[i] = m_pBlockList[i].id;
+		}
+	}
+	
+	// Method for copying which blocks are solid over an inclusive cell range under a single lock. Cells are laid out
+	//  i, then k, then j, and cells outside the chunk are left empty.
+	void CNodeChunk::CopySolidMask(const int* pLo, const int* pHi, std::vector<u8>& solidList) const
+	{
+		const int size[3] = { pHi[0] - pLo[0] + 1, pHi[1] - pLo[1] + 1, pHi[2] - pLo[2] + 1 };
+		solidList.assign(static_cast<size_t>(size[0]) * size[1] * size[2], 0);
+
+		std::shared_lock<std::shared_mutex> lk(m_mutex);
+
+		const int dim[3] = { static_cast<int>(m_data.width), static_cast<int>(m_data.height), static_cast<int>(m_data.length) };
+		for(int i = max(pLo[0], 0); i <= min(pHi[0], dim[0] - 1); ++i)
+		{
+			for(int k = max(pLo[2], 0); k <= min(pHi[2], dim[2] - 1); ++k)
+			{
+				u8* pColumn = solidList.data() + (static_cast<size_t>(i - pLo[0]) * size[2] + (k - pLo[2])) * size[1];
+				for(int j = max(pLo[1], 0); j <= min(pHi[1], dim[1] - 1); ++j)
+				{
+					pColumn[j - pLo[1]] = m_pBlockList[internalGetIndex(i, j, k)].id != 0;
+				}
+			}
+		}
+	}
+	
 	//-----------------------------------------------------------------------------------------------
 	// File methods.
 	//-----------------------------------------------------------------------------------------------
@@ -348,13 +573,10 @@ namespace Universe
 			const u32 total = m_data.width * m_data.height * m_data.length;
 			file.read(reinterpret_cast<char*>(m_pBlockList), sizeof(Block) * total);
 		}
+
+		m_nav.InvalidateAll();
 		
-		m_meshIndex = (m_meshIndex + 1) & 0x1;
-		m_bDirty = true;
-		m_meshFuture[m_meshIndex] = Util::CJobSystem::Instance().JobGraphics([=](){
-			m_meshData.Release();
-			BuildMesh();
-		}, true);
+		QueueMesh();
 	}
 	
 	//-----------------------------------------------------------------------------------------------
@@ -12,6 +12,7 @@
 #define CNODECHUNK_H
 
 #include "../Physics/CVolumeChunk.h"
+#include "../AI/CVoxelNav.h"
 #include <Globals/CGlobals.h>
 #include <Objects/CVObject.h>
 #include <Graphics/CMeshData.h>
@@ -19,9 +20,10 @@
 #include <Logic/CTransform.h>
 #include <Logic/CCallback.h>
 #include <Math/CMathVector3.h>
-#include <Utilities/CFuture.h>
 #include <Utilities/CTSDeque.h>
 #include <shared_mutex>
+#include <mutex>
+#include <vector>
 #include <fstream>
 
 namespace Graphics
@@ -32,6 +34,8 @@ namespace Graphics
 
 namespace Universe
 {
+	class CVoxelBrush;
+
 	enum SIDE : u8
 	{
 		SIDE_LEFT,
@@ -63,14 +67,13 @@ namespace Universe
 
 	class CNodeChunk : public CVObject
 	{
-	private:
+	public:
 		struct BlockUpdateData
 		{
 			u32 index;
 			u16 id;
 		};
 
-	public:
 		struct Data
 		{
 			u32 width;
@@ -99,6 +102,12 @@ namespace Universe
 
 		void SaveToFile(std::ofstream& file) const;
 		void LoadFromFile(std::ifstream& file);
+
+		void ApplyBrush(CVoxelBrush& brush);
+		void QueueBlockEdits(const std::vector<u32>& blockIndexList, u16 id);
+		void CopyBlockIds(std::vector<u16>& idList, Data& data) const;
+		void CopySolidMask(const int* pLo, const int* pHi, std::vector<u8>& solidList) const;
+		void ReleaseBlocks();
 		
 		// Accessors.
 		inline u32 GetWidth() const
@@ -155,6 +164,8 @@ namespace Universe
 			return m_pBlockList[internalGetIndex(i, j, k)];
 		}
 
+		inline AI::CVoxelNav& Nav() { return m_nav; }
+
 		// Modifiers.
 		inline void SetData(const Data& data)
 		{
@@ -165,6 +176,7 @@ namespace Universe
 	private:
 		void BuildMesh();
 		void PreRender();
+		void QueueMesh();
 		void InteractCallback(void* pVal);
 		
 		void internalGenerateIndicesFromRaycastInfo(const Physics::RaycastInfo& info, int& i, int& j, int& k) const;
@@ -195,16 +207,26 @@ namespace Universe
 		Logic::CTransform m_transform;
 		Physics::CVolumeChunk m_volume;
 		Logic::CCallback m_callback;
+		AI::CVoxelNav m_nav;
 
 		Util::CDeque<BlockUpdateData> blockDeque;
 
+		// Bulk edits from brush strokes. Filled under the edit mutex, applied in PreRender with the single block edits.
+		std::mutex m_editMutex;
+		std::vector<BlockUpdateData> m_editList;
+		std::vector<BlockUpdateData> m_applyList;
+
 		Graphics::CMeshData m_meshData;
 		Graphics::CMeshContainer m_meshContainer;
 		Graphics::CMeshRenderer* m_pMeshRendererList[2];
-		Util::CFuture<void> m_meshFuture[2];
+		Util::CTSDeque<Graphics::CMeshRenderer*> m_meshRendererPool;
+		Au32 m_meshJobCount;
 		Graphics::CMaterial* m_pMaterial;
 
 		Block* m_pBlockList;
+
+		// Set by Release. The blocks are freed once no snapshot can reach the volume, unless Initialize gets to them first.
+		bool m_bReleasePending;
 	};
 };
 
@@ -0,0 +1,500 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Copyright (c) Ryan Alasandro
+//
+// Application: Voxel Editor
+//
+// File: Universe/CVoxelBrush.cpp
+//
+//-------------------------------------------------------------------------------------------------
+
+#include "CVoxelBrush.h"
+#include <Math/CMathFloat.h>
+#include <minmax.h>
+
+namespace Universe
+{
+	static const u32 MAX_SPLINE_STEPS = 16;
+
+	CVoxelBrush::CVoxelBrush() :
+		m_boundsMin(Math::g_MaxFlt),
+		m_boundsMax(-Math::g_MaxFlt),
+		m_planeNormal(0.0f) {
+	}
+
+	CVoxelBrush::~CVoxelBrush() { }
+
+	//-----------------------------------------------------------------------------------------------
+	// Stroke methods.
+	//-----------------------------------------------------------------------------------------------
+
+	// Method for starting a stroke on the plane through the point, facing along the normal. A zero normal leaves the stroke free.
+	void CVoxelBrush::Begin(const Math::Vector3& point, const Math::Vector3& normal)
+	{
+		m_pointList.clear();
+		m_pendingList.clear();
+		m_boundsMin = Math::g_MaxFlt;
+		m_boundsMax = -Math::g_MaxFlt;
+
+		const float lenSq = normal.LengthSq();
+		m_planeNormal = lenSq > 1e-6f ? normal * (1.0f / sqrtf(lenSq)) : Math::Vector3(0.0f);
+
+		m_pointList.push_back(point);
+
+		if(m_data.shape == Shape::Line || m_data.shape == Shape::Spline)
+		{
+			AddSegment(point, point);
+		}
+		else
+		{
+			AddStamp(point);
+		}
+	}
+
+	// Method for extending the stroke. The point is pulled back onto the stroke's plane, so picks landing on blocks
+	//  the stroke just placed or removed don't push it toward or away from the camera.
+	void CVoxelBrush::AddPoint(const Math::Vector3& picked)
+	{
+		if(m_pointList.empty())
+		{
+			Begin(picked, Math::Vector3(0.0f));
+			return;
+		}
+
+		const Math::Vector3 point = picked - m_planeNormal * m_planeNormal.Dot(picked - m_pointList.front());
+
+		const Math::Vector3 last = m_pointList.back();
+		if(point == last) { return; }
+
+		m_pointList.push_back(point);
+		const size_t n = m_pointList.size();
+
+		switch(m_data.shape)
+		{
+			case Shape::Line:
+				AddSegment(last, point);
+				break;
+			case Shape::Spline:
+				// The newest span uses the current point as its own outgoing tangent, so the stroke never lags behind the cursor.
+				AddSpline(m_pointList[n > 2 ? n - 3 : 0], last, point, point);
+				break;
+			default:
+			{ // Stamp shapes fill the gap between samples so fast strokes don't leave holes.
+				float spacing = m_data.radius;
+				if(m_data.shape == Shape::Box)
+				{
+					spacing = min(m_data.halfSize.x, min(m_data.halfSize.y, m_data.halfSize.z));
+				}
+
+				spacing = max(spacing * 0.5f, 0.5f);
+
+				const Math::Vector3 delta = point - last;
+				const float len = delta.Length();
+				const u32 steps = static_cast<u32>(ceilf(len / spacing));
+				for(u32 i = 1; i <= steps; ++i)
+				{
+					AddStamp(last + delta * (static_cast<float>(i) / steps));
+				}
+
+				if(steps == 0)
+				{
+					AddStamp(point);
+				}
+			} break;
+		}
+	}
+
+	// Method for rasterizing the pending part of the stroke into every chunk it touches.
+	void CVoxelBrush::Apply(CNodeChunk* const* ppChunkList, u32 chunkCount)
+	{
+		if(m_pendingList.empty()) { return; }
+
+		for(u32 i = 0; i < chunkCount; ++i)
+		{
+			ppChunkList[i]->ApplyBrush(*this);
+		}
+
+		m_pendingList.clear();
+		m_boundsMin = Math::g_MaxFlt;
+		m_boundsMax = -Math::g_MaxFlt;
+	}
+
+	void CVoxelBrush::End()
+	{
+		m_pointList.clear();
+		m_pendingList.clear();
+		m_boundsMin = Math::g_MaxFlt;
+		m_boundsMax = -Math::g_MaxFlt;
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// Rasterization.
+	//-----------------------------------------------------------------------------------------------
+
+	// Method for evaluating the pending primitives against a chunk's blocks. The origin is the world position of block (0, 0, 0)'s center.
+	// Edits already in the edit list are treated as applied, so strokes rasterized before the chunk catches up build on each other.
+	// Returns the number of edits appended to the edit list.
+	u32 CVoxelBrush::Rasterize(const CNodeChunk::Block* pBlockList, const CNodeChunk::Data& chunkData, const Math::Vector3& origin,
+		std::vector<CNodeChunk::BlockUpdateData>& editList)
+	{
+		if(m_pendingList.empty()) { return 0; }
+
+		const size_t queuedCount = editList.size();
+
+		const int dim[] = { static_cast<int>(chunkData.width), static_cast<int>(chunkData.height), static_cast<int>(chunkData.length) };
+		int mn[3], mx[3], rmn[3], rmx[3], rsz[3];
+
+		// Find the block range whose centers can fall inside the stroke, and a one block border around it for smoothing.
+		for(int n = 0; n < 3; ++n)
+		{
+			mn[n] = max(static_cast<int>(ceilf(m_boundsMin[n] - origin[n])), 0);
+			mx[n] = min(static_cast<int>(floorf(m_boundsMax[n] - origin[n])), dim[n] - 1);
+			if(mn[n] > mx[n]) { return 0; }
+
+			rmn[n] = max(mn[n] - 1, 0);
+			rmx[n] = min(mx[n] + 1, dim[n] - 1);
+			rsz[n] = rmx[n] - rmn[n] + 1;
+		}
+
+		auto LocalIndex = [&](int i, int j, int k) {
+			return static_cast<size_t>(((i - rmn[0]) * rsz[2] + (k - rmn[2])) * rsz[1] + (j - rmn[1]));
+		};
+
+		auto BlockIndex = [&](int i, int j, int k) {
+			return static_cast<u32>(i * dim[2] * dim[1] + k * dim[1] + (dim[1] - 1 - j));
+		};
+
+		// Copy the affected region out of the chunk, with the queued edits laid over it in the order they'll be applied.
+		auto CopySource = [&]() {
+			for(int i = rmn[0]; i <= rmx[0]; ++i)
+			{
+				for(int k = rmn[2]; k <= rmx[2]; ++k)
+				{
+					for(int j = rmn[1]; j <= rmx[1]; ++j)
+					{
+						m_srcList[LocalIndex(i, j, k)] = pBlockList[BlockIndex(i, j, k)].id;
+					}
+				}
+			}
+
+			const u32 column = static_cast<u32>(dim[2] * dim[1]);
+			for(size_t e = 0; e < queuedCount; ++e)
+			{
+				const u32 index = editList[e].index;
+				const int i = static_cast<int>(index / column);
+				const int k = static_cast<int>((index % column) / dim[1]);
+				const int j = dim[1] - 1 - static_cast<int>(index % dim[1]);
+				if(i < rmn[0] || i > rmx[0] || j < rmn[1] || j > rmx[1] || k < rmn[2] || k > rmx[2]) { continue; }
+
+				m_srcList[LocalIndex(i, j, k)] = editList[e].id;
+			}
+		};
+
+		const size_t regionSize = static_cast<size_t>(rsz[0]) * rsz[1] * rsz[2];
+		m_srcList.resize(regionSize);
+		m_maskList.assign(regionSize, 0);
+
+		CopySource();
+		m_dstList = m_srcList;
+
+		// CSG pass. Columns are tested four blocks at a time.
+		const vf32 laneOffset = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+		for(int i = mn[0]; i <= mx[0]; ++i)
+		{
+			const float x = origin.x + i;
+			for(int k = mn[2]; k <= mx[2]; ++k)
+			{
+				const float z = origin.z + k;
+
+				// Cull primitives that can't reach this column.
+				m_columnList.clear();
+				for(const Prim& prim : m_pendingList)
+				{
+					if(x >= prim.mn.x && x <= prim.mx.x && z >= prim.mn.z && z <= prim.mx.z)
+					{
+						m_columnList.push_back(&prim);
+					}
+				}
+
+				if(m_columnList.empty()) { continue; }
+
+				for(int j = mn[1]; j <= mx[1]; j += 4)
+				{
+					const vf32 y = _mm_add_ps(_mm_set1_ps(origin.y + j), laneOffset);
+
+					vf32 inside = _mm_setzero_ps();
+					for(const Prim* pPrim : m_columnList)
+					{
+						inside = _mm_or_ps(inside, InsideMask(*pPrim, x, y, z));
+					}
+
+					int laneMask = _mm_movemask_ps(inside);
+					if(laneMask && m_data.noiseScale > 0.0f)
+					{
+						laneMask &= _mm_movemask_ps(NoiseMask(x, y, z));
+					}
+
+					const int laneCount = min(4, mx[1] - j + 1);
+					for(int lane = 0; lane < laneCount; ++lane)
+					{
+						if((laneMask & (1 << lane)) == 0) { continue; }
+
+						const size_t index = LocalIndex(i, j + lane, k);
+						m_maskList[index] = 1;
+
+						switch(m_data.mode)
+						{
+							case Mode::Union:
+								m_dstList[index] = m_data.id;
+								break;
+							case Mode::Subtract:
+								m_dstList[index] = 0;
+								break;
+							case Mode::Paint:
+								if(m_dstList[index] != 0) { m_dstList[index] = m_data.id; }
+								break;
+							default:
+								break;
+						}
+					}
+				}
+			}
+		}
+
+		// Smoothing pass. A majority filter over the face neighbors of every block the brush touched.
+		if(m_data.bSmooth && m_data.mode != Mode::Paint)
+		{
+			m_srcList.swap(m_dstList);
+			m_dstList = m_srcList;
+
+			for(int i = mn[0]; i <= mx[0]; ++i)
+			{
+				for(int k = mn[2]; k <= mx[2]; ++k)
+				{
+					for(int j = mn[1]; j <= mx[1]; ++j)
+					{
+						const size_t index = LocalIndex(i, j, k);
+						if(m_maskList[index] == 0) { continue; }
+
+						int count = m_srcList[index] != 0;
+						if(i > rmn[0] && m_srcList[LocalIndex(i - 1, j, k)] != 0) ++count;
+						if(i < rmx[0] && m_srcList[LocalIndex(i + 1, j, k)] != 0) ++count;
+						if(j > rmn[1] && m_srcList[LocalIndex(i, j - 1, k)] != 0) ++count;
+						if(j < rmx[1] && m_srcList[LocalIndex(i, j + 1, k)] != 0) ++count;
+						if(k > rmn[2] && m_srcList[LocalIndex(i, j, k - 1)] != 0) ++count;
+						if(k < rmx[2] && m_srcList[LocalIndex(i, j, k + 1)] != 0) ++count;
+
+						if(count >= 4)
+						{
+							if(m_dstList[index] == 0) { m_dstList[index] = m_data.id; }
+						}
+						else
+						{
+							m_dstList[index] = 0;
+						}
+					}
+				}
+			}
+
+			// Restore the untouched source for the diff below.
+			CopySource();
+		}
+
+		// Emit edits for blocks that actually changed.
+		u32 editCount = 0;
+		for(int i = mn[0]; i <= mx[0]; ++i)
+		{
+			for(int k = mn[2]; k <= mx[2]; ++k)
+			{
+				for(int j = mn[1]; j <= mx[1]; ++j)
+				{
+					const size_t index = LocalIndex(i, j, k);
+					if(m_maskList[index] && m_dstList[index] != m_srcList[index])
+					{
+						editList.push_back({ BlockIndex(i, j, k), m_dstList[index] });
+						++editCount;
+					}
+				}
+			}
+		}
+
+		return editCount;
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// Primitive methods.
+	//-----------------------------------------------------------------------------------------------
+
+	void CVoxelBrush::AddStamp(const Math::Vector3& point)
+	{
+		Math::Vector3 extents;
+		switch(m_data.shape)
+		{
+			case Shape::Box:
+				extents = m_data.halfSize;
+				break;
+			case Shape::Cylinder:
+				extents = Math::Vector3(m_data.radius, m_data.height * 0.5f, m_data.radius);
+				break;
+			default:
+				extents = m_data.radius;
+				break;
+		}
+
+		Prim prim;
+		prim.a = prim.b = point;
+		prim.mn = point - extents;
+		prim.mx = point + extents;
+		m_pendingList.push_back(prim);
+
+		for(int n = 0; n < 3; ++n)
+		{
+			m_boundsMin[n] = min(m_boundsMin[n], prim.mn[n]);
+			m_boundsMax[n] = max(m_boundsMax[n], prim.mx[n]);
+		}
+	}
+
+	void CVoxelBrush::AddSegment(const Math::Vector3& a, const Math::Vector3& b)
+	{
+		Prim prim;
+		prim.a = a;
+		prim.b = b;
+
+		for(int n = 0; n < 3; ++n)
+		{
+			prim.mn[n] = min(a[n], b[n]) - m_data.radius;
+			prim.mx[n] = max(a[n], b[n]) + m_data.radius;
+			m_boundsMin[n] = min(m_boundsMin[n], prim.mn[n]);
+			m_boundsMax[n] = max(m_boundsMax[n], prim.mx[n]);
+		}
+
+		m_pendingList.push_back(prim);
+	}
+
+	// Method for tessellating a Catmull-Rom span between p1 and p2 into capsule segments.
+	void CVoxelBrush::AddSpline(const Math::Vector3& p0, const Math::Vector3& p1, const Math::Vector3& p2, const Math::Vector3& p3)
+	{
+		const float len = (p2 - p1).Length();
+		const u32 steps = Math::Clamp(static_cast<int>(ceilf(len / max(m_data.radius * 0.5f, 0.5f))), 1, static_cast<int>(MAX_SPLINE_STEPS));
+
+		auto Evaluate = [&](float t) {
+			const float t2 = t * t;
+			const float t3 = t2 * t;
+			return (p1 * 2.0f + (p2 - p0) * t + (p0 * 2.0f - p1 * 5.0f + p2 * 4.0f - p3) * t2 + (p1 * 3.0f - p0 - p2 * 3.0f + p3) * t3) * 0.5f;
+		};
+
+		Math::Vector3 last = p1;
+		for(u32 i = 1; i <= steps; ++i)
+		{
+			const Math::Vector3 next = Evaluate(static_cast<float>(i) / steps);
+			AddSegment(last, next);
+			last = next;
+		}
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// SIMD tests.
+	//-----------------------------------------------------------------------------------------------
+
+	// Method for testing four blocks of a column against a primitive. Returns an all-ones lane for every block center inside.
+	vf32 CVoxelBrush::InsideMask(const Prim& prim, float x, vf32 y, float z) const
+	{
+		const vf32 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+		const vf32 dx = _mm_set1_ps(x - prim.a.x);
+		const vf32 dy = _mm_sub_ps(y, _mm_set1_ps(prim.a.y));
+		const vf32 dz = _mm_set1_ps(z - prim.a.z);
+		const vf32 r2 = _mm_set1_ps(m_data.radius * m_data.radius);
+
+		switch(m_data.shape)
+		{
+			case Shape::Sphere:
+			{
+				const vf32 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+				return _mm_cmple_ps(d2, r2);
+			}
+			case Shape::Box:
+			{
+				vf32 res = _mm_cmple_ps(_mm_and_ps(dx, absMask), _mm_set1_ps(m_data.halfSize.x));
+				res = _mm_and_ps(res, _mm_cmple_ps(_mm_and_ps(dy, absMask), _mm_set1_ps(m_data.halfSize.y)));
+				return _mm_and_ps(res, _mm_cmple_ps(_mm_and_ps(dz, absMask), _mm_set1_ps(m_data.halfSize.z)));
+			}
+			case Shape::Cylinder:
+			{
+				const vf32 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dz, dz));
+				return _mm_and_ps(_mm_cmple_ps(d2, r2), _mm_cmple_ps(_mm_and_ps(dy, absMask), _mm_set1_ps(m_data.height * 0.5f)));
+			}
+			default:
+			{ // Capsule segment.
+				const Math::Vector3 ab = prim.b - prim.a;
+				const float abLenSq = ab.LengthSq();
+
+				vf32 t = _mm_setzero_ps();
+				if(abLenSq > 1e-6f)
+				{
+					t = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, _mm_set1_ps(ab.x)), _mm_mul_ps(dy, _mm_set1_ps(ab.y))), _mm_mul_ps(dz, _mm_set1_ps(ab.z)));
+					t = _mm_mul_ps(t, _mm_set1_ps(1.0f / abLenSq));
+					t = _mm_min_ps(_mm_max_ps(t, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+				}
+
+				const vf32 ex = _mm_sub_ps(dx, _mm_mul_ps(t, _mm_set1_ps(ab.x)));
+				const vf32 ey = _mm_sub_ps(dy, _mm_mul_ps(t, _mm_set1_ps(ab.y)));
+				const vf32 ez = _mm_sub_ps(dz, _mm_mul_ps(t, _mm_set1_ps(ab.z)));
+				const vf32 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey)), _mm_mul_ps(ez, ez));
+				return _mm_cmple_ps(d2, r2);
+			}
+		}
+	}
+
+	// Method for evaluating 3D value noise for four blocks of a column. Returns an all-ones lane where the noise passes the threshold.
+	vf32 CVoxelBrush::NoiseMask(float x, vf32 y, float z) const
+	{
+		const vf32 scale = _mm_set1_ps(m_data.noiseScale);
+		const vf32 px = _mm_mul_ps(_mm_set1_ps(x), scale);
+		const vf32 py = _mm_mul_ps(y, scale);
+		const vf32 pz = _mm_mul_ps(_mm_set1_ps(z), scale);
+
+		const vf32 fx = _mm_floor_ps(px);
+		const vf32 fy = _mm_floor_ps(py);
+		const vf32 fz = _mm_floor_ps(pz);
+
+		auto Fade = [](vf32 t) {
+			return _mm_mul_ps(_mm_mul_ps(t, t), _mm_sub_ps(_mm_set1_ps(3.0f), _mm_mul_ps(_mm_set1_ps(2.0f), t)));
+		};
+
+		const vf32 tx = Fade(_mm_sub_ps(px, fx));
+		const vf32 ty = Fade(_mm_sub_ps(py, fy));
+		const vf32 tz = Fade(_mm_sub_ps(pz, fz));
+
+		const __m128i ix = _mm_cvtps_epi32(fx);
+		const __m128i iy = _mm_cvtps_epi32(fy);
+		const __m128i iz = _mm_cvtps_epi32(fz);
+		const __m128i one = _mm_set1_epi32(1);
+		const __m128i seed = _mm_set1_epi32(static_cast<int>(m_data.noiseSeed));
+
+		auto Hash = [&](__m128i hx, __m128i hy, __m128i hz) {
+			__m128i h = _mm_xor_si128(seed, _mm_mullo_epi32(hx, _mm_set1_epi32(0x27D4EB2D)));
+			h = _mm_xor_si128(h, _mm_mullo_epi32(hy, _mm_set1_epi32(0x165667B1)));
+			h = _mm_xor_si128(h, _mm_mullo_epi32(hz, _mm_set1_epi32(static_cast<int>(0x9E3779B1))));
+			h = _mm_mullo_epi32(_mm_xor_si128(h, _mm_srli_epi32(h, 15)), _mm_set1_epi32(0x2C1B3C6D));
+			h = _mm_mullo_epi32(_mm_xor_si128(h, _mm_srli_epi32(h, 12)), _mm_set1_epi32(0x297A2D39));
+			h = _mm_xor_si128(h, _mm_srli_epi32(h, 15));
+			return _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(h, 8)), _mm_set1_ps(1.0f / 16777216.0f));
+		};
+
+		auto Lerp = [](vf32 a, vf32 b, vf32 t) {
+			return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+		};
+
+		const __m128i ix1 = _mm_add_epi32(ix, one);
+		const __m128i iy1 = _mm_add_epi32(iy, one);
+		const __m128i iz1 = _mm_add_epi32(iz, one);
+
+		const vf32 x00 = Lerp(Hash(ix, iy, iz), Hash(ix1, iy, iz), tx);
+		const vf32 x10 = Lerp(Hash(ix, iy1, iz), Hash(ix1, iy1, iz), tx);
+		const vf32 x01 = Lerp(Hash(ix, iy, iz1), Hash(ix1, iy, iz1), tx);
+		const vf32 x11 = Lerp(Hash(ix, iy1, iz1), Hash(ix1, iy1, iz1), tx);
+
+		const vf32 noise = Lerp(Lerp(x00, x10, ty), Lerp(x01, x11, ty), tz);
+		return _mm_cmpge_ps(noise, _mm_set1_ps(m_data.noiseThreshold));
+	}
+};
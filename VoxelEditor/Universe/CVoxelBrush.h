@@ -0,0 +1,121 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Copyright (c) Ryan Alasandro
+//
+// Application: Voxel Editor
+//
+// File: Universe/CVoxelBrush.h
+//
+//-------------------------------------------------------------------------------------------------
+
+#ifndef CVOXELBRUSH_H
+#define CVOXELBRUSH_H
+
+#include "CNodeChunk.h"
+#include <Globals/CGlobals.h>
+#include <Math/CMathVector3.h>
+#include <vector>
+
+namespace Universe
+{
+	class CVoxelBrush
+	{
+	public:
+		enum class Shape : u8
+		{
+			Sphere,
+			Box,
+			Cylinder,
+			Line,
+			Spline,
+		};
+
+		enum class Mode : u8
+		{
+			Union,
+			Subtract,
+			Paint,
+		};
+
+		struct Data
+		{
+			Shape shape = Shape::Sphere;
+			Mode mode = Mode::Union;
+			u16 id = 1;
+
+			float radius = 2.0f;
+			float height = 4.0f;
+			Math::Vector3 halfSize = 2.0f;
+
+			// A noise scale of zero disables the noise mask.
+			float noiseScale = 0.0f;
+			float noiseThreshold = 0.5f;
+			u32 noiseSeed = 0;
+
+			bool bSmooth = false;
+		};
+
+	private:
+		// Rasterization primitive. Stamps only use 'a', segments use both.
+		struct Prim
+		{
+			Math::Vector3 a;
+			Math::Vector3 b;
+			Math::Vector3 mn;
+			Math::Vector3 mx;
+		};
+
+	public:
+		CVoxelBrush();
+		~CVoxelBrush();
+		CVoxelBrush(const CVoxelBrush&) = delete;
+		CVoxelBrush(CVoxelBrush&&) = delete;
+		CVoxelBrush& operator = (const CVoxelBrush&) = delete;
+		CVoxelBrush& operator = (CVoxelBrush&&) = delete;
+
+		void Begin(const Math::Vector3& point, const Math::Vector3& normal);
+		void AddPoint(const Math::Vector3& point);
+		void Apply(CNodeChunk* const* ppChunkList, u32 chunkCount);
+		void End();
+
+		u32 Rasterize(const CNodeChunk::Block* pBlockList, const CNodeChunk::Data& chunkData, const Math::Vector3& origin,
+			std::vector<CNodeChunk::BlockUpdateData>& editList);
+
+		// Accessors.
+		inline const Data& GetData() const { return m_data; }
+		inline bool IsActive() const { return !m_pointList.empty(); }
+		inline const Math::Vector3& GetLastPoint() const { return m_pointList.back(); }
+
+		// Modifiers.
+		inline void SetData(const Data& data) { m_data = data; }
+		inline void SetMode(Mode mode) { m_data.mode = mode; }
+
+	private:
+		void AddStamp(const Math::Vector3& point);
+		void AddSegment(const Math::Vector3& a, const Math::Vector3& b);
+		void AddSpline(const Math::Vector3& p0, const Math::Vector3& p1, const Math::Vector3& p2, const Math::Vector3& p3);
+
+		vf32 InsideMask(const Prim& prim, float x, vf32 y, float z) const;
+		vf32 NoiseMask(float x, vf32 y, float z) const;
+
+	private:
+		Data m_data;
+
+		Math::Vector3 m_boundsMin;
+		Math::Vector3 m_boundsMax;
+
+		// Plane the stroke is held to, through its first point. Keeps a held stroke from climbing its own edits.
+		Math::Vector3 m_planeNormal;
+
+		std::vector<Math::Vector3> m_pointList;
+		std::vector<Prim> m_pendingList;
+
+		// Scratch buffers kept between strokes so sculpting doesn't allocate per frame.
+		std::vector<u16> m_srcList;
+		std::vector<u16> m_dstList;
+		std::vector<u8> m_maskList;
+		std::vector<const Prim*> m_columnList;
+	};
+};
+
+#endif
@@ -0,0 +1,229 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Copyright (c) Ryan Alasandro
+//
+// Application: Voxel Editor
+//
+// File: Universe/CVoxelRegion.cpp
+//
+//-------------------------------------------------------------------------------------------------
+
+#include "CVoxelRegion.h"
+#include <Utilities/CJobSystem.h>
+#include <minmax.h>
+
+namespace Universe
+{
+	CVoxelRegion::CVoxelRegion() :
+		m_chunkData{} {
+	}
+
+	CVoxelRegion::~CVoxelRegion() { }
+
+	// Method for labeling every connected component of a chunk.
+	// The chunk is split into slabs along its width which are labeled in parallel, then stitched together along the slab faces.
+	void CVoxelRegion::Build(const CNodeChunk& chunk)
+	{
+		chunk.CopyBlockIds(m_idList, m_chunkData);
+
+		const u32 total = m_chunkData.width * m_chunkData.height * m_chunkData.length;
+		m_parentList.resize(total);
+		m_labelList.resize(total);
+		m_regionList.clear();
+
+		if(total == 0) { return; }
+
+		const u32 slabCount = min(max(m_data.slabCount, 1U), m_chunkData.width);
+		const u32 slabWidth = (m_chunkData.width + slabCount - 1) / slabCount;
+		const u32 slice = m_chunkData.length * m_chunkData.height;
+
+		// Slabs keep their fixed width since the stitching below relies on it, so the job system splits slab indices.
+		auto RunSlabs = [&](void (CVoxelRegion::*pMethod)(u32, u32)) {
+			const u32 runCount = (m_chunkData.width + slabWidth - 1) / slabWidth;
+			Util::CJobSystem::Instance().ParallelFor(0, runCount, 1, [&](u32 begin, u32 end){
+				for(u32 s = begin; s < end; ++s)
+				{
+					(this->*pMethod)(s * slabWidth, min((s + 1) * slabWidth, m_chunkData.width));
+				}
+			});
+		};
+
+		RunSlabs(&CVoxelRegion::LabelSlab);
+
+		// Stitch the slab faces.
+		for(u32 i0 = slabWidth; i0 < m_chunkData.width; i0 += slabWidth)
+		{
+			for(u32 index = i0 * slice; index < (i0 + 1) * slice; ++index)
+			{
+				if(Connected(index, index - slice))
+				{
+					Union(index, index - slice);
+				}
+			}
+		}
+
+		RunSlabs(&CVoxelRegion::ResolveSlab);
+
+		// Compact the roots into region indices. Unions always keep the lowest index as the root, so a root is visited before the rest of its component.
+		for(u32 index = 0; index < total; ++index)
+		{
+			const u32 root = m_labelList[index];
+			if(root == INVALID_REGION) { continue; }
+
+			if(root == index)
+			{
+				m_parentList[index] = static_cast<u32>(m_regionList.size());
+				m_regionList.push_back({ m_idList[index], 0, false });
+			}
+
+			const u32 regionIndex = m_parentList[root];
+			m_labelList[index] = regionIndex;
+
+			Region& region = m_regionList[regionIndex];
+			++region.count;
+			region.bGrounded |= (index % m_chunkData.height) == m_chunkData.height - 1;
+		}
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// Query methods.
+	//-----------------------------------------------------------------------------------------------
+
+	// Method for gathering every block in the same region as the given block. Returns the number of blocks added.
+	u32 CVoxelRegion::Select(u32 blockIndex, std::vector<u32>& blockIndexList) const
+	{
+		const u32 regionIndex = m_labelList[blockIndex];
+		if(regionIndex == INVALID_REGION) { return 0; }
+
+		blockIndexList.reserve(blockIndexList.size() + m_regionList[regionIndex].count);
+
+		const u32 total = static_cast<u32>(m_labelList.size());
+		for(u32 index = 0; index < total; ++index)
+		{
+			if(m_labelList[index] == regionIndex)
+			{
+				blockIndexList.push_back(index);
+			}
+		}
+
+		return m_regionList[regionIndex].count;
+	}
+
+	// Method for gathering every block whose region doesn't reach the bottom of the chunk. Returns the number of blocks added.
+	u32 CVoxelRegion::FindFloating(std::vector<u32>& blockIndexList) const
+	{
+		u32 count = 0;
+		for(const Region& region : m_regionList)
+		{
+			if(!region.bGrounded) { count += region.count; }
+		}
+
+		if(count == 0) { return 0; }
+
+		blockIndexList.reserve(blockIndexList.size() + count);
+
+		const u32 total = static_cast<u32>(m_labelList.size());
+		for(u32 index = 0; index < total; ++index)
+		{
+			const u32 regionIndex = m_labelList[index];
+			if(regionIndex != INVALID_REGION && !m_regionList[regionIndex].bGrounded)
+			{
+				blockIndexList.push_back(index);
+			}
+		}
+
+		return count;
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// Slab methods.
+	//-----------------------------------------------------------------------------------------------
+
+	// Method for labeling a slab. Unions never leave the slab, so slabs can run concurrently.
+	void CVoxelRegion::LabelSlab(u32 i0, u32 i1)
+	{
+		const u32 slice = m_chunkData.length * m_chunkData.height;
+		const u32 begin = i0 * slice;
+		const u32 end = i1 * slice;
+
+		for(u32 index = begin; index < end; ++index)
+		{
+			m_parentList[index] = m_idList[index] ? index : INVALID_REGION;
+		}
+
+		u32 index = begin;
+		for(u32 i = i0; i < i1; ++i)
+		{
+			for(u32 k = 0; k < m_chunkData.length; ++k)
+			{
+				for(u32 c = 0; c < m_chunkData.height; ++c, ++index)
+				{
+					if(m_idList[index] == 0) { continue; }
+
+					if(c > 0 && Connected(index, index - 1)) { Union(index, index - 1); }
+					if(k > 0 && Connected(index, index - m_chunkData.height)) { Union(index, index - m_chunkData.height); }
+					if(i > i0 && Connected(index, index - slice)) { Union(index, index - slice); }
+				}
+			}
+		}
+	}
+
+	// Method for resolving every block of a slab to its root. Only reads the parent list, so slabs can run concurrently.
+	void CVoxelRegion::ResolveSlab(u32 i0, u32 i1)
+	{
+		const u32 slice = m_chunkData.length * m_chunkData.height;
+		const u32 end = i1 * slice;
+
+		for(u32 index = i0 * slice; index < end; ++index)
+		{
+			u32 root = m_parentList[index];
+			if(root != INVALID_REGION)
+			{
+				while(m_parentList[root] != root)
+				{
+					root = m_parentList[root];
+				}
+			}
+
+			m_labelList[index] = root;
+		}
+	}
+
+	//-----------------------------------------------------------------------------------------------
+	// Union-find methods.
+	//-----------------------------------------------------------------------------------------------
+
+	u32 CVoxelRegion::Find(u32 index)
+	{
+		while(m_parentList[index] != index)
+		{
+			m_parentList[index] = m_parentList[m_parentList[index]];
+			index = m_parentList[index];
+		}
+
+		return index;
+	}
+
+	void CVoxelRegion::Union(u32 a, u32 b)
+	{
+		const u32 rootA = Find(a);
+		const u32 rootB = Find(b);
+		if(rootA == rootB) { return; }
+
+		// Keep the lowest index as the root.
+		if(rootA < rootB)
+		{
+			m_parentList[rootB] = rootA;
+		}
+		else
+		{
+			m_parentList[rootA] = rootB;
+		}
+	}
+
+	bool CVoxelRegion::Connected(u32 a, u32 b) const
+	{
+		if(m_idList[a] == 0 || m_idList[b] == 0) { return false; }
+		return m_data.connectivity == Connectivity::Solid || m_idList[a] == m_idList[b];
+	}
+};
@@ -0,0 +1,87 @@
+//-------------------------------------------------------------------------------------------------
+//
+// Copyright (c) Ryan Alasandro
+//
+// Application: Voxel Editor
+//
+// File: Universe/CVoxelRegion.h
+//
+//-------------------------------------------------------------------------------------------------
+
+#ifndef CVOXELREGION_H
+#define CVOXELREGION_H
+
+#include "CNodeChunk.h"
+#include <Globals/CGlobals.h>
+#include <vector>
+
+namespace Universe
+{
+	class CVoxelRegion
+	{
+	public:
+		static const u32 INVALID_REGION = ~0U;
+
+		enum class Connectivity : u8
+		{
+			Id, // Neighbors connect when they share a block id.
+			Solid, // Neighbors connect when both are solid.
+		};
+
+		struct Data
+		{
+			Connectivity connectivity = Connectivity::Id;
+
+			// Number of slabs the chunk is split into along its width. Slabs are labeled and resolved through the job system's
+			//  ParallelFor, one slab per task, and stitched on the calling thread in between.
+			u32 slabCount = 5;
+		};
+
+		struct Region
+		{
+			u16 id; // Id of the region's first block.
+			u32 count;
+			bool bGrounded; // Touches the bottom layer of the chunk.
+		};
+
+	public:
+		CVoxelRegion();
+		~CVoxelRegion();
+		CVoxelRegion(const CVoxelRegion&) = delete;
+		CVoxelRegion(CVoxelRegion&&) = delete;
+		CVoxelRegion& operator = (const CVoxelRegion&) = delete;
+		CVoxelRegion& operator = (CVoxelRegion&&) = delete;
+
+		void Build(const CNodeChunk& chunk);
+
+		u32 Select(u32 blockIndex, std::vector<u32>& blockIndexList) const;
+		u32 FindFloating(std::vector<u32>& blockIndexList) const;
+
+		// Accessors.
+		inline u32 GetRegionIndex(u32 blockIndex) const { return m_labelList[blockIndex]; }
+		inline u32 GetRegionCount() const { return static_cast<u32>(m_regionList.size()); }
+		inline const Region& GetRegion(u32 regionIndex) const { return m_regionList[regionIndex]; }
+
+		// Modifiers.
+		inline void SetData(const Data& data) { m_data = data; }
+
+	private:
+		void LabelSlab(u32 i0, u32 i1);
+		void ResolveSlab(u32 i0, u32 i1);
+
+		u32 Find(u32 index);
+		void Union(u32 a, u32 b);
+		bool Connected(u32 a, u32 b) const;
+
+	private:
+		Data m_data;
+		CNodeChunk::Data m_chunkData;
+
+		std::vector<u16> m_idList;
+		std::vector<u32> m_parentList;
+		std::vector<u32> m_labelList;
+		std::vector<Region> m_regionList;
+	};
+};
+
+#endif